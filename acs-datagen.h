@@ -5,7 +5,21 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
 #include "bessel.h"
+#include "ring.h"
+#include "filterbank.h"
+#include "winstats.h"
+#include "dynamics.h"
+#include "orbit.h"
+#include "magfield.h"
+#include "sun.h"
+#include "sensorsched.h"
+#include "fault.h"
+#include "config.h"
+#include "batch.h"
 
 /**
  * @brief This variable is unset by the ACS thread at first execution.
@@ -17,17 +31,23 @@ volatile int first_run = 1;
  * @brief Creates buffer for \f$\vec{\omega}\f$.
  * 
  */
-DECLARE_BUFFER(g_W, float); // omega global circular buffer
+DECLARE_RING(g_W, float); // omega global circular buffer
 /**
  * @brief Creates buffer for \f$\vec{B}\f$.
  * 
  */
-DECLARE_BUFFER(g_B, double); // magnetic field global circular buffer
+DECLARE_RING(g_B, double); // magnetic field global circular buffer
 /**
  * @brief Creates buffer for \f$\vec{\dot{B}}\f$.
  * 
  */
-DECLARE_BUFFER(g_Bt, double); // Bdot global circular buffer1
+DECLARE_RING(g_Bt, double); // Bdot global circular buffer1
+/**
+ * @brief \f$\vec{\dot{B}}\f$ the detumble controller acts on: the derivative of the filtered field, without the B-dot
+ * filter. The lag of the B-dot filter on top of that of the field filter turns B-dot into a spin-up above ~0.25 rad/s.
+ * 
+ */
+DECLARE_VECTOR(g_Bt_ctl, double); // Bdot for control
 /**
  * @brief Creates vector for target angular momentum.
  * 
@@ -42,7 +62,12 @@ DECLARE_VECTOR(g_W_target, float); // angular velocity target vector
  * @brief Creates buffer for sun vector.
  * 
  */
-DECLARE_BUFFER(g_S, float); // sun vector
+DECLARE_RING(g_S, float); // sun vector
+/**
+ * @brief Storage of the circular buffers, sized for their capacity by initBuffers().
+ * 
+ */
+arena_t g_arena;
 /**
  * @brief Storage for current coarse sun sensor lux measurements.
  * 
@@ -64,253 +89,1588 @@ float g_FSS[2]; // current FSS angles, in rad; in HITL this will be populated by
  */
 int g_FSS_RET; // return value of FSS
 /**
- * @brief Current index of the \f$\vec{B}\f$ circular buffer.
+ * @brief This variable is set by checkTransition() if the satellite does not detect the sun.
  * 
  */
-int mag_index = -1;
+uint8_t g_night = 0; // night mode?
 /**
- * @brief Current index of the \f$\vec{\omega}\f$ circular buffer.
+ * @brief This variable contains the current state of the flight system.
  * 
  */
-int omega_index = -1;
+uint8_t g_acs_mode = 0; // Detumble by default
 /**
- * @brief Current index of the \f$\vec{\dot{B}}\f$ circular buffer.
+ * @brief This variable is unset when the system is detumbled for the first time after a power cycle.
  * 
  */
-int bdot_index = -1;
+uint8_t g_first_detumble = 1; // first time detumble by default even at night
 /**
- * @brief Current index of the sun vector circular buffer.
+ * @brief Counts the number of cycles on the ACS thread.
  * 
  */
-int sol_index = -1; // circular buffer indices, -1 indicates uninitiated buffer
+unsigned long long acs_ct = 0; // counts the number of ACS steps
 /**
- * @brief Indicates if the \f$\vec{B}\f$ circular buffer is full.
+ * @brief Moment of inertia of the satellite (SI).
  * 
  */
-int B_full = 0;
+float MOI[3][3] = {{0.0821, 0, 0},
+                   {0, 0.0752, 0},
+                   {0, 0, 0.0874}};
 /**
- * @brief Indicates if the \f$\vec{\dot{B}}\f$ circular buffer is full.
+ * @brief Inverse of the moment of inertia of the satellite (SI), computed from MOI at first execution.
  * 
  */
-int Bdot_full = 0;
+float IMOI[3][3];
 /**
- * @brief Indicates if the \f$\vec{\omega}\f$ circular buffer is full.
+ * @brief Current timestamp after readSensors() in ACS thread, used to keep track of time taken by ACS loop.
  * 
  */
-int W_full = 0;
+unsigned long long g_t_acs;
+
 /**
- * @brief Indicates if the sun vector circular buffer is full.
+ * @brief Dipole moment of the magnetorquer rods
  * 
  */
-int S_full = 0; // required to deal with the circular buffer problem
+static float DIPOLE_MOMENT = 0.22; // A m^-2
 /**
- * @brief This variable is set by checkTransition() if the satellite does not detect the sun.
+ * @brief Proportional gain of the B-dot controller
  * 
  */
-uint8_t g_night = 0; // night mode?
+static float BDOT_GAIN = 0.01; // A m^2 per mG s^-1
 /**
- * @brief This variable contains the current state of the flight system.
+ * @brief Rate below which the satellite is considered detumbled
  * 
  */
-uint8_t g_acs_mode = 0; // Detumble by default
+static float DETUMBLE_THRESHOLD = 0.0175; // rad s^-1, 1 deg s^-1
 /**
- * @brief This variable is unset when the system is detumbled for the first time after a power cycle.
+ * @brief RMS jitter of the sun vector over the statistics window below which the sun is considered locked
  * 
  */
-uint8_t g_first_detumble = 1; // first time detumble by default even at night
+static float SUNLOCK_THRESHOLD = 0.035; // rad, 2 deg
 /**
- * @brief Counts the number of cycles on the ACS thread.
+ * @brief Commanded magnetorquer dipole moment in the body frame (A m^2).
  * 
  */
-unsigned long long acs_ct = 0; // counts the number of ACS steps
+DECLARE_VECTOR(g_M, float); // magnetorquer command
 /**
- * @brief Moment of inertia of the satellite (SI).
+ * @brief Simulation time (s), advanced by DETUMBLE_TIME_STEP in every readSensors() call.
  * 
  */
-float MOI[3][3] = {{0.0821, 0, 0},
-                   {0, 0.0752, 0},
-                   {0, 0, 0.0874}};
+double g_tnow = 0;
 /**
- * @brief Inverse of the moment of inertia of the satellite (SI).
+ * @brief Simulation time (s) at which the true angular rate first fell below DETUMBLE_THRESHOLD, -1 if not yet detumbled.
  * 
  */
-float IMOI[3][3] = {{12.1733, 0, 0},
-                    {0, 13.2941, 0},
-                    {0, 0, 11.4661}};
+double g_detumble_time = -1;
 /**
- * @brief Current timestamp after readSensors() in ACS thread, used to keep track of time taken by ACS loop.
+ * @brief Simulation time (s) at which the ACS first found itself detumbled from its omega estimate, see acsDetumbled(), -1 if not yet.
  * 
  */
-unsigned long long g_t_acs;
-
+double g_detumble_est_time = -1;
 /**
- * @brief Dipole moment of the magnetorquer rods
+ * @brief Simulation time (s) at which the sun vector first locked, see acsSunLocked(), -1 if not yet.
  * 
  */
-static float DIPOLE_MOMENT = 0.22; // A m^-2
+double g_sunlock_time = -1;
 /**
  * @brief ACS loop time period
  * 
  */
 static uint32_t DETUMBLE_TIME_STEP = 100000; // 100 ms for full loop
+/**
+ * @brief True attitude and angular velocity of the simulated satellite, propagated by readSensors().
+ * 
+ */
+dyn_state_t g_dyn = {.q = {1, 0, 0, 0}, .w = {0.2, -0.1, 0.3}, .h = 0}; // tumbling at start
+/**
+ * @brief Rigid-body parameters of the simulated satellite, initialized from MOI and IMOI at first execution.
+ * 
+ */
+dyn_params_t g_dyn_params;
+/**
+ * @brief Integrator used to propagate the attitude.
+ * 
+ */
+dyn_integrator g_dyn_integrator = DYN_RK4;
+/**
+ * @brief Number of fixed integrator steps per ACS loop period.
+ * 
+ */
+int g_dyn_substeps = DYNAMICS_SUBSTEPS;
+/**
+ * @brief External torque, magnetorquer dipole and inertial field acting on the satellite over the current loop period.
+ * 
+ */
+dyn_input_t g_dyn_input;
+/**
+ * @brief Orbital elements of the simulated satellite at the start of the simulation.
+ * 
+ */
+orbit_elements_t g_orbit_elements = ORBIT_DEFAULT_ELEMENTS;
+/**
+ * @brief Current position and velocity of the simulated satellite (ECI).
+ * 
+ */
+orbit_state_t g_orbit;
+/**
+ * @brief Cached ephemeris of the orbit, starting at g_orbit_elements. If set, the orbit is interpolated
+ * from this table instead of being propagated; the table may be shared by many simulations.
+ * 
+ */
+const orbit_ephem_t *g_ephem = NULL;
+/**
+ * @brief Magnetic field in the inertial frame at the current position (mG).
+ * 
+ */
+double g_B_I[3] = {0, 0, 0};
+/**
+ * @brief Geomagnetic field model, loaded from FIELD_COEF_FILE on the first step (tilted dipole if the file is
+ * missing). Kept across resetSim(), along with any lookup grid built on it.
+ * 
+ */
+field_model_t g_field;
+/**
+ * @brief Julian date at the start of the simulation (UT1), sets the rotation of the Earth under the orbit.
+ * 
+ */
+double g_epoch_jd = 2459000.5; // 2020-05-31 00:00 UT
+/**
+ * @brief Sun direction in the inertial frame (unit vector), updated with each eclipse prediction.
+ * 
+ */
+double g_S_I[3] = {1, 0, 0};
+/**
+ * @brief Earth shadow model used to light the coarse sun sensors.
+ * 
+ */
+sun_shadow_model g_shadow_model = SUN_SHADOW_CONICAL;
+/**
+ * @brief Eclipse prediction covering the current step, redone once per orbit (at each eclipse exit).
+ * 
+ */
+sun_eclipse_t g_eclipse = {.t_end = -1};
+/**
+ * @brief Fraction of the solar disk visible from the satellite, 0 (umbra) ... 1 (full sun).
+ * 
+ */
+double g_sun_frac = 1;
+/**
+ * @brief Uniform noise amplitude (peak to peak) of the simulated magnetometer (mG).
+ * 
+ */
+#define MAG_NOISE 5
+/**
+ * @brief Coarse sun sensor reading under full, normal incidence sun (lux).
+ * 
+ */
+#define CSS_MAX_LUX 7000
+/**
+ * @brief Uniform noise amplitude (peak to peak) of the simulated coarse sun sensors (lux).
+ * 
+ */
+#define CSS_NOISE 100
+/**
+ * @brief Outward normals of the coarse sun sensors in the body frame, in g_CSS order: +X, -X, +Y, -Y, +Z, -Z, -Z.
+ * 
+ */
+static const double CSS_NORMAL[7][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0, 0, -1}};
+/**
+ * @brief Half angle of the fine sun sensor field of view, about its +Z boresight (rad).
+ * 
+ */
+#define FSS_FOV (60 * M_PI / 180)
+/**
+ * @brief Uniform noise amplitude (peak to peak) of the simulated fine sun sensor angles (rad).
+ * 
+ */
+#define FSS_NOISE (0.5 * M_PI / 180)
+/**
+ * @brief Fraction of the solar disk the fine sun sensor needs to see to detect the sun.
+ * 
+ */
+#define FSS_MIN_SUN 0.5
+/**
+ * @brief Fine sun sensor return codes, as reported by the NANOSSOC A60.
+ * 
+ */
+#define FSS_OK 0          // valid measurement
+#define FSS_NO_SUN 11     // not enough light, eclipse
+#define FSS_OUT_OF_FOV 13 // sun outside the field of view
 
-void getOmega(void)
+/**
+ * @brief Sampling period of the magnetometer (usec).
+ * 
+ */
+#ifndef MAG_PERIOD
+#define MAG_PERIOD 100000
+#endif
+/**
+ * @brief Delay from magnetometer sampling to data availability (usec).
+ * 
+ */
+#ifndef MAG_LATENCY
+#define MAG_LATENCY 0
+#endif
+/**
+ * @brief Sampling period of the coarse sun sensors (usec).
+ * 
+ */
+#ifndef CSS_PERIOD
+#define CSS_PERIOD 200000
+#endif
+/**
+ * @brief Delay from coarse sun sensor sampling to data availability, the TSL2561 integration time (usec).
+ * 
+ */
+#ifndef CSS_LATENCY
+#define CSS_LATENCY 100000
+#endif
+/**
+ * @brief Sampling period of the fine sun sensor (usec).
+ * 
+ */
+#ifndef FSS_PERIOD
+#define FSS_PERIOD 200000
+#endif
+/**
+ * @brief Delay from fine sun sensor sampling to data availability (usec).
+ * 
+ */
+#ifndef FSS_LATENCY
+#define FSS_LATENCY 0
+#endif
+/**
+ * @brief Oldest fine sun sensor sample getSVec() still prefers over the coarse sun sensors (usec).
+ * 
+ */
+#define FSS_MAX_AGE (2 * FSS_PERIOD)
+/**
+ * @brief Sampling schedules of the magnetometer, coarse sun sensors and fine sun sensor.
+ * 
+ */
+sensorsched_t g_mag_sched, g_css_sched, g_fss_sched;
+/**
+ * @brief Sensor samples taken but not yet delivered to the control loop.
+ * 
+ */
+double g_mag_sample[3];
+float g_css_sample[7];
+float g_fss_sample[2];
+int g_fss_sample_ret;
+/**
+ * @brief Interval between the two latest magnetometer samples (usec).
+ * 
+ */
+uint32_t g_mag_dt = MAG_PERIOD;
+/**
+ * @brief State of the sensor noise generator (xorshift64*). Unlike the state of rand(), it can be saved
+ * in a checkpoint and restored.
+ * 
+ */
+uint64_t g_rng = 0x9E3779B97F4A7C15ULL;
+
+/**
+ * @brief Seeds the sensor noise generator.
+ * 
+ * @param seed Seed, any value
+ */
+static inline void seedRand(uint64_t seed)
 {
-    if (mag_index < 2 && B_full == 0) // not enough measurements
-        return;
-    // once we have measurements, we declare that we proceed
-    if (omega_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
-        W_full = 1;
-    omega_index = (1 + omega_index) % SH_BUFFER_SIZE;                             // calculate new index in the circular buffer
-    int8_t m0, m1;                                                                // temporary addresses
-    m1 = bdot_index;                                                              // current address
-    m0 = (bdot_index - 1) < 0 ? SH_BUFFER_SIZE - bdot_index - 1 : bdot_index - 1; // previous address, wrapped around the circular buffer
-    float freq;
-    freq = 1e6 / DETUMBLE_TIME_STEP;                     // time units!
-    CROSS_PRODUCT(g_W[omega_index], g_Bt[m1], g_Bt[m0]); // apply cross product
-    float norm2 = NORM2(g_Bt[m0]);
-    VECTOR_MIXED(g_W[omega_index], g_W[omega_index], freq / norm2, *); // omega = (B_t dot x B_t-dt dot)*freq/Norm2(B_t dot)
-    // Apply correction // There is fast runaway with this on
-    // DECLARE_VECTOR(omega_corr0, float);                            // declare temporary space for correction vector
-    // MATVECMUL(omega_corr0, MOI, g_W[m1]);                          // MOI X w[t-1]
-    // DECLARE_VECTOR(omega_corr1, float);                            // declare temporary space for correction vector
-    // CROSS_PRODUCT(omega_corr1, g_W[m1], omega_corr0);              // store into temp 1
-    // MATVECMUL(omega_corr1, IMOI, omega_corr0);                     // store back into temp 0
-    // VECTOR_MIXED(omega_corr1, omega_corr1, -freq, *);              // omega_corr = freq*(MOI-1)*(-w[t-1] X MOI*w[t-1])
-    // VECTOR_OP(g_W[omega_index], g_W[omega_index], omega_corr1, +); // add the correction term to omega
-    APPLY_FBESSEL(g_W, omega_index); // Bessel filter of order 3
-    return;
+    g_rng = (seed + 1) * 0x9E3779B97F4A7C15ULL; // spreads small seeds over the state
+    if (g_rng == 0)
+        g_rng = 0x9E3779B97F4A7C15ULL;
 }
 
-void getSVec(void)
+/**
+ * @brief Draws from the sensor noise generator.
+ * 
+ * @return double Uniformly distributed in [0, 1)
+ */
+static inline double simRand(void)
 {
-    if (sol_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
-        S_full = 1;
-    sol_index = (sol_index + 1) % SH_BUFFER_SIZE;
-#ifndef M_PI
+    g_rng ^= g_rng >> 12;
+    g_rng ^= g_rng << 25;
+    g_rng ^= g_rng >> 27;
+    return ((g_rng * 0x2545F4914F6CDD1DULL) >> 11) * 0x1.0p-53;
+}
+
 /**
- * @brief Approximate definition of Pi in case M_PI is not included from math.h
+ * @brief Compiled sensor fault plan, replayed by step number, NULL to run without faults.
+ * 
  */
-#define M_PI 3.1415
-#endif
-    // check if FSS results are acceptable
-    // if they are, use that to calculate the sun vector
-    // printf("[FSS] %.3f %.3f\n", fsx * 180. / M_PI, fsy * 180. / M_PI);
+fault_plan_t *g_faults = NULL;
 
-    // get average -Z luminosity from 2 sensors
-    float znavg = 0;
-    for (int i = 5; i < 7; i++)
-        znavg += g_CSS[i];
-    znavg *= 0.5f;
+/**
+ * @brief Run settings read from a scenario file by loadScenario(), besides the simulation parameters it sets directly.
+ * 
+ */
+typedef struct
+{
+    int port;             // DataVis port, 0 for the compiled default
+    unsigned int seed;    // seed of the sensor noise
+    int bessel_order;     // order of the Bessel filter
+    float bessel_cutoff;  // cutoff of the Bessel filter (samples)
+    filter_config_t filter_B;  // filter of B
+    filter_config_t filter_Bt; // filter of B-dot
+    filter_config_t filter_W;  // filter of omega
+    filter_config_t filter_S;  // filter of the sun vector
+    char coef_file[256];  // geomagnetic field coefficients
+    int field_degree;     // highest degree of the field expansion
+    char fault_file[256]; // fault script, empty for none
+    uint64_t fault_seed;  // seed of the probabilistic faults
+} scenario_t;
+/**
+ * @brief Current run settings.
+ * 
+ */
+scenario_t g_scenario = {
+    .port = 0,
+    .seed = 1,
+    .bessel_order = 3,
+    .bessel_cutoff = BESSEL_FREQ_CUTOFF,
+    .filter_B = {.type = FILTER_BESSEL},
+    .filter_Bt = {.type = FILTER_BESSEL},
+    .filter_W = {.type = FILTER_BESSEL},
+    .filter_S = {.type = FILTER_NONE},
+    .coef_file = FIELD_COEF_FILE,
+    .field_degree = FIELD_MAX_DEGREE,
+    .fault_file = "",
+    .fault_seed = 1,
+};
 
-    x_g_S[sol_index] = g_CSS[0] - g_CSS[1]; // +x - -x
-    y_g_S[sol_index] = g_CSS[2] - g_CSS[3]; // +x - -x
-    z_g_S[sol_index] = g_CSS[4] - znavg;    // +z - avg(-z)
+/**
+ * @brief Filters of B, B-dot, omega and the sun vector, set up from the scenario by initFilters().
+ * 
+ */
+filter_t g_filter_B, g_filter_Bt, g_filter_W, g_filter_S;
+/**
+ * @brief Indicates that the filters are set up for the current scenario.
+ * 
+ */
+static int filters_ready = 0;
+/**
+ * @brief Sliding-window statistics of B, B-dot, omega and the sun vector, over the last bessel_depth filtered
+ * samples. The sun vector statistics restart at every night.
+ * 
+ */
+winstat3_t g_stat_B, g_stat_Bt, g_stat_W, g_stat_S;
 
-    float css_mag = NORM(g_S[sol_index]); // norm of the CSS lux values
-#define CSS_MIN_LUX_THRESHOLD 500
-    if (css_mag < CSS_MIN_LUX_THRESHOLD) // night time logic
-    {
-        g_night = 1;
-        VECTOR_CLEAR(g_S[sol_index]); // return 0 solar vector
-#ifdef ACS_PRINT
-        printf("[" RED "FSS" RST "]");
-#endif // ACS_PRINT
-    }
-    else
-    {
-        g_night = 0;
-        NORMALIZE(g_S[sol_index], g_S[sol_index]); // return normalized sun vector
-#ifdef ACS_PRINT
-        printf("[" YLW "FSS" RST "]");
-#endif // ACS_PRINT
-    }
-    printf("[sunvec %d] %0.3f %0.3f %0.3f\n", sol_index, x_g_S[sol_index], y_g_S[sol_index], z_g_S[sol_index]);
+/**
+ * @brief Empties the statistics windows, sized to the buffer depth.
+ * 
+ */
+void initWindowStats(void)
+{
+    winstat3_init(&g_stat_B, bessel_depth);
+    winstat3_init(&g_stat_Bt, bessel_depth);
+    winstat3_init(&g_stat_W, bessel_depth);
+    winstat3_init(&g_stat_S, bessel_depth);
     return;
 }
 
-int readSensors(void)
+/**
+ * @brief Detumble-complete check, O(1): the omega estimate stayed below DETUMBLE_THRESHOLD over a full window.
+ * getOmega() measures how fast B-dot turns, not the body rate, so a rate about the B-dot direction does not show.
+ * In bench_detumble the check has not fired before the true detumble; once B-dot is at the noise floor the
+ * estimate is noise well above the threshold, so it tends to fire late or not at all.
+ * 
+ */
+static inline int acsDetumbled(void)
 {
-    // read magfield, CSS, FSS
-    static double tnow = 0;
-    if (mag_index >= 0)
-        printf("In readSensors(): acs count %llu, mag_index %d, Bx %lf By %lf Bz %lf tnow %lf...\n", acs_ct, mag_index, x_g_B[mag_index], y_g_B[mag_index], z_g_B[mag_index], tnow);
-    acs_ct++;
-    tnow += 0.1; // 0.1 seconds
-    int status = 1;
-    if (mag_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
-        B_full = 1;
-    mag_index = (mag_index + 1) % SH_BUFFER_SIZE;
-    VECTOR_CLEAR(g_B[mag_index]); // clear the current B                                                  /
-    // HITL
-    double mag_measure[3];
-    mag_measure[0] = 50 * sin(tnow * 0.5) + (((1.0 * rand()) / RAND_MAX) - 0.5); // noise
-    mag_measure[1] = 50 * cos(tnow * 0.5) + (((1.0 * rand()) / RAND_MAX) - 0.5); // noise
-    mag_measure[2] = ((1.0 * rand()) / RAND_MAX - 0.5); // noise + sine
-    // read coarse sun sensors
-    double sun_ang = sin(tnow * 0.1) * 15 + 30;
-    g_CSS[0] = 7000 * sin(sun_ang * M_PI / 180) * cos(tnow * 0.5) + ((100.0 * rand()) / RAND_MAX - 50);
-    g_CSS[1] = -g_CSS[0];
-    g_CSS[2] = 7000 * sin(sun_ang * M_PI / 180) * sin(tnow * 0.5) + ((100.0 * rand()) / RAND_MAX - 50);
-    g_CSS[3] = -g_CSS[2];
-    g_CSS[4] = 7000 * cos(sun_ang * M_PI / 180) + ((100.0 * rand()) / RAND_MAX - 50);
-    g_CSS[5] = -g_CSS[4];
-    g_CSS[6] = g_CSS[5];
-
-    DECLARE_VECTOR(mag_mes, double);
-    x_mag_mes = mag_measure[0]; // / 6.842;
-    y_mag_mes = mag_measure[1]; // / 6.842;
-    z_mag_mes = mag_measure[2]; // / 6.842;
-    DECLARE_VECTOR(mag_val, double);
-    NORMALIZE(mag_val, mag_mes);
-    VECTOR_MIXED(mag_val, mag_val, 600, *);
-    x_g_B[mag_index] = x_mag_mes; // scaled to milliGauss
-    y_g_B[mag_index] = y_mag_mes;
-    z_g_B[mag_index] = z_mag_mes;
-    APPLY_DBESSEL(g_B, mag_index); // bessel filter
-
-    // printf("readSensors: Bx: %f By: %f Bz: %f\n", x_g_B[mag_index], y_g_B[mag_index], z_g_B[mag_index]);
-    // put values into g_Bx, g_By and g_Bz at [mag_index] and takes 18 ms to do so (implemented using sleep)
-    if (mag_index < 1 && B_full == 0)
-        return status;
-    // if we have > 1 values, calculate Bdot
-    if (bdot_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
-        B_full = 1;
-    bdot_index = (bdot_index + 1) % SH_BUFFER_SIZE;
-    int8_t m0, m1;
-    m1 = mag_index;
-    m0 = (mag_index - 1) < 0 ? SH_BUFFER_SIZE - mag_index - 1 : mag_index - 1;
-    double freq = 1e6 / (DETUMBLE_TIME_STEP * 1.0);
-    VECTOR_OP(g_Bt[bdot_index], g_B[m1], g_B[m0], -);
-    VECTOR_MIXED(g_Bt[bdot_index], g_Bt[bdot_index], freq, *);
-    APPLY_DBESSEL(g_Bt, bdot_index); // bessel filter
-    // APPLY_FBESSEL(g_Bt, bdot_index); // bessel filter
-    // printf("readSensors: m0: %d m1: %d Btx: %f Bty: %f Btz: %f\n", m0, m1, x_g_Bt[bdot_index], y_g_Bt[bdot_index], z_g_Bt[bdot_index]);
-    getOmega();
-    getSVec();
-    // log data
-    // check if any of the values are NaN. If so, return -1
-    // the NaN may stem from Bdot = 0, which may stem from the fact that during sunpointing
-    // B may align itself with Z/ω
-    if (isnan(x_g_B[mag_index]))
-        return -1;
-    if (isnan(y_g_B[mag_index]))
-        return -1;
-    if (isnan(z_g_B[mag_index]))
-        return -1;
+    return winstat_full(&g_stat_W.norm) && winstat_max(&g_stat_W.norm) < DETUMBLE_THRESHOLD;
+}
 
-    if (isnan(x_g_W[omega_index]))
-        return -1;
-    if (isnan(y_g_W[omega_index]))
-        return -1;
-    if (isnan(z_g_W[omega_index]))
-        return -1;
+/**
+ * @brief Sun-lock check, O(1): a full window of daylight sun vectors whose RMS jitter is below SUNLOCK_THRESHOLD.
+ * 
+ */
+static inline int acsSunLocked(void)
+{
+    return !g_night && winstat_full(&g_stat_S.norm) && winstat3_var(&g_stat_S) < SUNLOCK_THRESHOLD * SUNLOCK_THRESHOLD;
+}
+
+/**
+ * @brief Prints the statistics of B, omega and the sun vector over the current window.
+ * 
+ * @param fp Output
+ */
+void printWindowStats(FILE *fp)
+{
+    winstat3_print(fp, "B", &g_stat_B);
+    winstat3_print(fp, "Bdot", &g_stat_Bt);
+    winstat3_print(fp, "omega", &g_stat_W);
+    winstat3_print(fp, "sun", &g_stat_S);
+    return;
+}
+
+#ifdef ACS_FIXEDPOINT
+/*
+ * Fixed-point shadow of the B, B-dot and omega pipeline, as the flight computer runs it: Q31 buffers filtered
+ * with Q15 Bessel weights, fed the same samples as the floating point pipeline and compared with it. A signal
+ * whose floating point filter is not a Bessel filter is compared against a different filter. The shadow buffers
+ * are not part of the checkpoints, the statistics of a restored run settle after a buffer depth.
+ */
+#ifndef FXP_B_SCALE
+#define FXP_B_SCALE 2048.0 // full scale of B (mG)
+#endif
+#ifndef FXP_BT_SCALE
+#define FXP_BT_SCALE 1024.0 // full scale of B-dot (mG s^-1)
+#endif
+#ifndef FXP_W_SCALE
+#define FXP_W_SCALE 8.0 // full scale of omega (rad s^-1), the unfiltered estimate saturates when B-dot is at the noise floor
+#endif
+q31_t *x_q_B, *y_q_B, *z_q_B; // indexed by the rings of g_B, g_Bt and g_W, in g_arena
+q31_t *x_q_Bt, *y_q_Bt, *z_q_Bt;
+q31_t *x_q_W, *y_q_W, *z_q_W;
+q15_t q_bessel_B[SH_BUFFER_MAX], q_bessel_Bt[SH_BUFFER_MAX], q_bessel_W[SH_BUFFER_MAX]; // Q15 weights
+int q_taps_B, q_taps_Bt, q_taps_W; // 0 if the fixed-point signal is not filtered
+/**
+ * @brief Error statistics of the fixed-point B, B-dot and omega against the floating point ones.
+ * 
+ */
+fxp_stats_t g_fxp_B, g_fxp_Bt, g_fxp_W;
+/**
+ * @brief Indicates that the fixed-point B, B-dot and omega follow the floating point ones and are compared:
+ * the signal and the signals it is derived from are Bessel filtered or not filtered.
+ * 
+ */
+int g_fxp_cmp_B, g_fxp_cmp_Bt, g_fxp_cmp_W;
 
-    if (isnan(x_g_S[sol_index]))
+/**
+ * @brief Q15 weights of the fixed-point filter of a signal from its floating point filter. Only the Bessel
+ * filter has a fixed-point counterpart, the other signals pass through.
+ * 
+ * @return int Number of taps, 0 to pass through
+ */
+static int fxpFilter(q15_t w[], const filter_t *f)
+{
+    return f->cfg.type == FILTER_BESSEL ? calculateBesselQ15(w, f->coeff, bessel_depth) : 0;
+}
+
+/**
+ * @brief Computes the Q15 weights of the fixed-point filters from the floating point filters, and which
+ * signals can be compared.
+ * 
+ */
+void initFixedPoint(void)
+{
+    q_taps_B = fxpFilter(q_bessel_B, &g_filter_B);
+    q_taps_Bt = fxpFilter(q_bessel_Bt, &g_filter_Bt);
+    q_taps_W = fxpFilter(q_bessel_W, &g_filter_W);
+    g_fxp_cmp_B = q_taps_B > 0 || g_filter_B.cfg.type == FILTER_NONE;
+    g_fxp_cmp_Bt = g_fxp_cmp_B && (q_taps_Bt > 0 || g_filter_Bt.cfg.type == FILTER_NONE);
+    g_fxp_cmp_W = g_fxp_cmp_Bt && (q_taps_W > 0 || g_filter_W.cfg.type == FILTER_NONE);
+    return;
+}
+
+/**
+ * @brief Adds the fixed-point vector at index of a Q31 buffer to the error statistics against the floating point one.
+ * 
+ */
+#define FXP_COMPARE(st, qname, name, index, scale)                                                                         \
+    do                                                                                                                     \
+    {                                                                                                                      \
+        double fxp__q[3] = {q31_to_double(x_##qname[index], scale), q31_to_double(y_##qname[index], scale),                \
+                            q31_to_double(z_##qname[index], scale)};                                                       \
+        double fxp__ref[3] = {x_##name[index], y_##name[index], z_##name[index]};                                          \
+        fxp_stats_add(st, fxp__q, fxp__ref);                                                                               \
+    } while (0)
+
+/**
+ * @brief Fixed-point B: the newest magnetometer sample, converted and filtered.
+ * 
+ */
+static void fxpMag(void)
+{
+    int mag_index = RING_HEAD(g_B);
+    uint64_t sat = fxp_saturations;
+    x_q_B[mag_index] = q31_from_double(g_mag_sample[0], FXP_B_SCALE);
+    y_q_B[mag_index] = q31_from_double(g_mag_sample[1], FXP_B_SCALE);
+    z_q_B[mag_index] = q31_from_double(g_mag_sample[2], FXP_B_SCALE);
+    if (q_taps_B > 0)
+    {
+        APPLY_QBESSEL(q_B, mag_index, q_bessel_B, q_taps_B);
+    }
+    g_fxp_B.saturations += fxp_saturations - sat;
+    if (g_fxp_cmp_B)
+        FXP_COMPARE(&g_fxp_B, q_B, g_B, mag_index, FXP_B_SCALE);
+    return;
+}
+
+/**
+ * @brief Fixed-point B-dot at the newest index, from the fixed-point B at m1 and m0.
+ * 
+ */
+static void fxpBdot(int m1, int m0, double freq)
+{
+    int bdot_index = RING_HEAD(g_Bt);
+    uint64_t sat = fxp_saturations;
+    QVECTOR_OP(q_Bt[bdot_index], q_B[m1], q_B[m0], q31_sub);
+    int32_t k = q16_gain(freq * FXP_B_SCALE / FXP_BT_SCALE);
+    QVECTOR_GAIN(q_Bt[bdot_index], q_Bt[bdot_index], k);
+    if (q_taps_Bt > 0)
+    {
+        APPLY_QBESSEL(q_Bt, bdot_index, q_bessel_Bt, q_taps_Bt);
+    }
+    g_fxp_Bt.saturations += fxp_saturations - sat;
+    if (g_fxp_cmp_Bt)
+        FXP_COMPARE(&g_fxp_Bt, q_Bt, g_Bt, bdot_index, FXP_BT_SCALE);
+    return;
+}
+
+/**
+ * @brief Fixed-point omega at the newest index, from the fixed-point B-dot at m1 and m0: the Q62 cross product over
+ * the Q61 squared norm, one 64 by 32 bit division per axis.
+ * 
+ */
+static void fxpOmega(int m1, int m0, float freq)
+{
+    int omega_index = RING_HEAD(g_W);
+    uint64_t sat = fxp_saturations;
+    DECLARE_VECTOR(c, int64_t);
+    QCROSS_PRODUCT(c, q_Bt[m1], q_Bt[m0]); // Q62
+    int64_t norm2 = QNORM2(q_Bt[m0]);      // Q61
+    int32_t k = q16_gain(freq / FXP_W_SCALE);
+    x_q_W[omega_index] = q31_gain(q31_div64(x_c >> 1, norm2), k);
+    y_q_W[omega_index] = q31_gain(q31_div64(y_c >> 1, norm2), k);
+    z_q_W[omega_index] = q31_gain(q31_div64(z_c >> 1, norm2), k);
+    if (q_taps_W > 0)
+    {
+        APPLY_QBESSEL(q_W, omega_index, q_bessel_W, q_taps_W);
+    }
+    g_fxp_W.saturations += fxp_saturations - sat;
+    if (g_fxp_cmp_W)
+        FXP_COMPARE(&g_fxp_W, q_W, g_W, omega_index, FXP_W_SCALE);
+    return;
+}
+
+/**
+ * @brief Prints the error statistics of a fixed-point signal, or why it is not compared.
+ * 
+ */
+static void fxpPrint(FILE *fp, const char *name, const char *unit, const fxp_stats_t *st, int compared, const filter_t *f)
+{
+    if (compared)
+        fxp_stats_print(fp, name, unit, st);
+    else if (f->cfg.type != FILTER_BESSEL && f->cfg.type != FILTER_NONE)
+        fprintf(fp, "[FIXEDPT] %-6s not compared, the %s filter has no fixed-point counterpart\n", name, filter_type_name(f->cfg.type));
+    else
+        fprintf(fp, "[FIXEDPT] %-6s not compared, derived from a signal that is not compared\n", name);
+    return;
+}
+
+/**
+ * @brief Prints the error statistics of the fixed-point pipeline.
+ * 
+ * @param fp Output
+ */
+void printFixedPoint(FILE *fp)
+{
+    fxpPrint(fp, "B", "mG", &g_fxp_B, g_fxp_cmp_B, &g_filter_B);
+    fxpPrint(fp, "Bdot", "mG/s", &g_fxp_Bt, g_fxp_cmp_Bt, &g_filter_Bt);
+    fxpPrint(fp, "omega", "rad/s", &g_fxp_W, g_fxp_cmp_W, &g_filter_W);
+    return;
+}
+#endif // ACS_FIXEDPOINT
+
+/**
+ * @brief Allocates the circular buffers, the filter histories and the statistics windows at the capacity for
+ * bessel_depth, from a fresh arena, unless they already have it. Empties the buffers, filters and windows it
+ * allocates.
+ * 
+ * @return int 1 on success, -1 if the arena could not be allocated
+ */
+int initBuffers(void)
+{
+    uint32_t capacity = bessel_mask + 1;
+    if (g_arena.base != NULL && RING_CAPACITY(g_B) == capacity)
+        return 1;
+    filter_t *filters[] = {&g_filter_B, &g_filter_Bt, &g_filter_W, &g_filter_S};
+    winstat3_t *stats[] = {&g_stat_B, &g_stat_Bt, &g_stat_W, &g_stat_S};
+    size_t bytes = 2 * RING_ARENA_SIZE(double, capacity) + 2 * RING_ARENA_SIZE(float, capacity) +
+                   4 * FILTER_ARENA_SIZE(capacity) + 4 * WINSTAT3_ARENA_SIZE(capacity);
+#ifdef ACS_FIXEDPOINT
+    bytes += 3 * RING_ARENA_SIZE(q31_t, capacity);
+#endif
+    arena_free(&g_arena);
+    if (arena_init(&g_arena, bytes) < 0 ||
+        !RING_ALLOC(&g_arena, g_B, capacity) || !RING_ALLOC(&g_arena, g_Bt, capacity) ||
+        !RING_ALLOC(&g_arena, g_W, capacity) || !RING_ALLOC(&g_arena, g_S, capacity))
+    {
+        fprintf(stderr, "[ACS] Could not allocate buffers of capacity %u\n", capacity);
+        return -1;
+    }
+#ifdef ACS_FIXEDPOINT
+    if (!ARENA_BUFFER(&g_arena, q_B, capacity) || !ARENA_BUFFER(&g_arena, q_Bt, capacity) || !ARENA_BUFFER(&g_arena, q_W, capacity))
+    {
+        fprintf(stderr, "[ACS] Could not allocate buffers of capacity %u\n", capacity);
+        return -1;
+    }
+#endif
+    for (int i = 0; i < 4; i++)
+    {
+        if (filter_alloc(filters[i], &g_arena, capacity) < 0 || winstat3_alloc(stats[i], &g_arena, capacity) < 0)
+        {
+            fprintf(stderr, "[ACS] Could not allocate buffers of capacity %u\n", capacity);
+            return -1;
+        }
+    }
+    initWindowStats();
+    return 1;
+}
+
+/**
+ * @brief Sets up the filters from the scenario, Bessel filters without an order or cut-off of their own taking
+ * acs.bessel_order and acs.bessel_cutoff. Resets their state and cost counters. An invalid filter passes its
+ * signal through.
+ * 
+ */
+void initFilters(void)
+{
+    filter_config_t *cfgs[] = {&g_scenario.filter_B, &g_scenario.filter_Bt, &g_scenario.filter_W, &g_scenario.filter_S};
+    filter_t *filters[] = {&g_filter_B, &g_filter_Bt, &g_filter_W, &g_filter_S};
+    for (int i = 0; i < 4; i++)
+    {
+        filter_config_t cfg = *cfgs[i];
+        if (cfg.type == FILTER_BESSEL && cfg.order == 0)
+        {
+            cfg.order = g_scenario.bessel_order;
+            cfg.cutoff = g_scenario.bessel_cutoff;
+        }
+        filter_init(filters[i], &cfg);
+    }
+    filters_ready = 1;
+    initWindowStats();
+#ifdef ACS_FIXEDPOINT
+    initFixedPoint();
+#endif
+    return;
+}
+
+/**
+ * @brief Prints the settings and cost counters of the filters.
+ * 
+ * @param fp Output
+ */
+void printFilters(FILE *fp)
+{
+    filter_print(fp, "B", &g_filter_B);
+    filter_print(fp, "Bdot", &g_filter_Bt);
+    filter_print(fp, "omega", &g_filter_W);
+    filter_print(fp, "sun", &g_filter_S);
+    return;
+}
+
+/**
+ * @brief Corrupts the sensor samples taken on this step according to the active faults.
+ * 
+ * @param fs Active fault state
+ * @param mag_due Magnetometer sampled on this step
+ * @param css_due Coarse sun sensors sampled on this step
+ * @param fss_due Fine sun sensor sampled on this step
+ */
+void applyFaults(const fault_state_t *fs, int mag_due, int css_due, int fss_due)
+{
+    if (mag_due && fs->mag_nan)
+    {
+        for (int i = 0; i < 3; i++)
+            g_mag_sample[i] = NAN;
+    }
+    if (css_due)
+    {
+        for (int i = 0; i < 7; i++)
+        {
+            if (fs->css_nan[i])
+                g_css_sample[i] = NAN;
+            else if (fs->css_dead[i])
+                g_css_sample[i] = 0;
+            else if (fs->css_stuck[i])
+                g_css_sample[i] = fs->css_value[i];
+            else if (fs->css_noise[i] > 0)
+                g_css_sample[i] += fs->css_noise[i] * (simRand() - 0.5);
+        }
+    }
+    if (fss_due && fs->fss_dead)
+    {
+        g_fss_sample[0] = 0;
+        g_fss_sample[1] = 0;
+        g_fss_sample_ret = FSS_NO_SUN;
+    }
+    return;
+}
+
+/**
+ * @brief Simulates the magnetometer: the true field in the body frame plus noise.
+ * 
+ * @param mag Measured field (mG)
+ */
+void readMag(double mag[3])
+{
+    dynamics_to_body(&g_dyn, g_B_I, mag); // true field in the body frame
+    for (int i = 0; i < 3; i++)
+        mag[i] += MAG_NOISE * (simRand() - 0.5); // noise
+    return;
+}
+
+/**
+ * @brief Simulates the coarse sun sensors, lit by the visible fraction of the solar disk.
+ * 
+ * @param sun_body True sun direction in the body frame (unit vector)
+ * @param css Sensor readings in g_CSS order (lux)
+ */
+void readCSS(const double sun_body[3], float css[7])
+{
+    for (int i = 0; i < 7; i++)
+    {
+        double cos_inc = CSS_NORMAL[i][0] * sun_body[0] + CSS_NORMAL[i][1] * sun_body[1] + CSS_NORMAL[i][2] * sun_body[2];
+        css[i] = CSS_MAX_LUX * g_sun_frac * (cos_inc > 0 ? cos_inc : 0) + CSS_NOISE * (simRand() - 0.5); // lit faces only
+    }
+    return;
+}
+
+/**
+ * @brief Simulates the fine sun sensor: the sun angles about the X and Y axes, measured from the +Z
+ * boresight. The angles are zeroed on error.
+ * 
+ * @param sun_body True sun direction in the body frame (unit vector)
+ * @param fss Sun angles (rad)
+ * @return int Return code, FSS_OK, FSS_NO_SUN or FSS_OUT_OF_FOV
+ */
+int readFSS(const double sun_body[3], float fss[2])
+{
+    int ret;
+    if (g_sun_frac < FSS_MIN_SUN)
+        ret = FSS_NO_SUN;
+    else if (sun_body[2] < cos(FSS_FOV))
+        ret = FSS_OUT_OF_FOV;
+    else
+        ret = FSS_OK;
+    if (ret != FSS_OK)
+    {
+        fss[0] = 0;
+        fss[1] = 0;
+        return ret;
+    }
+    fss[0] = atan2(sun_body[0], sun_body[2]) + FSS_NOISE * (simRand() - 0.5);
+    fss[1] = atan2(sun_body[1], sun_body[2]) + FSS_NOISE * (simRand() - 0.5);
+    return ret;
+}
+
+void getOmega(void)
+{
+    if (RING_COUNT(g_B) < 3) // not enough measurements
+        return;
+    // once we have measurements, we declare that we proceed
+    int omega_index = RING_PUSH(g_W); // new index in the circular buffer
+    int m1 = RING_HEAD(g_Bt);         // current address
+    int m0 = RING_BACK(g_Bt, 1);      // previous address
+    float freq;
+    freq = 1e6 / g_mag_dt;                               // time units!
+    CROSS_PRODUCT(g_W[omega_index], g_Bt[m1], g_Bt[m0]); // apply cross product
+    float norm2 = NORM2(g_Bt[m0]);
+    VECTOR_MIXED(g_W[omega_index], g_W[omega_index], freq / norm2, *); // omega = (B_t dot x B_t-dt dot)*freq/Norm2(B_t dot)
+    // Apply correction // There is fast runaway with this on
+    // DECLARE_VECTOR(omega_corr0, float);                            // declare temporary space for correction vector
+    // MATVECMUL(omega_corr0, MOI, g_W[m1]);                          // MOI X w[t-1]
+    // DECLARE_VECTOR(omega_corr1, float);                            // declare temporary space for correction vector
+    // CROSS_PRODUCT(omega_corr1, g_W[m1], omega_corr0);              // store into temp 1
+    // MATVECMUL(omega_corr1, IMOI, omega_corr0);                     // store back into temp 0
+    // VECTOR_MIXED(omega_corr1, omega_corr1, -freq, *);              // omega_corr = freq*(MOI-1)*(-w[t-1] X MOI*w[t-1])
+    // VECTOR_OP(g_W[omega_index], g_W[omega_index], omega_corr1, +); // add the correction term to omega
+    APPLY_FFILTER(&g_filter_W, g_W, omega_index);
+    WINSTAT_BUFFER(&g_stat_W, g_W, omega_index);
+#ifdef ACS_FIXEDPOINT
+    fxpOmega(m1, m0, freq);
+#endif
+    return;
+}
+
+void getSVec(void)
+{
+    int sol_index = RING_PUSH(g_S);
+#ifndef M_PI
+/**
+ * @brief Approximate definition of Pi in case M_PI is not included from math.h
+ */
+#define M_PI 3.1415
+#endif
+    // check if FSS results are acceptable
+    // if they are, use that to calculate the sun vector
+    if (g_FSS_RET == FSS_OK && sensorsched_age(&g_fss_sched, acs_ct * (uint64_t)DETUMBLE_TIME_STEP) <= FSS_MAX_AGE)
+    {
+        g_night = 0;
+        x_g_S[sol_index] = tanf(g_FSS[0]); // direction (tan x, tan y, 1) in the sensor frame
+        y_g_S[sol_index] = tanf(g_FSS[1]);
+        z_g_S[sol_index] = 1;
+        NORMALIZE(g_S[sol_index], g_S[sol_index]);
+#ifdef ACS_PRINT
+        printf("[FSS] %.3f %.3f\n", g_FSS[0] * 180. / M_PI, g_FSS[1] * 180. / M_PI);
+#endif // ACS_PRINT
+    }
+    else // fall back to the coarse sun sensors
+    {
+        // get average -Z luminosity from 2 sensors
+        float znavg = 0;
+        for (int i = 5; i < 7; i++)
+            znavg += g_CSS[i];
+        znavg *= 0.5f;
+
+        x_g_S[sol_index] = g_CSS[0] - g_CSS[1]; // +x - -x
+        y_g_S[sol_index] = g_CSS[2] - g_CSS[3]; // +x - -x
+        z_g_S[sol_index] = g_CSS[4] - znavg;    // +z - avg(-z)
+
+        float css_mag = NORM(g_S[sol_index]); // norm of the CSS lux values
+#define CSS_MIN_LUX_THRESHOLD 500
+        if (css_mag < CSS_MIN_LUX_THRESHOLD) // night time logic
+        {
+            g_night = 1;
+            VECTOR_CLEAR(g_S[sol_index]); // return 0 solar vector
+#ifdef ACS_PRINT
+            printf("[" RED "FSS" RST "]");
+#endif // ACS_PRINT
+        }
+        else
+        {
+            g_night = 0;
+            NORMALIZE(g_S[sol_index], g_S[sol_index]); // return normalized sun vector
+#ifdef ACS_PRINT
+            printf("[" YLW "FSS" RST "]");
+#endif // ACS_PRINT
+        }
+    }
+    if (!g_night && g_filter_S.cfg.type != FILTER_NONE)
+    {
+        APPLY_FFILTER(&g_filter_S, g_S, sol_index);
+        NORMALIZE(g_S[sol_index], g_S[sol_index]); // the filtered direction, back to a unit vector
+    }
+    if (g_night)
+        winstat3_init(&g_stat_S, bessel_depth);
+    else
+        WINSTAT_BUFFER(&g_stat_S, g_S, sol_index);
+#ifdef ACS_PRINT
+    printf("[sunvec %d] %0.3f %0.3f %0.3f\n", sol_index, x_g_S[sol_index], y_g_S[sol_index], z_g_S[sol_index]);
+#endif // ACS_PRINT
+    return;
+}
+
+/**
+ * @brief B-dot detumble controller. Commands a magnetorquer dipole opposing the latest \f$\vec{\dot{B}}\f$ (g_Bt_ctl),
+ * saturated at DIPOLE_MOMENT, which the dynamics apply as torque over the next loop period.
+ * 
+ */
+void applyBdot(void)
+{
+    DECLARE_VECTOR(m, float);
+    VECTOR_MIXED(m, g_Bt_ctl, -BDOT_GAIN, *); // m = -k dB/dt
+    // saturate, scaling the whole vector so the command keeps its direction
+    float m_max = fabsf(x_m) > fabsf(y_m) ? fabsf(x_m) : fabsf(y_m);
+    m_max = fabsf(z_m) > m_max ? fabsf(z_m) : m_max;
+    if (m_max > DIPOLE_MOMENT)
+    {
+        VECTOR_MIXED(m, m, DIPOLE_MOMENT / m_max, *);
+    }
+    x_g_M = x_m;
+    y_g_M = y_m;
+    z_g_M = z_m;
+    // actuate, the torque m x B is applied by the dynamics over the next loop period
+    if (!isfinite(x_g_M) || !isfinite(y_g_M) || !isfinite(z_g_M)) // the torquer driver rejects invalid commands
+    {
+        memset(g_dyn_input.dipole, 0, sizeof(g_dyn_input.dipole));
+        return;
+    }
+    g_dyn_input.dipole[0] = x_g_M;
+    g_dyn_input.dipole[1] = y_g_M;
+    g_dyn_input.dipole[2] = z_g_M;
+    return;
+}
+
+/**
+ * @brief Resets buffers, rings, counters and the actuator command, and restarts the simulation from the given attitude state.
+ * 
+ * @param init Initial attitude and angular velocity
+ */
+void resetSim(const dyn_state_t *init)
+{
+    if (initBuffers() > 0) // otherwise the next readSensors() fails
+    {
+        RING_RESET(g_B);
+        RING_RESET(g_Bt);
+        RING_RESET(g_W);
+        RING_RESET(g_S);
+#ifdef ACS_FIXEDPOINT
+        FLUSH_BUFFER_SIZE(q_B, RING_CAPACITY(g_B));
+        FLUSH_BUFFER_SIZE(q_Bt, RING_CAPACITY(g_B));
+        FLUSH_BUFFER_SIZE(q_W, RING_CAPACITY(g_B));
+#endif
+    }
+    g_night = 0;
+    g_acs_mode = 0;
+    g_first_detumble = 1;
+    acs_ct = 0;
+    g_tnow = 0;
+    g_detumble_time = -1;
+    g_detumble_est_time = -1;
+    g_sunlock_time = -1;
+    initWindowStats();
+    g_eclipse.t_end = -1;
+    g_sun_frac = 1;
+    for (int i = 0; i < 3; i++)
+        mux_err_channel[i] = false;
+    if (g_faults != NULL)
+        fault_rewind(g_faults);
+    VECTOR_CLEAR(g_M);
+    memset(&g_dyn_input, 0, sizeof(g_dyn_input));
+    filter_reset(&g_filter_B);
+    filter_reset(&g_filter_Bt);
+    filter_reset(&g_filter_W);
+    filter_reset(&g_filter_S);
+    g_dyn = *init;
+    first_run = 1;
+    return;
+}
+
+/**
+ * @brief Applies one scenario key to the simulation parameters, see loadScenario().
+ * 
+ * @return int 1 if the key is known and its value valid, 0 otherwise
+ */
+static int scenarioKey(void *ctx, const char *section, const char *key, const char *value)
+{
+    char name[128];
+    double v[9];
+    filter_config_t filter;
+    snprintf(name, sizeof(name), "%s.%s", section, key);
+    int n = config_doubles(value, v, 9);
+    for (int i = 0; i < n; i++)
+        if (!isfinite(v[i])) // strtod() accepts nan and inf
+            n = -1;
+#define SCENARIO_KEY(str) (strcmp(name, str) == 0)
+    if (SCENARIO_KEY("acs.time_step_us") && n == 1 && v[0] >= 1000)
+        DETUMBLE_TIME_STEP = v[0];
+    else if (SCENARIO_KEY("acs.dipole_moment") && n == 1 && v[0] >= 0)
+        DIPOLE_MOMENT = v[0];
+    else if (SCENARIO_KEY("acs.bdot_gain") && n == 1)
+        BDOT_GAIN = v[0];
+    else if (SCENARIO_KEY("acs.detumble_threshold") && n == 1 && v[0] > 0)
+        DETUMBLE_THRESHOLD = v[0];
+    else if (SCENARIO_KEY("acs.sunlock_threshold") && n == 1 && v[0] > 0)
+        SUNLOCK_THRESHOLD = v[0];
+    else if (SCENARIO_KEY("acs.bessel_order") && n == 1 && v[0] >= 1)
+        g_scenario.bessel_order = v[0];
+    else if (SCENARIO_KEY("acs.bessel_cutoff") && n == 1 && v[0] > 0)
+        g_scenario.bessel_cutoff = v[0];
+    else if (SCENARIO_KEY("filters.B") && filter_parse(&filter, value) > 0)
+        g_scenario.filter_B = filter;
+    else if (SCENARIO_KEY("filters.Bdot") && filter_parse(&filter, value) > 0)
+        g_scenario.filter_Bt = filter;
+    else if (SCENARIO_KEY("filters.omega") && filter_parse(&filter, value) > 0)
+        g_scenario.filter_W = filter;
+    else if (SCENARIO_KEY("filters.sun") && filter_parse(&filter, value) > 0)
+        g_scenario.filter_S = filter;
+    else if (SCENARIO_KEY("acs.buffer_depth") && n == 1 && v[0] >= 4 && v[0] <= SH_BUFFER_MAX)
+        setBesselDepth(v[0]);
+    else if (SCENARIO_KEY("satellite.moi") && (n == 3 || n == 9))
+    {
+        float moi[3][3], imoi[3][3]; // MOI and IMOI keep the previous satellite unless the new MOI inverts
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                moi[i][j] = n == 9 ? v[3 * i + j] : (i == j ? v[i] : 0);
+        if (!matinv3(imoi, moi))
+            return 0;
+        memcpy(MOI, moi, sizeof(MOI));
+        memcpy(IMOI, imoi, sizeof(IMOI));
+    }
+    else if (SCENARIO_KEY("satellite.initial_rate") && n == 3)
+        memcpy(g_dyn.w, v, sizeof(g_dyn.w));
+    else if (SCENARIO_KEY("satellite.integrator") && (strcmp(value, "rk4") == 0 || strcmp(value, "rk45") == 0))
+        g_dyn_integrator = strcmp(value, "rk4") == 0 ? DYN_RK4 : DYN_RK45;
+    else if (SCENARIO_KEY("satellite.substeps") && n == 1 && v[0] >= 1)
+        g_dyn_substeps = v[0];
+    else if (SCENARIO_KEY("orbit.altitude_km") && n == 1 && v[0] > 0)
+        g_orbit_elements.a = EARTH_RADIUS + v[0];
+    else if (SCENARIO_KEY("orbit.a_km") && n == 1 && v[0] > EARTH_RADIUS)
+        g_orbit_elements.a = v[0];
+    else if (SCENARIO_KEY("orbit.e") && n == 1 && v[0] >= 0 && v[0] < 1)
+        g_orbit_elements.e = v[0];
+    else if (SCENARIO_KEY("orbit.i_deg") && n == 1)
+        g_orbit_elements.i = v[0] * M_PI / 180;
+    else if (SCENARIO_KEY("orbit.raan_deg") && n == 1)
+        g_orbit_elements.raan = v[0] * M_PI / 180;
+    else if (SCENARIO_KEY("orbit.argp_deg") && n == 1)
+        g_orbit_elements.argp = v[0] * M_PI / 180;
+    else if (SCENARIO_KEY("orbit.M_deg") && n == 1)
+        g_orbit_elements.M = v[0] * M_PI / 180;
+    else if (SCENARIO_KEY("orbit.epoch_jd") && n == 1)
+        g_epoch_jd = v[0];
+    else if (SCENARIO_KEY("orbit.shadow") && (strcmp(value, "conical") == 0 || strcmp(value, "cylindrical") == 0))
+        g_shadow_model = strcmp(value, "conical") == 0 ? SUN_SHADOW_CONICAL : SUN_SHADOW_CYLINDRICAL;
+    else if (SCENARIO_KEY("field.coef_file") && strlen(value) < sizeof(g_scenario.coef_file))
+    {
+        strcpy(g_scenario.coef_file, value);
+        g_field.nmax = 0; // reload on the next first run
+    }
+    else if (SCENARIO_KEY("field.degree") && n == 1 && v[0] >= 1)
+    {
+        g_scenario.field_degree = v[0];
+        g_field.nmax = 0;
+    }
+    else if (SCENARIO_KEY("faults.file") && strlen(value) < sizeof(g_scenario.fault_file))
+        strcpy(g_scenario.fault_file, value);
+    else if (SCENARIO_KEY("faults.seed") && n == 1)
+        g_scenario.fault_seed = v[0];
+    else if (SCENARIO_KEY("sim.seed") && n == 1)
+        g_scenario.seed = v[0];
+    else if (SCENARIO_KEY("server.port") && n == 1 && v[0] > 0 && v[0] < 65536)
+        g_scenario.port = v[0];
+    else
+    {
+        fprintf(stderr, "[SCENARIO] Invalid key or value: %s = %s\n", name, value);
+        return 0;
+    }
+#undef SCENARIO_KEY
+    return 1;
+}
+
+/**
+ * @brief Loads a scenario file (INI, see scenario.ini for the keys and their defaults), setting the simulation
+ * parameters for the next run without a rebuild. Keys not in the file keep their current values.
+ * Recomputes IMOI, the Bessel coefficients and the filters; call before the first readSensors() or resetSim().
+ * 
+ * @param path Scenario file
+ * @return int 1 on success, -1 on error
+ */
+int loadScenario(const char *path)
+{
+    int err = config_parse(path, scenarioKey, NULL);
+    if (err != 0)
+    {
+        if (err > 0)
+            fprintf(stderr, "[SCENARIO] %s:%d: parse error\n", path, err);
+        return -1;
+    }
+    if (g_field.nmax == 0)
+        field_grid_free(&g_field); // a grid of the old model would shadow the new one
+    calculateBessel(bessel_coeff, besselSize(), g_scenario.bessel_order, g_scenario.bessel_cutoff);
+    initFilters();
+    first_run = 1;
+    return 1;
+}
+
+/**
+ * @brief Loads the geomagnetic field model named by the scenario, if none is loaded (tilted dipole if the file is missing).
+ * 
+ */
+static void initField(void)
+{
+    if (g_field.nmax == 0 && field_load(&g_field, g_scenario.coef_file, g_scenario.field_degree) < 0)
+    {
+        fprintf(stderr, "[FIELD] Could not read %s, using the dipole field\n", g_scenario.coef_file);
+        field_dipole(&g_field);
+    }
+    return;
+}
+
+/**
+ * @brief Fills the parameters of a batch of satellites from the current simulation parameters and scenario.
+ * Loads the field model if needed.
+ * 
+ * @param p Batch parameters
+ */
+void batchParams(batch_params_t *p)
+{
+    memset(p, 0, sizeof(batch_params_t));
+    initField();
+    p->time_step = DETUMBLE_TIME_STEP;
+    p->substeps = g_dyn_substeps;
+    if (!matinv3(IMOI, MOI))
+        fprintf(stderr, "[ACS] MOI is singular, IMOI not updated\n");
+    dynamics_init(&p->dyn, MOI, IMOI);
+    p->dipole_max = DIPOLE_MOMENT;
+    p->gain = BDOT_GAIN;
+    p->detumble_threshold = DETUMBLE_THRESHOLD;
+    p->depth = bessel_depth;
+    memcpy(p->coeff, bessel_coeff, sizeof(p->coeff));
+    p->mag_noise = MAG_NOISE;
+    p->css_max_lux = CSS_MAX_LUX;
+    p->css_noise = CSS_NOISE;
+    p->css_min_lux = CSS_MIN_LUX_THRESHOLD;
+    p->orbit = g_orbit_elements;
+    p->ephem = g_ephem;
+    p->epoch_jd = g_epoch_jd;
+    p->shadow = g_shadow_model;
+    p->field = &g_field;
+    return;
+}
+
+/**
+ * @brief Brings the fault plan, if any, to the current step, after the plan was changed or the state restored.
+ * 
+ */
+void replayFaults(void)
+{
+    if (g_faults == NULL)
+        return;
+    fault_rewind(g_faults);
+    fault_apply_events(g_faults, acs_ct);
+    for (int i = 0; i < 3; i++)
+        mux_err_channel[i] = g_faults->state.mux_err[i];
+    return;
+}
+
+/**
+ * @brief Identifies a checkpoint file.
+ * 
+ */
+#define ACS_CHECKPOINT_MAGIC "ACSCKPT"
+/**
+ * @brief Layout version of acs_checkpoint_t, bumped whenever a field is added, removed or resized.
+ * 
+ */
+#define ACS_CHECKPOINT_VERSION 7
+
+/**
+ * @brief Complete state of a simulation between two readSensors() calls, in a fixed layout that is
+ * written and read as a single block. Parameters (scenario, field model, fault plan, Bessel coefficients,
+ * filter settings) are not part of the state and come from the restoring program.
+ * 
+ */
+typedef struct
+{
+    char magic[8];       // ACS_CHECKPOINT_MAGIC
+    uint32_t version;    // ACS_CHECKPOINT_VERSION
+    uint32_t size;       // sizeof(acs_checkpoint_t)
+    uint32_t time_step;  // DETUMBLE_TIME_STEP (usec), must match on restore
+    int buffer_depth;    // bessel_depth, must match on restore
+    // control loop
+    float x_W[SH_BUFFER_MAX], y_W[SH_BUFFER_MAX], z_W[SH_BUFFER_MAX]; // the capacity of the rings in use
+    double x_B[SH_BUFFER_MAX], y_B[SH_BUFFER_MAX], z_B[SH_BUFFER_MAX];
+    double x_Bt[SH_BUFFER_MAX], y_Bt[SH_BUFFER_MAX], z_Bt[SH_BUFFER_MAX];
+    float x_S[SH_BUFFER_MAX], y_S[SH_BUFFER_MAX], z_S[SH_BUFFER_MAX];
+    ring_t W_ring, B_ring, Bt_ring, S_ring;
+    filter_save_t filter_B, filter_Bt, filter_W, filter_S;
+    winstat3_save_t stat_B, stat_Bt, stat_W, stat_S;
+    uint8_t night, acs_mode, first_detumble;
+    bool mux_err[3];
+    float M[3];
+    float CSS[7];
+    float FSS[2];
+    int FSS_RET;
+    unsigned long long acs_ct;
+    double tnow;
+    double detumble_time;
+    double detumble_est_time, sunlock_time;
+    // sensors
+    sensorsched_t mag_sched, css_sched, fss_sched;
+    double mag_sample[3];
+    float css_sample[7];
+    float fss_sample[2];
+    int fss_sample_ret;
+    uint32_t mag_dt;
+    uint64_t rng;
+    // simulated satellite
+    dyn_state_t dyn;
+    dyn_params_t dyn_params;
+    dyn_input_t dyn_input;
+    orbit_state_t orbit;
+    double B_I[3];
+    double S_I[3];
+    double sun_frac;
+    sun_eclipse_t eclipse;
+} acs_checkpoint_t;
+
+/**
+ * @brief Copies every field of the checkpoint from (save) or to (restore) the simulation state. Keeps the
+ * list of fields in one place, so that saving and restoring cannot drift apart.
+ * 
+ * @param cp Checkpoint
+ * @param save 1 to save the simulation state into cp, 0 to restore it from cp
+ */
+static void checkpointCopy(acs_checkpoint_t *cp, int save)
+{
+#define CHECKPOINT_FIELD(field, var)                                                          \
+    do                                                                                        \
+    {                                                                                         \
+        _Static_assert(sizeof(cp->field) == sizeof(var), "checkpoint field size: " #field); \
+        if (save)                                                                             \
+            memcpy(&cp->field, &(var), sizeof(var));                                          \
+        else                                                                                  \
+            memcpy(&(var), &cp->field, sizeof(var));                                          \
+    } while (0)
+#define CHECKPOINT_AXIS(field, var)                                                             \
+    do                                                                                          \
+    {                                                                                           \
+        _Static_assert(sizeof(cp->field[0]) == sizeof(*(var)), "checkpoint buffer type: " #field); \
+        if (save)                                                                               \
+            memcpy(cp->field, var, RING_CAPACITY(g_B) * sizeof(*(var)));                        \
+        else                                                                                    \
+            memcpy(var, cp->field, RING_CAPACITY(g_B) * sizeof(*(var)));                        \
+    } while (0)
+#define CHECKPOINT_RING(field, name)                \
+    CHECKPOINT_AXIS(x_##field, x_##name);           \
+    CHECKPOINT_AXIS(y_##field, y_##name);           \
+    CHECKPOINT_AXIS(z_##field, z_##name);           \
+    CHECKPOINT_FIELD(field##_ring, name##_ring)
+#define CHECKPOINT_COPY(field, var, savefn, restorefn) \
+    do                                                 \
+    {                                                  \
+        if (save)                                      \
+            savefn(&cp->field, &(var));                \
+        else                                           \
+            restorefn(&(var), &cp->field);             \
+    } while (0)
+    CHECKPOINT_RING(W, g_W);
+    CHECKPOINT_RING(B, g_B);
+    CHECKPOINT_RING(Bt, g_Bt);
+    CHECKPOINT_RING(S, g_S);
+    CHECKPOINT_COPY(filter_B, g_filter_B, filter_save, filter_restore);
+    CHECKPOINT_COPY(filter_Bt, g_filter_Bt, filter_save, filter_restore);
+    CHECKPOINT_COPY(filter_W, g_filter_W, filter_save, filter_restore);
+    CHECKPOINT_COPY(filter_S, g_filter_S, filter_save, filter_restore);
+    CHECKPOINT_COPY(stat_B, g_stat_B, winstat3_save, winstat3_restore);
+    CHECKPOINT_COPY(stat_Bt, g_stat_Bt, winstat3_save, winstat3_restore);
+    CHECKPOINT_COPY(stat_W, g_stat_W, winstat3_save, winstat3_restore);
+    CHECKPOINT_COPY(stat_S, g_stat_S, winstat3_save, winstat3_restore);
+    CHECKPOINT_FIELD(night, g_night);
+    CHECKPOINT_FIELD(acs_mode, g_acs_mode);
+    CHECKPOINT_FIELD(first_detumble, g_first_detumble);
+    CHECKPOINT_FIELD(mux_err, mux_err_channel);
+    CHECKPOINT_FIELD(M[0], x_g_M);
+    CHECKPOINT_FIELD(M[1], y_g_M);
+    CHECKPOINT_FIELD(M[2], z_g_M);
+    CHECKPOINT_FIELD(CSS, g_CSS);
+    CHECKPOINT_FIELD(FSS, g_FSS);
+    CHECKPOINT_FIELD(FSS_RET, g_FSS_RET);
+    CHECKPOINT_FIELD(acs_ct, acs_ct);
+    CHECKPOINT_FIELD(tnow, g_tnow);
+    CHECKPOINT_FIELD(detumble_time, g_detumble_time);
+    CHECKPOINT_FIELD(detumble_est_time, g_detumble_est_time);
+    CHECKPOINT_FIELD(sunlock_time, g_sunlock_time);
+    CHECKPOINT_FIELD(mag_sched, g_mag_sched);
+    CHECKPOINT_FIELD(css_sched, g_css_sched);
+    CHECKPOINT_FIELD(fss_sched, g_fss_sched);
+    CHECKPOINT_FIELD(mag_sample, g_mag_sample);
+    CHECKPOINT_FIELD(css_sample, g_css_sample);
+    CHECKPOINT_FIELD(fss_sample, g_fss_sample);
+    CHECKPOINT_FIELD(fss_sample_ret, g_fss_sample_ret);
+    CHECKPOINT_FIELD(mag_dt, g_mag_dt);
+    CHECKPOINT_FIELD(rng, g_rng);
+    CHECKPOINT_FIELD(dyn, g_dyn);
+    CHECKPOINT_FIELD(dyn_params, g_dyn_params);
+    CHECKPOINT_FIELD(dyn_input, g_dyn_input);
+    CHECKPOINT_FIELD(orbit, g_orbit);
+    CHECKPOINT_FIELD(B_I, g_B_I);
+    CHECKPOINT_FIELD(S_I, g_S_I);
+    CHECKPOINT_FIELD(sun_frac, g_sun_frac);
+    CHECKPOINT_FIELD(eclipse, g_eclipse);
+#undef CHECKPOINT_COPY
+#undef CHECKPOINT_RING
+#undef CHECKPOINT_AXIS
+#undef CHECKPOINT_FIELD
+    return;
+}
+
+/**
+ * @brief Captures the simulation state. Call between two readSensors() calls, after the first one.
+ * 
+ * @param cp Checkpoint to fill
+ */
+void captureCheckpoint(acs_checkpoint_t *cp)
+{
+    memset(cp, 0, sizeof(acs_checkpoint_t)); // padding too, so that equal states give equal files
+    memcpy(cp->magic, ACS_CHECKPOINT_MAGIC, sizeof(cp->magic));
+    cp->version = ACS_CHECKPOINT_VERSION;
+    cp->size = sizeof(acs_checkpoint_t);
+    cp->time_step = DETUMBLE_TIME_STEP;
+    cp->buffer_depth = bessel_depth;
+    checkpointCopy(cp, 1);
+    return;
+}
+
+/**
+ * @brief Restores the simulation state from a checkpoint, after which readSensors() continues the run
+ * exactly where it was captured. The fault plan, if any, is replayed up to the restored step, so a
+ * checkpoint can seed branches with different fault draws.
+ * 
+ * @param cp Checkpoint
+ * @return int 1 on success, -1 if the checkpoint is invalid or was taken with a different loop period or buffer depth
+ */
+int restoreCheckpoint(const acs_checkpoint_t *cp)
+{
+    if (memcmp(cp->magic, ACS_CHECKPOINT_MAGIC, sizeof(cp->magic)) != 0 || cp->version != ACS_CHECKPOINT_VERSION || cp->size != sizeof(acs_checkpoint_t))
+    {
+        fprintf(stderr, "[CHECKPOINT] Not a version %d checkpoint\n", ACS_CHECKPOINT_VERSION);
+        return -1;
+    }
+    if (cp->time_step != DETUMBLE_TIME_STEP || cp->buffer_depth != bessel_depth)
+    {
+        fprintf(stderr, "[CHECKPOINT] Taken with time step %u usec and buffer depth %d, running with %u usec and %d\n",
+                cp->time_step, cp->buffer_depth, DETUMBLE_TIME_STEP, bessel_depth);
+        return -1;
+    }
+    if (!filters_ready)
+        initFilters();
+    if (initBuffers() < 0)
+        return -1;
+    checkpointCopy((acs_checkpoint_t *)cp, 0);
+    initField();
+    replayFaults();
+    first_run = 0; // the checkpoint holds the initialized state
+    return 1;
+}
+
+/**
+ * @brief Writes a checkpoint of the simulation state to a file.
+ * 
+ * @param path Checkpoint file
+ * @return int 1 on success, -1 on error
+ */
+int saveCheckpoint(const char *path)
+{
+    acs_checkpoint_t cp;
+    captureCheckpoint(&cp);
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL)
+    {
+        perror("[CHECKPOINT] fopen");
+        return -1;
+    }
+    int ret = fwrite(&cp, sizeof(cp), 1, fp) == 1 ? 1 : -1;
+    if (fclose(fp) != 0)
+        ret = -1;
+    if (ret < 0)
+        fprintf(stderr, "[CHECKPOINT] Could not write %s\n", path);
+    return ret;
+}
+
+/**
+ * @brief Reads a checkpoint file, with a single read into the fixed-layout checkpoint, and restores it.
+ * 
+ * @param path Checkpoint file
+ * @param cp Checkpoint read, kept for restoring it again (optional)
+ * @return int 1 on success, -1 on error
+ */
+int loadCheckpoint(const char *path, acs_checkpoint_t *cp)
+{
+    acs_checkpoint_t tmp;
+    if (cp == NULL)
+        cp = &tmp;
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        perror("[CHECKPOINT] fopen");
+        return -1;
+    }
+    size_t nread = fread(cp, sizeof(acs_checkpoint_t), 1, fp);
+    fclose(fp);
+    if (nread != 1)
+    {
+        fprintf(stderr, "[CHECKPOINT] %s is truncated\n", path);
+        return -1;
+    }
+    return restoreCheckpoint(cp);
+}
+
+/**
+ * @brief Starts a branch of a simulation from a snapshot taken with captureCheckpoint(), with its own noise
+ * seed. A branch with a different fault script sets g_faults to its plan before the call.
+ * 
+ * @param cp Snapshot to branch from
+ * @param seed Seed of the sensor noise of the branch
+ * @return int 1 on success, -1 if the snapshot cannot be restored
+ */
+int branchSim(const acs_checkpoint_t *cp, uint64_t seed)
+{
+    if (restoreCheckpoint(cp) < 0)
+        return -1;
+    seedRand(seed);
+    return 1;
+}
+
+/**
+ * @brief Forks n processes that continue the current simulation, sharing its memory copy-on-write
+ * (including the field model, its grid and any ephemeris), so that no state is copied until a branch
+ * writes to it. Each child reseeds the sensor noise with seed + its branch number and runs on its own;
+ * a child with a different fault script sets g_faults to its plan and calls replayFaults(). Children
+ * report their results back by a pipe or a file, and leave with _exit().
+ * 
+ * @param n Number of branches
+ * @param seed Base seed of the sensor noise of the branches
+ * @param pids Process IDs of the branches (parent only)
+ * @return int Branch number 0...n-1 in the children, n in the parent, -1 on error (branches already forked keep running)
+ */
+int forkBranches(int n, uint64_t seed, pid_t pids[])
+{
+    fflush(NULL); // buffered output would be written once per branch
+    for (int i = 0; i < n; i++)
+    {
+        pids[i] = fork();
+        if (pids[i] < 0)
+        {
+            perror("[BRANCH] fork");
+            return -1;
+        }
+        if (pids[i] == 0)
+        {
+            seedRand(seed + i);
+            return i;
+        }
+    }
+    return n;
+}
+
+int readSensors(void)
+{
+    // read magfield, CSS, FSS
+#ifdef ACS_PRINT
+    if (RING_COUNT(g_B) > 0)
+        printf("In readSensors(): acs count %llu, mag_index %d, Bx %lf By %lf Bz %lf tnow %lf...\n", acs_ct, RING_HEAD(g_B), x_g_B[RING_HEAD(g_B)], y_g_B[RING_HEAD(g_B)], z_g_B[RING_HEAD(g_B)], g_tnow);
+#endif // ACS_PRINT
+    if (first_run) // parameters of the simulated satellite
+    {
+        if (!matinv3(IMOI, MOI))
+            fprintf(stderr, "[ACS] MOI is singular, IMOI not updated\n");
+        dynamics_init(&g_dyn_params, MOI, IMOI);
+        orbit_from_elements(&g_orbit, &g_orbit_elements);
+        initField();
+        sensorsched_init(&g_mag_sched, MAG_PERIOD, MAG_LATENCY, (acs_ct + 1) * (uint64_t)DETUMBLE_TIME_STEP);
+        sensorsched_init(&g_css_sched, CSS_PERIOD, CSS_LATENCY, (acs_ct + 1) * (uint64_t)DETUMBLE_TIME_STEP);
+        sensorsched_init(&g_fss_sched, FSS_PERIOD, FSS_LATENCY, (acs_ct + 1) * (uint64_t)DETUMBLE_TIME_STEP);
+        g_mag_dt = MAG_PERIOD;
+        if (!filters_ready)
+            initFilters();
+        if (initBuffers() < 0)
+            return -1;
+        first_run = 0;
+    }
+    acs_ct++;
+    // advance the orbit to the end of this loop period, from the cached ephemeris if there is one
+    if (g_ephem != NULL)
+        orbit_ephem_eval(g_ephem, g_tnow + DETUMBLE_TIME_STEP * 1e-6, &g_orbit);
+    else
+        orbit_propagate(&g_orbit, DETUMBLE_TIME_STEP * 1e-6);
+    // sun and eclipse, the entry and exit times are predicted once per orbit
+    if (g_tnow + DETUMBLE_TIME_STEP * 1e-6 >= g_eclipse.t_end)
+    {
+        sun_eclipse_predict(&g_eclipse, &g_orbit, g_ephem, g_tnow + DETUMBLE_TIME_STEP * 1e-6, orbit_period(&g_orbit_elements),
+                            g_epoch_jd + (g_tnow + DETUMBLE_TIME_STEP * 1e-6) / 86400.0, g_shadow_model);
+        memcpy(g_S_I, g_eclipse.s, sizeof(g_S_I));
+    }
+    g_sun_frac = sun_illumination(&g_eclipse, g_orbit.r, g_tnow + DETUMBLE_TIME_STEP * 1e-6);
+    field_eval_eci(&g_field, g_orbit.r, field_era(g_epoch_jd + (g_tnow + DETUMBLE_TIME_STEP * 1e-6) / 86400.0), g_B_I);
+    for (int i = 0; i < 3; i++)
+    {
+        g_B_I[i] *= 1e-2;                     // nT -> mG
+        g_dyn_input.B_I[i] = g_B_I[i] * 1e-7; // mG -> T
+    }
+    // propagate the true attitude over one loop period, the dipole command is held over the period
+    dynamics_propagate(&g_dyn, &g_dyn_params, &g_dyn_input, DETUMBLE_TIME_STEP * 1e-6, g_dyn_substeps, g_dyn_integrator);
+    g_tnow += DETUMBLE_TIME_STEP * 1e-6; // 0.1 seconds
+    if (g_detumble_time < 0 && g_dyn.w[0] * g_dyn.w[0] + g_dyn.w[1] * g_dyn.w[1] + g_dyn.w[2] * g_dyn.w[2] < DETUMBLE_THRESHOLD * DETUMBLE_THRESHOLD)
+        g_detumble_time = g_tnow;
+    int status = 1;
+    uint64_t tnow = acs_ct * (uint64_t)DETUMBLE_TIME_STEP; // end of this loop period (usec)
+    // HITL
+    // advance the fault plan, this is a single comparison on steps without fault events
+    const fault_state_t *faults = NULL;
+    if (g_faults != NULL)
+    {
+        if (fault_step(g_faults, acs_ct))
+        {
+            for (int i = 0; i < 3; i++)
+                mux_err_channel[i] = g_faults->state.mux_err[i];
+        }
+        faults = g_faults->state.any ? &g_faults->state : NULL;
+    }
+    // sample the sensors that are due on this tick, the models of the others are skipped
+    int mag_due = sensorsched_sample(&g_mag_sched, tnow);
+    if (mag_due && (faults == NULL || !faults->mag_freeze)) // a frozen magnetometer repeats its last sample
+        readMag(g_mag_sample);
+    int css_due = sensorsched_sample(&g_css_sched, tnow);
+    int fss_due = sensorsched_sample(&g_fss_sched, tnow);
+    if (css_due || fss_due)
+    {
+        double sun_body[3];
+        dynamics_to_body(&g_dyn, g_S_I, sun_body); // true sun direction in the body frame
+        if (css_due)
+            readCSS(sun_body, g_css_sample);
+        if (fss_due)
+            g_fss_sample_ret = readFSS(sun_body, g_fss_sample);
+    }
+    if (faults != NULL)
+        applyFaults(faults, mag_due, css_due, fss_due);
+    // hand the samples whose latency has elapsed to the control loop
+    int sun_new = 0;
+    if (sensorsched_deliver(&g_css_sched, tnow))
+    {
+        memcpy(g_CSS, g_css_sample, sizeof(g_CSS));
+        sun_new = 1;
+    }
+    if (sensorsched_deliver(&g_fss_sched, tnow))
+    {
+        memcpy(g_FSS, g_fss_sample, sizeof(g_FSS));
+        g_FSS_RET = g_fss_sample_ret;
+        sun_new = 1;
+    }
+    if (sensorsched_deliver(&g_mag_sched, tnow))
+    {
+        if (g_mag_sched.count > 1)
+            g_mag_dt = g_mag_sched.stamp - g_mag_sched.stamp_prev;
+        int mag_index = RING_PUSH(g_B);
+        VECTOR_CLEAR(g_B[mag_index]); // clear the current B
+        DECLARE_VECTOR(mag_mes, double);
+        x_mag_mes = g_mag_sample[0]; // / 6.842;
+        y_mag_mes = g_mag_sample[1]; // / 6.842;
+        z_mag_mes = g_mag_sample[2]; // / 6.842;
+        x_g_B[mag_index] = x_mag_mes; // scaled to milliGauss
+        y_g_B[mag_index] = y_mag_mes;
+        z_g_B[mag_index] = z_mag_mes;
+        APPLY_DFILTER(&g_filter_B, g_B, mag_index);
+        WINSTAT_BUFFER(&g_stat_B, g_B, mag_index);
+#ifdef ACS_FIXEDPOINT
+        fxpMag();
+#endif
+
+        // printf("readSensors: Bx: %f By: %f Bz: %f\n", x_g_B[mag_index], y_g_B[mag_index], z_g_B[mag_index]);
+        if (RING_COUNT(g_B) > 1) // if we have > 1 values, calculate Bdot
+        {
+            int bdot_index = RING_PUSH(g_Bt);
+            int m1 = mag_index;
+            int m0 = RING_BACK(g_B, 1);
+            double freq = 1e6 / (g_mag_dt * 1.0); // actual interval between the two samples
+            VECTOR_OP(g_Bt[bdot_index], g_B[m1], g_B[m0], -);
+            VECTOR_MIXED(g_Bt[bdot_index], g_Bt[bdot_index], freq, *);
+            x_g_Bt_ctl = x_g_Bt[bdot_index]; // the controller acts on B-dot before its filter
+            y_g_Bt_ctl = y_g_Bt[bdot_index];
+            z_g_Bt_ctl = z_g_Bt[bdot_index];
+            APPLY_DFILTER(&g_filter_Bt, g_Bt, bdot_index);
+            WINSTAT_BUFFER(&g_stat_Bt, g_Bt, bdot_index);
+#ifdef ACS_FIXEDPOINT
+            fxpBdot(m1, m0, freq);
+#endif
+            // printf("readSensors: m0: %d m1: %d Btx: %f Bty: %f Btz: %f\n", m0, m1, x_g_Bt[bdot_index], y_g_Bt[bdot_index], z_g_Bt[bdot_index]);
+            getOmega();
+            if (g_acs_mode == 0) // detumble, the command is held until the next magnetometer sample
+                applyBdot();
+        }
+    }
+    if (sun_new)
+        getSVec();
+    if (g_first_detumble && acsDetumbled())
+    {
+        g_first_detumble = 0;
+        g_detumble_est_time = g_tnow;
+    }
+    if (g_sunlock_time < 0 && acsSunLocked())
+        g_sunlock_time = g_tnow;
+    // log data
+    // check if any of the values are NaN. If so, return -1
+    // the NaN may stem from Bdot = 0, which may stem from the fact that during sunpointing
+    // B may align itself with Z/ω
+    int mag_index = RING_HEAD(g_B), omega_index = RING_HEAD(g_W), sol_index = RING_HEAD(g_S);
+    if (RING_COUNT(g_B) > 0 && (isnan(x_g_B[mag_index]) || isnan(y_g_B[mag_index]) || isnan(z_g_B[mag_index])))
         return -1;
-    if (isnan(y_g_S[sol_index]))
+    if (RING_COUNT(g_W) > 0 && (isnan(x_g_W[omega_index]) || isnan(y_g_W[omega_index]) || isnan(z_g_W[omega_index])))
         return -1;
-    if (isnan(z_g_S[sol_index]))
+    if (RING_COUNT(g_S) > 0 && (isnan(x_g_S[sol_index]) || isnan(y_g_S[sol_index]) || isnan(z_g_S[sol_index])))
         return -1;
     return status;
 }
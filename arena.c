@@ -0,0 +1,54 @@
+/**
+ * @file arena.c
+ * @brief Bump allocator of the buffers of a simulation context.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <arena.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int arena_init(arena_t *a, size_t size)
+{
+    size = arena_round(size > 0 ? size : 1);
+    a->base = (uint8_t *)aligned_alloc(ARENA_ALIGN, size);
+    a->size = a->base != NULL ? size : 0;
+    a->used = 0;
+    if (a->base == NULL)
+    {
+        perror("[ARENA] aligned_alloc");
+        return -1;
+    }
+    return 1;
+}
+
+void *arena_alloc(arena_t *a, size_t bytes)
+{
+    bytes = arena_round(bytes);
+    if (a->base == NULL || bytes > a->size - a->used)
+    {
+        fprintf(stderr, "[ARENA] Exhausted, %zu of %zu bytes used, %zu requested\n", a->used, a->size, bytes);
+        return NULL;
+    }
+    void *ptr = a->base + a->used;
+    a->used += bytes;
+    memset(ptr, 0, bytes);
+    return ptr;
+}
+
+void arena_reset(arena_t *a)
+{
+    a->used = 0;
+    return;
+}
+
+void arena_free(arena_t *a)
+{
+    free(a->base);
+    memset(a, 0, sizeof(arena_t));
+    return;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file arena.h
+ * @brief Bump allocator of the buffers of a simulation context: one cache-aligned block, carved into
+ * cache-aligned arrays and released at once.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Alignment of the arena and of every array carved from it, a cache line.
+ *
+ */
+#define ARENA_ALIGN 64
+
+/**
+ * @brief Arena.
+ *
+ */
+typedef struct
+{
+    uint8_t *base; // block, NULL if not allocated
+    size_t size;   // bytes in the block
+    size_t used;   // bytes handed out
+} arena_t;
+
+/**
+ * @brief Bytes an array of the given size takes in an arena, rounded up to ARENA_ALIGN. Sum it over the arrays to
+ * size the arena.
+ *
+ */
+static inline size_t arena_round(size_t bytes)
+{
+    return (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+/**
+ * @brief Allocates the block of an arena.
+ *
+ * @param a Arena
+ * @param size Bytes, see arena_round()
+ * @return int 1 on success, -1 on error
+ */
+int arena_init(arena_t *a, size_t size);
+
+/**
+ * @brief Carves a zeroed array out of an arena.
+ *
+ * @param a Arena
+ * @param bytes Size of the array
+ * @return void* Array aligned to ARENA_ALIGN, NULL if the arena is exhausted
+ */
+void *arena_alloc(arena_t *a, size_t bytes);
+
+/**
+ * @brief Releases every array of an arena, keeping its block.
+ *
+ * @param a Arena
+ */
+void arena_reset(arena_t *a);
+
+/**
+ * @brief Frees the block of an arena. The arena can be initialized again.
+ *
+ * @param a Arena
+ */
+void arena_free(arena_t *a);
+
+#endif // __ARENA_H
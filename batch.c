@@ -0,0 +1,530 @@
+/**
+ * @file batch.c
+ * @brief Batch engine stepping many independent satellites in lockstep, in a structure-of-arrays layout
+ * with one satellite per SIMD lane.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <batch.h>
+#include <vecmath.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/**
+ * @brief Element of a circular buffer for the block of lanes starting at lane o. The buffers are stored block
+ * by block, each block holding its rows of BATCH_LANES lanes, so that filtering a block reads one contiguous
+ * stretch of memory.
+ *
+ */
+#define BATCH_ROW(b, buf, slot, o) ((buf) + (o) * (b)->rows + (slot) * BATCH_LANES)
+
+int batch_init(batch_t *b, int n, const batch_params_t *p)
+{
+    memset(b, 0, sizeof(batch_t));
+    if (n < 1 || p->depth < 4 || p->depth > SH_BUFFER_MAX || p->field == NULL || p->time_step == 0)
+    {
+        fprintf(stderr, "[BATCH] Invalid parameters\n");
+        return -1;
+    }
+    b->p = *p;
+    b->n = n;
+    b->nalloc = (n + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+    // taps used by dfilterBessel() and ffilterBessel(), the same for every sample
+    b->ntaps = 1;
+    while (b->ntaps < p->depth && p->coeff[b->ntaps] >= BESSEL_MIN_THRESHOLD)
+        b->ntaps++;
+    b->rows = ring_capacity(p->depth);
+    size_t lane_d = b->nalloc * sizeof(double), lane_f = b->nalloc * sizeof(float), lane_i = b->nalloc * sizeof(int);
+    // every array from one arena, cache-aligned so that every block of lanes starts on a vector boundary
+    size_t bytes = 5 * arena_round(lane_d) + 3 * arena_round(lane_i) +
+                   3 * (2 * arena_round(lane_d) + 2 * arena_round(b->rows * lane_d) + arena_round(b->rows * lane_f) + arena_round(lane_f));
+    if (arena_init(&b->arena, bytes) < 0)
+        return -1;
+    int err = 0;
+    for (int i = 0; i < 4; i++)
+        err |= (b->q[i] = (double *)arena_alloc(&b->arena, lane_d)) == NULL;
+    for (int i = 0; i < 3; i++)
+    {
+        err |= (b->w[i] = (double *)arena_alloc(&b->arena, lane_d)) == NULL;
+        err |= (b->m[i] = (double *)arena_alloc(&b->arena, lane_d)) == NULL;
+        err |= (b->B[i] = (double *)arena_alloc(&b->arena, b->rows * lane_d)) == NULL;
+        err |= (b->Bt[i] = (double *)arena_alloc(&b->arena, b->rows * lane_d)) == NULL;
+        err |= (b->W[i] = (float *)arena_alloc(&b->arena, b->rows * lane_f)) == NULL;
+        err |= (b->S[i] = (float *)arena_alloc(&b->arena, lane_f)) == NULL;
+    }
+    err |= (b->detumble_time = (double *)arena_alloc(&b->arena, lane_d)) == NULL;
+    err |= (b->rng = (uint32_t *)arena_alloc(&b->arena, b->nalloc * sizeof(uint32_t))) == NULL;
+    err |= (b->id = (int *)arena_alloc(&b->arena, b->nalloc * sizeof(int))) == NULL;
+    err |= (b->lane = (int *)arena_alloc(&b->arena, b->nalloc * sizeof(int))) == NULL;
+    if (err)
+    {
+        batch_free(b);
+        return -1;
+    }
+    for (int i = 0; i < b->nalloc; i++)
+    {
+        b->q[0][i] = 1;
+        b->detumble_time[i] = -1;
+        b->id[i] = i < n ? i : -1;
+        b->lane[i] = i;
+    }
+    b->live = n;
+    ring_reset(&b->B_ring, b->rows);
+    ring_reset(&b->Bt_ring, b->rows);
+    ring_reset(&b->W_ring, b->rows);
+    b->eclipse.t_end = -1;
+    b->sun_frac = 1;
+    b->S_I[0] = 1;
+    orbit_from_elements(&b->orbit, &p->orbit);
+    batch_seed(b, 1);
+    return 1;
+}
+
+void batch_set_state(batch_t *b, int i, const dyn_state_t *s)
+{
+    i = b->lane[i];
+    for (int j = 0; j < 4; j++)
+        b->q[j][i] = s->q[j];
+    for (int j = 0; j < 3; j++)
+        b->w[j][i] = s->w[j];
+}
+
+void batch_get_state(const batch_t *b, int i, dyn_state_t *s)
+{
+    i = b->lane[i];
+    for (int j = 0; j < 4; j++)
+        s->q[j] = b->q[j][i];
+    for (int j = 0; j < 3; j++)
+        s->w[j] = b->w[j][i];
+    s->h = 0;
+}
+
+void batch_seed(batch_t *b, uint64_t seed)
+{
+    for (int i = 0; i < b->nalloc; i++)
+    {
+        uint64_t z = seed + (i + 1) * 0x9E3779B97F4A7C15ULL; // splitmix64, one stream per lane
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        b->rng[b->lane[i]] = (uint32_t)z ? (uint32_t)z : 1; // the stream follows the satellite
+    }
+}
+
+/**
+ * @brief Draws uniform noise in [-0.5, 0.5) for every lane of a block.
+ *
+ * @param r Generator states of the block
+ * @param u Noise
+ */
+static inline void batch_noise(uint32_t r[BATCH_LANES], float u[BATCH_LANES])
+{
+    for (int l = 0; l < BATCH_LANES; l++)
+    {
+        uint32_t x = r[l];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        r[l] = x;
+        u[l] = (int32_t)(x >> 8) * 0x1.0p-24f - 0.5f;
+    }
+}
+
+/**
+ * @brief Rotates an inertial vector into the body frames of a block of lanes, as dynamics_to_body().
+ *
+ */
+static inline void batch_to_body(double q[4][BATCH_LANES], const double vi[3], double vb[3][BATCH_LANES])
+{
+    for (int l = 0; l < BATCH_LANES; l++)
+    {
+        double ux = -q[1][l], uy = -q[2][l], uz = -q[3][l];
+        double tx = 2 * (uy * vi[2] - uz * vi[1]);
+        double ty = 2 * (uz * vi[0] - ux * vi[2]);
+        double tz = 2 * (ux * vi[1] - uy * vi[0]);
+        vb[0][l] = vi[0] + q[0][l] * tx + (uy * tz - uz * ty);
+        vb[1][l] = vi[1] + q[0][l] * ty + (uz * tx - ux * tz);
+        vb[2][l] = vi[2] + q[0][l] * tz + (ux * ty - uy * tx);
+    }
+}
+
+/**
+ * @brief Time derivative of the attitude state of a block of lanes, as in dynamics.c.
+ *
+ */
+static inline void batch_derivative(const dyn_params_t *p, const double B_T[3], double y[7][BATCH_LANES], double m[3][BATCH_LANES], double dy[7][BATCH_LANES])
+{
+    double B[3][BATCH_LANES];
+    batch_to_body(y, B_T, B);
+    for (int l = 0; l < BATCH_LANES; l++)
+    {
+        double q0 = y[0][l], q1 = y[1][l], q2 = y[2][l], q3 = y[3][l];
+        double wx = y[4][l], wy = y[5][l], wz = y[6][l];
+        dy[0][l] = 0.5 * (-q1 * wx - q2 * wy - q3 * wz);
+        dy[1][l] = 0.5 * (q0 * wx + q2 * wz - q3 * wy);
+        dy[2][l] = 0.5 * (q0 * wy + q3 * wx - q1 * wz);
+        dy[3][l] = 0.5 * (q0 * wz + q1 * wy - q2 * wx);
+        double Lx = p->MOI[0][0] * wx + p->MOI[0][1] * wy + p->MOI[0][2] * wz;
+        double Ly = p->MOI[1][0] * wx + p->MOI[1][1] * wy + p->MOI[1][2] * wz;
+        double Lz = p->MOI[2][0] * wx + p->MOI[2][1] * wy + p->MOI[2][2] * wz;
+        double hx = (m[1][l] * B[2][l] - m[2][l] * B[1][l]) - (wy * Lz - wz * Ly); // m x B - w x L
+        double hy = (m[2][l] * B[0][l] - m[0][l] * B[2][l]) - (wz * Lx - wx * Lz);
+        double hz = (m[0][l] * B[1][l] - m[1][l] * B[0][l]) - (wx * Ly - wy * Lx);
+        dy[4][l] = p->IMOI[0][0] * hx + p->IMOI[0][1] * hy + p->IMOI[0][2] * hz;
+        dy[5][l] = p->IMOI[1][0] * hx + p->IMOI[1][1] * hy + p->IMOI[1][2] * hz;
+        dy[6][l] = p->IMOI[2][0] * hx + p->IMOI[2][1] * hy + p->IMOI[2][2] * hz;
+    }
+}
+
+/**
+ * @brief Fixed step 4th order Runge-Kutta over one step for a block of lanes, as dynamics_rk4().
+ *
+ */
+static inline void batch_rk4(const dyn_params_t *p, const double B_T[3], double y[7][BATCH_LANES], double m[3][BATCH_LANES], double h)
+{
+    double yt[7][BATCH_LANES], k1[7][BATCH_LANES], k2[7][BATCH_LANES], k3[7][BATCH_LANES], k4[7][BATCH_LANES];
+    batch_derivative(p, B_T, y, m, k1);
+    for (int i = 0; i < 7; i++)
+        for (int l = 0; l < BATCH_LANES; l++)
+            yt[i][l] = y[i][l] + 0.5 * h * k1[i][l];
+    batch_derivative(p, B_T, yt, m, k2);
+    for (int i = 0; i < 7; i++)
+        for (int l = 0; l < BATCH_LANES; l++)
+            yt[i][l] = y[i][l] + 0.5 * h * k2[i][l];
+    batch_derivative(p, B_T, yt, m, k3);
+    for (int i = 0; i < 7; i++)
+        for (int l = 0; l < BATCH_LANES; l++)
+            yt[i][l] = y[i][l] + h * k3[i][l];
+    batch_derivative(p, B_T, yt, m, k4);
+    for (int i = 0; i < 7; i++)
+        for (int l = 0; l < BATCH_LANES; l++)
+            y[i][l] += h / 6.0 * (k1[i][l] + 2 * k2[i][l] + 2 * k3[i][l] + k4[i][l]);
+    for (int l = 0; l < BATCH_LANES; l++) // renormalize the quaternion
+    {
+        double nq = 1.0 / sqrt(y[0][l] * y[0][l] + y[1][l] * y[1][l] + y[2][l] * y[2][l] + y[3][l] * y[3][l]);
+        for (int i = 0; i < 4; i++)
+            y[i][l] *= nq;
+    }
+}
+
+/**
+ * @brief Bessel filters the newest element of the three axes of a double precision buffer for a block of lanes,
+ * as dfilterBessel(). The axes are filtered together, which keeps three independent sums in flight.
+ *
+ * @param buf Axes of the buffer, see BATCH_ROW()
+ * @param slot Buffer elements of the taps, newest first
+ */
+static inline void batch_dfilter(const batch_t *b, double *buf[3], const int slot[], int o)
+{
+    double acc[3][BATCH_LANES] = {{0}}, csum = 0;
+    for (int k = 0; k < b->ntaps; k++)
+    {
+        double c = b->p.coeff[k];
+        for (int i = 0; i < 3; i++)
+        {
+            const double *row = BATCH_ROW(b, buf[i], slot[k], o);
+            for (int l = 0; l < BATCH_LANES; l++)
+                acc[i][l] += c * row[l];
+        }
+        csum += c;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        double *row = BATCH_ROW(b, buf[i], slot[0], o);
+        for (int l = 0; l < BATCH_LANES; l++)
+            row[l] = acc[i][l] / csum;
+    }
+}
+
+/**
+ * @brief Bessel filters the newest element of the three axes of a single precision buffer for a block of lanes,
+ * as ffilterBessel().
+ *
+ */
+static inline void batch_ffilter(const batch_t *b, float *buf[3], const int slot[], int o)
+{
+    float acc[3][BATCH_LANES] = {{0}}, csum = 0;
+    for (int k = 0; k < b->ntaps; k++)
+    {
+        float c = b->p.coeff[k];
+        for (int i = 0; i < 3; i++)
+        {
+            const float *row = BATCH_ROW(b, buf[i], slot[k], o);
+            for (int l = 0; l < BATCH_LANES; l++)
+                acc[i][l] += c * row[l];
+        }
+        csum += c;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        float *row = BATCH_ROW(b, buf[i], slot[0], o);
+        for (int l = 0; l < BATCH_LANES; l++)
+            row[l] = acc[i][l] / csum;
+    }
+}
+
+/**
+ * @brief Shared part of a step, computed once for the whole batch.
+ *
+ */
+typedef struct
+{
+    double t;                      // time at the end of the step (s)
+    double B_T[3];                 // inertial field (T)
+    int bdot;                      // new field derivative on this step
+    int omega;                     // new angular velocity estimate on this step
+    int mp, bp;                    // previous rows of the field and derivative buffers
+    int slot_B[SH_BUFFER_MAX];     // filter taps in the field buffer
+    int slot_Bt[SH_BUFFER_MAX];    // filter taps in the derivative buffer
+    int slot_W[SH_BUFFER_MAX];     // filter taps in the angular velocity buffer
+} batch_shared_t;
+
+/**
+ * @brief Steps one block of BATCH_LANES satellites.
+ *
+ * @param b Batch
+ * @param c Shared part of the step
+ * @param o First lane of the block
+ * @param n Lanes of the block stepped, at most BATCH_LANES; the state of the lanes past them is computed with the
+ * others but not written back, only their filter histories take the rows of this step
+ * @return int Satellites of the block not yet detumbled
+ */
+static int batch_block(batch_t *b, const batch_shared_t *c, int o, int n)
+{
+    const batch_params_t *p = &b->p;
+    double y[7][BATCH_LANES], m[3][BATCH_LANES];
+    uint32_t r[BATCH_LANES];
+    float u[BATCH_LANES];
+    for (int l = 0; l < BATCH_LANES; l++)
+    {
+        for (int i = 0; i < 4; i++)
+            y[i][l] = b->q[i][o + l];
+        for (int i = 0; i < 3; i++)
+        {
+            y[4 + i][l] = b->w[i][o + l];
+            m[i][l] = b->m[i][o + l];
+        }
+        r[l] = b->rng[o + l];
+    }
+    // true attitude over the loop period, under the held dipole command
+    double h = p->time_step * 1e-6 / (p->substeps < 1 ? 1 : p->substeps);
+    for (int s = 0; s < (p->substeps < 1 ? 1 : p->substeps); s++)
+        batch_rk4(&p->dyn, c->B_T, y, m, h);
+    int remaining = 0;
+    for (int l = 0; l < n; l++)
+    {
+        for (int i = 0; i < 4; i++)
+            b->q[i][o + l] = y[i][l];
+        for (int i = 0; i < 3; i++)
+            b->w[i][o + l] = y[4 + i][l];
+        double w2 = y[4][l] * y[4][l] + y[5][l] * y[5][l] + y[6][l] * y[6][l];
+        if (b->detumble_time[o + l] < 0 && w2 < (double)p->detumble_threshold * p->detumble_threshold)
+            b->detumble_time[o + l] = c->t;
+        remaining += b->id[o + l] >= 0 && b->detumble_time[o + l] < 0;
+    }
+    // magnetometer, the true field in the body frame plus noise
+    double Bb[3][BATCH_LANES];
+    batch_to_body(y, b->B_I, Bb);
+    for (int i = 0; i < 3; i++)
+    {
+        batch_noise(r, u);
+        double *row = BATCH_ROW(b, b->B[i], c->slot_B[0], o);
+        for (int l = 0; l < BATCH_LANES; l++)
+            row[l] = Bb[i][l] + p->mag_noise * (double)u[l];
+    }
+    batch_dfilter(b, b->B, c->slot_B, o);
+    if (c->bdot) // B-dot, and the detumble command held until the next sample
+    {
+        double freq = 1e6 / (p->time_step * 1.0);
+        for (int i = 0; i < 3; i++)
+        {
+            const double *b1 = BATCH_ROW(b, b->B[i], c->slot_B[0], o), *b0 = BATCH_ROW(b, b->B[i], c->mp, o);
+            double *row = BATCH_ROW(b, b->Bt[i], c->slot_Bt[0], o);
+            for (int l = 0; l < BATCH_LANES; l++)
+                row[l] = (b1[l] - b0[l]) * freq;
+        }
+        const double *x1 = BATCH_ROW(b, b->Bt[0], c->slot_Bt[0], o), *y1 = BATCH_ROW(b, b->Bt[1], c->slot_Bt[0], o), *z1 = BATCH_ROW(b, b->Bt[2], c->slot_Bt[0], o);
+        for (int l = 0; l < n; l++) // m = -k dB/dt before the B-dot filter, saturated keeping its direction
+        {
+            float mx = x1[l] * -p->gain, my = y1[l] * -p->gain, mz = z1[l] * -p->gain;
+            float m_max = fabsf(mx) > fabsf(my) ? fabsf(mx) : fabsf(my);
+            m_max = fabsf(mz) > m_max ? fabsf(mz) : m_max;
+            float sat = m_max > p->dipole_max ? p->dipole_max / m_max : 1;
+            mx *= sat;
+            my *= sat;
+            mz *= sat;
+            int ok = isfinite(mx) && isfinite(my) && isfinite(mz); // the torquer driver rejects invalid commands
+            b->m[0][o + l] = ok ? mx : 0;
+            b->m[1][o + l] = ok ? my : 0;
+            b->m[2][o + l] = ok ? mz : 0;
+        }
+        batch_dfilter(b, b->Bt, c->slot_Bt, o);
+        if (c->omega) // omega = (B_t dot x B_t-dt dot) freq / Norm2(B_t-dt dot)
+        {
+            const double *x0 = BATCH_ROW(b, b->Bt[0], c->bp, o), *y0 = BATCH_ROW(b, b->Bt[1], c->bp, o), *z0 = BATCH_ROW(b, b->Bt[2], c->bp, o);
+            float *wx = BATCH_ROW(b, b->W[0], c->slot_W[0], o), *wy = BATCH_ROW(b, b->W[1], c->slot_W[0], o), *wz = BATCH_ROW(b, b->W[2], c->slot_W[0], o);
+            float ffreq = 1e6 / p->time_step;
+            for (int l = 0; l < BATCH_LANES; l++)
+            {
+                wx[l] = y1[l] * z0[l] - z1[l] * y0[l];
+                wy[l] = z1[l] * x0[l] - x1[l] * z0[l];
+                wz[l] = x1[l] * y0[l] - y1[l] * x0[l];
+                float norm2 = x0[l] * x0[l] + y0[l] * y0[l] + z0[l] * z0[l];
+                float scale = ffreq / norm2;
+                wx[l] *= scale;
+                wy[l] *= scale;
+                wz[l] *= scale;
+            }
+            batch_ffilter(b, b->W, c->slot_W, o);
+        }
+    }
+    // coarse sun sensors, and the sun vector from them
+    double sb[3][BATCH_LANES];
+    batch_to_body(y, b->S_I, sb);
+    float css[7][BATCH_LANES];
+    for (int i = 0; i < 7; i++)
+    {
+        static const int axis[7] = {0, 0, 1, 1, 2, 2, 2};
+        static const double sign[7] = {1, -1, 1, -1, 1, -1, -1};
+        batch_noise(r, u);
+        for (int l = 0; l < BATCH_LANES; l++)
+        {
+            double cos_inc = sign[i] * sb[axis[i]][l];
+            css[i][l] = p->css_max_lux * b->sun_frac * (cos_inc > 0 ? cos_inc : 0) + p->css_noise * (double)u[l];
+        }
+    }
+    for (int l = 0; l < n; l++)
+    {
+        float sx = css[0][l] - css[1][l], sy = css[2][l] - css[3][l], sz = css[4][l] - 0.5f * (css[5][l] + css[6][l]);
+        float night = sx * sx + sy * sy + sz * sz < p->css_min_lux * p->css_min_lux ? 0 : 1; // night: 0 sun vector
+        b->S[0][o + l] = sx * night; // normalized for the whole batch in batch_step()
+        b->S[1][o + l] = sy * night;
+        b->S[2][o + l] = sz * night;
+        b->rng[o + l] = r[l];
+    }
+    return remaining;
+}
+
+/**
+ * @brief Swaps the satellites in two lanes, with their whole state and buffer histories.
+ *
+ * @param b Batch
+ * @param i First lane
+ * @param j Second lane
+ */
+static void batch_swap(batch_t *b, int i, int j)
+{
+    if (i == j)
+        return;
+#define BATCH_SWAP(type, arr)    \
+    do                           \
+    {                            \
+        type tmp = (arr)[i];     \
+        (arr)[i] = (arr)[j];     \
+        (arr)[j] = tmp;          \
+    } while (0)
+    for (int k = 0; k < 4; k++)
+        BATCH_SWAP(double, b->q[k]);
+    for (int k = 0; k < 3; k++)
+    {
+        BATCH_SWAP(double, b->w[k]);
+        BATCH_SWAP(double, b->m[k]);
+        BATCH_SWAP(float, b->S[k]);
+        for (int slot = 0; slot < b->rows; slot++)
+        {
+            double *ri = BATCH_ROW(b, b->B[k], slot, i / BATCH_LANES * BATCH_LANES), *rj = BATCH_ROW(b, b->B[k], slot, j / BATCH_LANES * BATCH_LANES);
+            double tmp = ri[i % BATCH_LANES];
+            ri[i % BATCH_LANES] = rj[j % BATCH_LANES];
+            rj[j % BATCH_LANES] = tmp;
+            ri = BATCH_ROW(b, b->Bt[k], slot, i / BATCH_LANES * BATCH_LANES);
+            rj = BATCH_ROW(b, b->Bt[k], slot, j / BATCH_LANES * BATCH_LANES);
+            tmp = ri[i % BATCH_LANES];
+            ri[i % BATCH_LANES] = rj[j % BATCH_LANES];
+            rj[j % BATCH_LANES] = tmp;
+            float *fi = BATCH_ROW(b, b->W[k], slot, i / BATCH_LANES * BATCH_LANES), *fj = BATCH_ROW(b, b->W[k], slot, j / BATCH_LANES * BATCH_LANES);
+            float ftmp = fi[i % BATCH_LANES];
+            fi[i % BATCH_LANES] = fj[j % BATCH_LANES];
+            fj[j % BATCH_LANES] = ftmp;
+        }
+    }
+    BATCH_SWAP(double, b->detumble_time);
+    BATCH_SWAP(uint32_t, b->rng);
+    BATCH_SWAP(int, b->id);
+#undef BATCH_SWAP
+    if (b->id[i] >= 0)
+        b->lane[b->id[i]] = i;
+    if (b->id[j] >= 0)
+        b->lane[b->id[j]] = j;
+}
+
+int batch_step(batch_t *b)
+{
+    const batch_params_t *p = &b->p;
+    double dt = p->time_step * 1e-6;
+    batch_shared_t c;
+    c.t = b->t + dt;
+    // environment, once for the whole batch
+    if (p->ephem != NULL)
+        orbit_ephem_eval(p->ephem, c.t, &b->orbit);
+    else
+        orbit_propagate(&b->orbit, dt);
+    if (c.t >= b->eclipse.t_end)
+    {
+        sun_eclipse_predict(&b->eclipse, &b->orbit, p->ephem, c.t, orbit_period(&p->orbit), p->epoch_jd + c.t / 86400.0, p->shadow);
+        memcpy(b->S_I, b->eclipse.s, sizeof(b->S_I));
+    }
+    b->sun_frac = sun_illumination(&b->eclipse, b->orbit.r, c.t);
+    field_eval_eci(p->field, b->orbit.r, field_era(p->epoch_jd + c.t / 86400.0), b->B_I);
+    for (int i = 0; i < 3; i++)
+    {
+        b->B_I[i] *= 1e-2;          // nT -> mG
+        c.B_T[i] = b->B_I[i] * 1e-7; // mG -> T
+    }
+    b->t = c.t;
+    b->ct++;
+    // buffer positions, in lockstep for all satellites
+    ring_push(&b->B_ring);
+    c.mp = ring_back(&b->B_ring, 1);
+    c.bdot = b->B_ring.count > 1;
+    c.omega = 0;
+    if (c.bdot)
+    {
+        ring_push(&b->Bt_ring);
+        c.bp = ring_back(&b->Bt_ring, 1);
+        c.omega = b->B_ring.count > 2;
+        if (c.omega)
+            ring_push(&b->W_ring);
+    }
+    for (int k = 0; k < b->ntaps; k++)
+    {
+        c.slot_B[k] = ring_back(&b->B_ring, k);
+        c.slot_Bt[k] = ring_back(&b->Bt_ring, k);
+        c.slot_W[k] = ring_back(&b->W_ring, k);
+    }
+    int remaining = 0;
+    for (int o = 0; o < b->live; o += BATCH_LANES)
+        remaining += batch_block(b, &c, o, b->live - o < BATCH_LANES ? b->live - o : BATCH_LANES);
+    vec_normalize3f(b->S[0], b->S[1], b->S[2], b->S[0], b->S[1], b->S[2], b->live); // sun vectors, the null vectors of the night stay null
+    if (p->stop_detumbled) // move the detumbled satellites out of the stepped lanes
+    {
+        for (int i = 0; i < b->live;)
+        {
+            if (b->detumble_time[i] >= 0 || b->id[i] < 0)
+                batch_swap(b, i, --b->live);
+            else
+                i++;
+        }
+    }
+    return remaining;
+}
+
+void batch_free(batch_t *b)
+{
+    arena_free(&b->arena);
+    memset(b, 0, sizeof(batch_t));
+}
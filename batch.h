@@ -0,0 +1,166 @@
+/**
+ * @file batch.h
+ * @brief Batch engine stepping many independent satellites in lockstep, in a structure-of-arrays layout
+ * with one satellite per SIMD lane.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __BATCH_H
+#define __BATCH_H
+
+#include <stdint.h>
+#include "bessel.h"
+#include "ring.h"
+#include "dynamics.h"
+#include "orbit.h"
+#include "magfield.h"
+#include "sun.h"
+
+#ifndef BATCH_LANES
+/**
+ * @brief Satellites processed together by the inner loops, 8 floats or 4 doubles per AVX2 register.
+ * The number of satellites in a batch is padded to a multiple of this.
+ *
+ */
+#define BATCH_LANES 8
+#endif
+
+/**
+ * @brief Parameters shared by all satellites of a batch. acs-datagen.h fills them from the scenario with batchParams().
+ *
+ */
+typedef struct
+{
+    uint32_t time_step;         // ACS loop period (usec), the magnetometer and sun sensors are sampled every period
+    int substeps;               // fixed RK4 steps per loop period
+    dyn_params_t dyn;           // rigid-body parameters
+    float dipole_max;           // magnetorquer saturation (A m^2)
+    float gain;                 // B-dot gain (A m^2 per mG s^-1)
+    float detumble_threshold;   // rate below which a satellite is detumbled (rad s^-1)
+    int depth;                  // samples the filters read back from the circular buffers, at most SH_BUFFER_MAX
+    float coeff[SH_BUFFER_MAX]; // Bessel filter coefficients, depth of them in use
+    float mag_noise;            // magnetometer noise, peak to peak (mG)
+    float css_max_lux;          // coarse sun sensor reading under full, normal incidence sun (lux)
+    float css_noise;            // coarse sun sensor noise, peak to peak (lux)
+    float css_min_lux;          // smallest sun vector magnitude taken as day (lux)
+    orbit_elements_t orbit;     // common orbit
+    const orbit_ephem_t *ephem; // cached ephemeris of the orbit, NULL to propagate it
+    double epoch_jd;            // Julian date at the start (UT1)
+    sun_shadow_model shadow;    // Earth shadow model
+    const field_model_t *field; // geomagnetic field model, loaded
+    int stop_detumbled;         // stop stepping the satellites that have detumbled, see batch_step()
+} batch_params_t;
+
+/**
+ * @brief A batch of satellites. Every per-satellite quantity is an array over the lanes; the circular
+ * buffers are stored block by block (see BATCH_ROW() in batch.c). Buffer positions and the environment (orbit,
+ * field, sun) are shared, so the field model is evaluated once per step for the whole batch.
+ *
+ */
+typedef struct
+{
+    batch_params_t p;
+    int n;      // satellites
+    int nalloc; // lanes allocated, n padded to a multiple of BATCH_LANES
+    int ntaps;  // Bessel filter taps
+    double t;   // simulation time (s)
+    uint64_t ct; // ACS steps
+    // shared environment
+    orbit_state_t orbit;
+    sun_eclipse_t eclipse;
+    double sun_frac;
+    double B_I[3]; // inertial field (mG)
+    double S_I[3]; // inertial sun direction
+    // shared buffer state
+    int rows; // rows of the circular buffers, depth rounded up to a power of 2
+    arena_t arena; // storage of the per satellite arrays
+    ring_t B_ring, Bt_ring, W_ring;
+    // per satellite
+    double *q[4];            // true attitude
+    double *w[3];            // true angular velocity (rad s^-1)
+    double *m[3];            // dipole command (A m^2)
+    double *B[3];            // filtered field (mG), circular over the rows
+    double *Bt[3];           // filtered field derivative (mG s^-1), circular over the rows
+    float *W[3];             // filtered angular velocity estimate (rad s^-1), circular over the rows
+    float *S[3];             // sun vector, 0 at night
+    double *detumble_time;   // time of the first true rate below the threshold (s), -1 if not yet
+    uint32_t *rng;           // noise generator states (xorshift32)
+    int *id;                 // satellite in each lane, -1 for padding
+    int *lane;               // lane of each satellite
+    int live;                // lanes stepped, the satellites in lanes [0, live) are not yet detumbled
+} batch_t;
+
+/**
+ * @brief Allocates a batch. Satellite i starts in lane i; all satellites start in the identity attitude at rest; set their states with batch_set_state().
+ *
+ * @param b Batch
+ * @param n Number of satellites
+ * @param p Parameters, copied
+ * @return int 1 on success, -1 on error
+ */
+int batch_init(batch_t *b, int n, const batch_params_t *p);
+
+/**
+ * @brief Sets the true attitude and angular velocity of a satellite.
+ *
+ * @param b Batch
+ * @param i Satellite
+ * @param s State
+ */
+void batch_set_state(batch_t *b, int i, const dyn_state_t *s);
+
+/**
+ * @brief Gets the true attitude and angular velocity of a satellite.
+ *
+ * @param b Batch
+ * @param i Satellite
+ * @param s State
+ */
+void batch_get_state(const batch_t *b, int i, dyn_state_t *s);
+
+/**
+ * @brief Seeds the sensor noise of every satellite, each with its own stream.
+ *
+ * @param b Batch
+ * @param seed Seed
+ */
+void batch_seed(batch_t *b, uint64_t seed);
+
+/**
+ * @brief Runs one ACS loop period for every satellite: propagation of the attitude under the held dipole
+ * command, magnetometer, Bessel filtering, B-dot differentiation, angular velocity estimate, B-dot control
+ * and the coarse sun sensor sun vector.
+ *
+ * With stop_detumbled set, the satellites that have detumbled are swapped with the last lanes still
+ * stepped, so that blocks are never stepped for a few stragglers; their states are kept but frozen. The
+ * frozen lanes that share the last block with stepped ones are computed with it, but their attitude, rate,
+ * dipole command, sun vector and noise stream are not written back.
+ *
+ * @param b Batch
+ * @return int Number of satellites not yet detumbled
+ */
+int batch_step(batch_t *b);
+
+/**
+ * @brief Returns the time at which a satellite detumbled.
+ *
+ * @param b Batch
+ * @param i Satellite
+ * @return double Time of the first true rate below the threshold (s), -1 if not yet
+ */
+static inline double batch_detumble_time(const batch_t *b, int i)
+{
+    return b->detumble_time[b->lane[i]];
+}
+
+/**
+ * @brief Frees a batch.
+ *
+ * @param b Batch
+ */
+void batch_free(batch_t *b);
+
+#endif // __BATCH_H
@@ -0,0 +1,220 @@
+/**
+ * @file bench.h
+ * @brief Minimal microbenchmark harness with warm-up, repetitions and machine-readable output.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "dynamics.h"
+
+/**
+ * @brief Declares a vector buffer of SH_BUFFER_SIZE elements per axis, x_name, y_name and z_name, for the inputs
+ * and outputs of the kernel benchmarks.
+ *
+ * @param name Name of the buffer
+ * @param type Data type of the buffer
+ */
+#define BENCH_BUFFER(name, type) \
+    type x_##name[SH_BUFFER_SIZE], y_##name[SH_BUFFER_SIZE], z_##name[SH_BUFFER_SIZE]
+
+#ifndef BENCH_WARMUP_NS
+/**
+ * @brief Time spent running a kernel before any measurement is taken (ns).
+ *
+ */
+#define BENCH_WARMUP_NS 50000000ULL // 50 ms
+#endif
+
+#ifndef BENCH_REP_NS
+/**
+ * @brief Target duration of a single timed repetition (ns).
+ *
+ */
+#define BENCH_REP_NS 10000000ULL // 10 ms
+#endif
+
+#ifndef BENCH_REPS
+/**
+ * @brief Number of timed repetitions per kernel.
+ *
+ */
+#define BENCH_REPS 20
+#endif
+
+/**
+ * @brief Prevents the compiler from optimizing away a value computed by a kernel.
+ *
+ */
+#define BENCH_ESCAPE(val) __asm__ volatile("" : : "g"(val) : "memory")
+
+/**
+ * @brief Forces the compiler to assume all memory has been read and written.
+ *
+ */
+#define BENCH_CLOBBER() __asm__ volatile("" : : : "memory")
+
+/**
+ * @brief Benchmark kernel, executes the operation under test iters times.
+ *
+ */
+typedef void (*bench_fn)(void *ctx, uint64_t iters);
+
+/**
+ * @brief Result of a benchmark, all times in ns per operation.
+ *
+ */
+typedef struct
+{
+    const char *name;
+    uint64_t iters; // operations per repetition
+    int reps;       // number of timed repetitions
+    double mean;
+    double stddev;
+    double min;
+    double max;
+} bench_result;
+
+/**
+ * @brief Returns monotonic time in nanoseconds.
+ *
+ * @return uint64_t Nanoseconds from an arbitrary epoch
+ */
+static inline uint64_t bench_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Warms up a kernel, calibrates the number of operations per repetition and times BENCH_REPS repetitions.
+ *
+ * @param name Name of the benchmark
+ * @param fn Kernel
+ * @param ctx Context passed to the kernel
+ * @return bench_result Timing statistics in ns/op
+ */
+static inline bench_result bench_run(const char *name, bench_fn fn, void *ctx)
+{
+    bench_result res;
+    memset(&res, 0, sizeof(res));
+    res.name = name;
+    // warm-up, doubling the batch size until one batch takes at least 1/10th of a repetition
+    uint64_t iters = 1;
+    uint64_t tstart = bench_nsec(), dt = 0;
+    for (;;)
+    {
+        uint64_t t0 = bench_nsec();
+        fn(ctx, iters);
+        dt = bench_nsec() - t0;
+        if (dt < BENCH_REP_NS / 10)
+            iters *= 2;
+        else if (bench_nsec() - tstart >= BENCH_WARMUP_NS)
+            break;
+    }
+    // calibrate so that one repetition takes about BENCH_REP_NS
+    iters = (uint64_t)((double)iters * BENCH_REP_NS / (dt > 0 ? dt : 1));
+    iters = iters > 0 ? iters : 1;
+    res.iters = iters;
+    res.reps = BENCH_REPS;
+    res.min = INFINITY;
+    double sum = 0, sum2 = 0;
+    for (int i = 0; i < BENCH_REPS; i++)
+    {
+        uint64_t t0 = bench_nsec();
+        fn(ctx, iters);
+        double ns = (double)(bench_nsec() - t0) / iters;
+        sum += ns;
+        sum2 += ns * ns;
+        res.min = ns < res.min ? ns : res.min;
+        res.max = ns > res.max ? ns : res.max;
+    }
+    res.mean = sum / BENCH_REPS;
+    double var = (sum2 - sum * sum / BENCH_REPS) / (BENCH_REPS - 1);
+    res.stddev = var > 0 ? sqrt(var) : 0;
+    return res;
+}
+
+/**
+ * @brief Prints the header of the human-readable result table.
+ *
+ */
+static inline void bench_print_header(void)
+{
+    printf("%-28s %12s %10s %12s %12s %12s\n", "benchmark", "ns/op", "cv %", "min", "max", "ops/rep");
+}
+
+/**
+ * @brief Prints a result as a row of the human-readable table.
+ *
+ * @param res Benchmark result
+ */
+static inline void bench_print(const bench_result *res)
+{
+    printf("%-28s %12.3f %10.2f %12.3f %12.3f %12llu\n", res->name, res->mean,
+           res->mean > 0 ? 100.0 * res->stddev / res->mean : 0, res->min, res->max,
+           (unsigned long long)res->iters);
+}
+
+/**
+ * @brief Writes a result as one JSON object per line, suitable for tracking regressions.
+ *
+ * @param fp Output file
+ * @param suite Name of the benchmark suite
+ * @param res Benchmark result
+ */
+static inline void bench_write_json(FILE *fp, const char *suite, const bench_result *res)
+{
+    if (fp == NULL)
+        return;
+    fprintf(fp, "{\"suite\":\"%s\",\"name\":\"%s\",\"unit\":\"ns/op\",\"mean\":%.4f,\"stddev\":%.4f,"
+                "\"min\":%.4f,\"max\":%.4f,\"reps\":%d,\"iters\":%llu,\"time\":%lld}\n",
+            suite, res->name, res->mean, res->stddev, res->min, res->max, res->reps,
+            (unsigned long long)res->iters, (long long)time(NULL));
+}
+
+/**
+ * @brief Returns a pseudo-random number uniform in [0, 1], from rand().
+ *
+ */
+static inline double bench_uniform(void)
+{
+    return (1.0 * rand()) / RAND_MAX;
+}
+
+/**
+ * @brief Draws a random initial state from rand(): uniformly distributed attitude, rate of uniformly distributed
+ * direction and a magnitude uniform in [w_min, w_max].
+ *
+ * @param s State to initialize
+ * @param w_min Minimum initial rate (rad s^-1)
+ * @param w_max Maximum initial rate (rad s^-1)
+ */
+static inline void bench_random_state(dyn_state_t *s, double w_min, double w_max)
+{
+    // Shoemake's uniform random rotation
+    double u1 = bench_uniform(), u2 = 2 * M_PI * bench_uniform(), u3 = 2 * M_PI * bench_uniform();
+    s->q[0] = sqrt(1 - u1) * sin(u2);
+    s->q[1] = sqrt(1 - u1) * cos(u2);
+    s->q[2] = sqrt(u1) * sin(u3);
+    s->q[3] = sqrt(u1) * cos(u3);
+    double z = 2 * bench_uniform() - 1, phi = 2 * M_PI * bench_uniform();
+    double r = sqrt(1 - z * z), w = w_min + (w_max - w_min) * bench_uniform();
+    s->w[0] = w * r * cos(phi);
+    s->w[1] = w * r * sin(phi);
+    s->w[2] = w * z;
+    s->h = 0;
+}
+
+#endif // __BENCH_H
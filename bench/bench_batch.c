@@ -0,0 +1,199 @@
+/**
+ * @file bench_batch.c
+ * @brief Batch engine benchmark. Detumbles many satellites from random initial tumbles with the batch
+ * engine, one satellite per SIMD lane, and with the scalar simulation one satellite at a time, and
+ * compares the throughput and the detumble time distributions.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <unistd.h>
+#include "bench/bench.h"
+#include "acs-datagen.h"
+
+/**
+ * @brief Mean and median of the detumble times, ignoring the satellites that did not detumble.
+ *
+ * @return int Number of satellites that detumbled
+ */
+static int detumble_stats(const double *t, int n, double *mean, double *p50)
+{
+    double *s = (double *)malloc(n * sizeof(double));
+    int k = 0;
+    *mean = 0;
+    for (int i = 0; i < n; i++)
+        if (t[i] >= 0)
+        {
+            s[k++] = t[i];
+            *mean += t[i];
+        }
+    *mean = k > 0 ? *mean / k : 0;
+    // insertion sort, the arrays are small
+    for (int i = 1; i < k; i++)
+        for (int j = i; j > 0 && s[j - 1] > s[j]; j--)
+        {
+            double tmp = s[j];
+            s[j] = s[j - 1];
+            s[j - 1] = tmp;
+        }
+    *p50 = k > 0 ? s[k / 2] : 0;
+    free(s);
+    return k;
+}
+
+int main(int argc, char *argv[])
+{
+    int n = 256;      // satellites in the batch
+    int scalar = 32;  // satellites also run by the scalar simulation, as the baseline
+    unsigned int seed = 1;
+    double t_max = 4 * 3600;
+    double w_min = 0.02, w_max = 0.15;
+    int use_ephem = 0;
+    const char *outfile = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:c:s:t:w:W:eo:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            if (loadScenario(optarg) < 0)
+                return 1;
+            seed = g_scenario.seed;
+            break;
+        case 'n':
+            n = atoi(optarg);
+            break;
+        case 'c':
+            scalar = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            t_max = atof(optarg);
+            break;
+        case 'w':
+            w_min = atof(optarg);
+            break;
+        case 'W':
+            w_max = atof(optarg);
+            break;
+        case 'e':
+            use_ephem = 1;
+            break;
+        case 'o':
+            outfile = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-i scenario.ini] [-n satellites] [-c scalar satellites] [-s seed] [-t max sim time (s)] [-w min rate] [-W max rate (rad/s)] [-e] [-o results.json]\n"
+                            "\t-c: number of satellites also run one at a time by the scalar simulation\n"
+                            "\t-e: use one cached ephemeris instead of propagating the orbit\n"
+                            "\tOptions are applied in order, so options after -i override the scenario.\n",
+                    argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    n = n < 1 ? 1 : n;
+    scalar = scalar < 0 ? 0 : (scalar > n ? n : scalar);
+    calculateBessel(bessel_coeff, besselSize(), g_scenario.bessel_order, g_scenario.bessel_cutoff);
+    orbit_ephem_t eph;
+    if (use_ephem)
+    {
+        orbit_state_t init;
+        orbit_from_elements(&init, &g_orbit_elements);
+        if (orbit_ephem_build(&eph, &init, orbit_period(&g_orbit_elements), 0) < 0)
+            return 1;
+        g_ephem = &eph;
+    }
+    dyn_state_t *init = (dyn_state_t *)malloc(n * sizeof(dyn_state_t));
+    double *t_scalar = (double *)malloc((scalar > 0 ? scalar : 1) * sizeof(double));
+    if (init == NULL || t_scalar == NULL)
+    {
+        perror("[BENCH] malloc");
+        return 1;
+    }
+    srand(seed);
+    for (int i = 0; i < n; i++)
+        bench_random_state(&init[i], w_min, w_max);
+
+    // batch, every satellite in a lane
+    batch_params_t bp;
+    batchParams(&bp);
+    bp.stop_detumbled = 1;
+    batch_t b;
+    if (batch_init(&b, n, &bp) < 0)
+        return 1;
+    batch_seed(&b, seed);
+    for (int i = 0; i < n; i++)
+        batch_set_state(&b, i, &init[i]);
+    uint64_t t0 = bench_nsec();
+    int left = n;
+    while (left > 0 && b.t < t_max)
+        left = batch_step(&b);
+    double wall_batch = (bench_nsec() - t0) * 1e-9;
+    uint64_t batch_steps = b.ct;
+
+    // scalar, one satellite at a time
+    uint64_t scalar_steps = 0;
+    t0 = bench_nsec();
+    for (int i = 0; i < scalar; i++)
+    {
+        seedRand(seed + i);
+        resetSim(&init[i]);
+        while (g_detumble_time < 0 && g_tnow < t_max)
+            readSensors();
+        scalar_steps += acs_ct;
+        t_scalar[i] = g_detumble_time;
+    }
+    double wall_scalar = (bench_nsec() - t0) * 1e-9;
+
+    double *t_batch = (double *)malloc(n * sizeof(double));
+    if (t_batch == NULL)
+    {
+        perror("[BENCH] malloc");
+        return 1;
+    }
+    for (int i = 0; i < n; i++)
+        t_batch[i] = batch_detumble_time(&b, i);
+    double mean_b, p50_b, mean_s = 0, p50_s = 0, mean_bs, p50_bs;
+    int det_b = detumble_stats(t_batch, n, &mean_b, &p50_b);
+    int det_bs = detumble_stats(t_batch, scalar, &mean_bs, &p50_bs);
+    int det_s = scalar > 0 ? detumble_stats(t_scalar, scalar, &mean_s, &p50_s) : 0;
+    // cost per satellite step needed to detumble, as the scalar simulation stops at detumble
+    uint64_t needed = 0;
+    for (int i = 0; i < n; i++)
+        needed += t_batch[i] >= 0 ? (uint64_t)(t_batch[i] * 1e6 / DETUMBLE_TIME_STEP + 0.5) : batch_steps;
+    double ns_batch = wall_batch * 1e9 / needed;
+    double ns_scalar = scalar_steps > 0 ? wall_scalar * 1e9 / scalar_steps : 0;
+    printf("%d satellites, %d lanes per block, initial rate %.3f...%.3f rad/s, seed %u, orbit %s\n", n, BATCH_LANES, w_min, w_max, seed, use_ephem ? "cached" : "propagated");
+    printf("batch:  detumbled %d/%d, mean %.1f s, p50 %.1f s; %llu steps in %.3f s, %.1f ns per satellite step\n", det_b, n, mean_b, p50_b,
+           (unsigned long long)batch_steps, wall_batch, ns_batch);
+    if (scalar > 0)
+    {
+        printf("scalar: detumbled %d/%d, mean %.1f s, p50 %.1f s (batch on the same satellites: %d, mean %.1f s, p50 %.1f s); %.1f ns per satellite step\n",
+               det_s, scalar, mean_s, p50_s, det_bs, mean_bs, p50_bs, ns_scalar);
+        printf("speedup %.1fx\n", ns_scalar / ns_batch);
+    }
+    if (outfile != NULL)
+    {
+        FILE *fp = fopen(outfile, "a");
+        if (fp == NULL)
+            perror("[BENCH] fopen");
+        else
+        {
+            fprintf(fp, "{\"suite\":\"batch\",\"satellites\":%d,\"lanes\":%d,\"seed\":%u,\"ephem\":%d,\"detumbled\":%d,\"mean_s\":%.2f,\"p50_s\":%.2f,"
+                        "\"ns_per_sat_step\":%.2f,\"scalar_satellites\":%d,\"scalar_mean_s\":%.2f,\"scalar_ns_per_step\":%.2f,\"time\":%lld}\n",
+                    n, BATCH_LANES, seed, use_ephem, det_b, mean_b, p50_b, ns_batch, scalar, mean_s, ns_scalar, (long long)time(NULL));
+            fclose(fp);
+        }
+    }
+    batch_free(&b);
+    if (use_ephem)
+        orbit_ephem_free(&eph);
+    free(init);
+    free(t_scalar);
+    free(t_batch);
+    return 0;
+}
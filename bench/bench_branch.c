@@ -0,0 +1,289 @@
+/**
+ * @file bench_branch.c
+ * @brief Monte Carlo branching benchmark. Runs one simulation up to a branch point (eclipse entry,
+ * detumble completion or a given time), then continues many branches from it with different noise
+ * seeds and fault draws: in process from a snapshot, and in forked copy-on-write processes. Reports
+ * the cost of a branch against re-simulating the shared prefix for every branch.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <unistd.h>
+#include <sys/wait.h>
+#include "bench/bench.h"
+#include "acs-datagen.h"
+
+/**
+ * @brief Outcome of a branch.
+ *
+ */
+typedef struct
+{
+    int branch;
+    double w_end;         // true rate at the end of the branch (rad s^-1)
+    double detumble_time; // simulation time of detumble completion (s), -1 if not reached
+} branch_result_t;
+
+/**
+ * @brief Points at which the trunk is branched.
+ *
+ */
+typedef enum
+{
+    BRANCH_AT_TIME = 0,
+    BRANCH_AT_ECLIPSE, // first eclipse entry
+    BRANCH_AT_DETUMBLE // detumble completion
+} branch_point;
+
+static fault_plan_t *plans = NULL; // one fault plan per branch, NULL to run without faults
+
+/**
+ * @brief Runs the trunk from the start to the branch point.
+ *
+ * @return int 1 if the branch point was reached, 0 otherwise
+ */
+static int run_trunk(const dyn_state_t *init, uint64_t seed, branch_point at, double t_branch, double t_max)
+{
+    g_faults = plans; // the trunk runs with the plan of branch 0
+    resetSim(init);
+    seedRand(seed);
+    while (g_tnow < t_max)
+    {
+        if ((at == BRANCH_AT_TIME && g_tnow >= t_branch) || (at == BRANCH_AT_ECLIPSE && g_sun_frac < 1) ||
+            (at == BRANCH_AT_DETUMBLE && g_detumble_time >= 0))
+            return 1;
+        readSensors();
+    }
+    return 0;
+}
+
+/**
+ * @brief Runs a branch for the given time, from the current state.
+ *
+ */
+static void run_branch(int i, double horizon, branch_result_t *res)
+{
+    double t_end = g_tnow + horizon;
+    while (g_tnow < t_end - 1e-9)
+        readSensors();
+    res->branch = i;
+    res->w_end = sqrt(g_dyn.w[0] * g_dyn.w[0] + g_dyn.w[1] * g_dyn.w[1] + g_dyn.w[2] * g_dyn.w[2]);
+    res->detumble_time = g_detumble_time;
+}
+
+int main(int argc, char *argv[])
+{
+    int branches = 64;
+    int replays = 4; // branches re-simulated from the start, for the baseline
+    uint64_t seed = 1;
+    branch_point at = BRANCH_AT_ECLIPSE;
+    double t_branch = 0;
+    double horizon = 600;    // simulation time of each branch (s)
+    double t_max = 4 * 3600; // give up looking for the branch point after this much simulation time (s)
+    const char *fault_file = NULL;
+    const char *outfile = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:r:s:b:H:F:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            if (loadScenario(optarg) < 0)
+                return 1;
+            seed = g_scenario.seed;
+            if (g_scenario.fault_file[0] != '\0')
+                fault_file = g_scenario.fault_file;
+            break;
+        case 'n':
+            branches = atoi(optarg);
+            break;
+        case 'r':
+            replays = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'b':
+            if (strcmp(optarg, "eclipse") == 0)
+                at = BRANCH_AT_ECLIPSE;
+            else if (strcmp(optarg, "detumble") == 0)
+                at = BRANCH_AT_DETUMBLE;
+            else
+            {
+                at = BRANCH_AT_TIME;
+                t_branch = atof(optarg);
+            }
+            break;
+        case 'H':
+            horizon = atof(optarg);
+            break;
+        case 'F':
+            fault_file = optarg;
+            break;
+        case 'o':
+            outfile = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-i scenario.ini] [-n branches] [-r replays] [-s seed] [-b eclipse|detumble|time (s)] [-H branch time (s)] [-F fault script] [-o results.json]\n"
+                            "\t-r: number of branches re-simulated from the start as the baseline\n"
+                            "\t-F: inject the faults in the script, with the probabilistic faults drawn anew for each branch\n"
+                            "\tOptions are applied in order, so options after -i override the scenario.\n",
+                    argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (branches < 1)
+        branches = 1;
+    if (replays > branches)
+        replays = branches;
+    calculateBessel(bessel_coeff, besselSize(), g_scenario.bessel_order, g_scenario.bessel_cutoff);
+    const dyn_state_t init = g_dyn; // initial tumble of the scenario
+    branch_result_t *res = (branch_result_t *)malloc(3 * branches * sizeof(branch_result_t));
+    pid_t *pids = (pid_t *)malloc(branches * sizeof(pid_t));
+    if (res == NULL || pids == NULL)
+    {
+        perror("[BENCH] malloc");
+        return 1;
+    }
+    branch_result_t *res_copy = res, *res_fork = res + branches, *res_replay = res + 2 * branches;
+    if (fault_file != NULL) // every branch draws its own probabilistic faults, over the trunk and the branch
+    {
+        plans = (fault_plan_t *)malloc(branches * sizeof(fault_plan_t));
+        if (plans == NULL)
+        {
+            perror("[BENCH] malloc");
+            return 1;
+        }
+        uint64_t horizon_steps = (uint64_t)((t_max + horizon) * 1e6 / DETUMBLE_TIME_STEP) + 1;
+        for (int i = 0; i < branches; i++)
+        {
+            fault_init(&plans[i]);
+            if (fault_load(&plans[i], fault_file) < 0 || fault_compile(&plans[i], horizon_steps, DETUMBLE_TIME_STEP * 1e-6, seed + 1 + i) < 0)
+                return 1;
+        }
+    }
+
+    // shared prefix, once
+    uint64_t t0 = bench_nsec();
+    if (!run_trunk(&init, seed, at, t_branch, t_max))
+    {
+        fprintf(stderr, "[BENCH] Branch point not reached within %.0f s\n", t_max);
+        return 1;
+    }
+    double wall_trunk = (bench_nsec() - t0) * 1e-9;
+    uint64_t trunk_steps = acs_ct;
+    acs_checkpoint_t snap;
+    t0 = bench_nsec();
+    captureCheckpoint(&snap);
+    double wall_snap = (bench_nsec() - t0) * 1e-9;
+
+    // in process, restoring the snapshot for each branch
+    double wall_restore = 0;
+    t0 = bench_nsec();
+    for (int i = 0; i < branches; i++)
+    {
+        uint64_t t1 = bench_nsec();
+        if (plans != NULL)
+            g_faults = &plans[i];
+        if (branchSim(&snap, seed + 1 + i) < 0)
+            return 1;
+        wall_restore += (bench_nsec() - t1) * 1e-9;
+        run_branch(i, horizon, &res_copy[i]);
+    }
+    double wall_copy = (bench_nsec() - t0) * 1e-9;
+
+    // forked, copy-on-write from the snapshot state
+    int fd[2];
+    if (branchSim(&snap, seed) < 0 || pipe(fd) < 0)
+        return 1;
+    t0 = bench_nsec();
+    int b = forkBranches(branches, seed + 1, pids);
+    if (b < 0)
+        return 1;
+    if (b < branches) // child
+    {
+        close(fd[0]);
+        if (plans != NULL)
+        {
+            g_faults = &plans[b];
+            replayFaults();
+        }
+        branch_result_t r;
+        run_branch(b, horizon, &r);
+        _exit(write(fd[1], &r, sizeof(r)) == sizeof(r) ? 0 : 1);
+    }
+    close(fd[1]);
+    int received = 0;
+    branch_result_t r;
+    while (received < branches && read(fd[0], &r, sizeof(r)) == sizeof(r))
+    {
+        if (r.branch >= 0 && r.branch < branches)
+            res_fork[r.branch] = r;
+        received++;
+    }
+    for (int i = 0; i < branches; i++)
+        waitpid(pids[i], NULL, 0);
+    close(fd[0]);
+    double wall_fork = (bench_nsec() - t0) * 1e-9;
+
+    // baseline, re-simulating the prefix for each branch
+    t0 = bench_nsec();
+    for (int i = 0; i < replays; i++)
+    {
+        run_trunk(&init, seed, at, t_branch, t_max);
+        if (plans != NULL)
+        {
+            g_faults = &plans[i];
+            replayFaults();
+        }
+        seedRand(seed + 1 + i);
+        run_branch(i, horizon, &res_replay[i]);
+    }
+    double wall_replay = replays > 0 ? (bench_nsec() - t0) * 1e-9 / replays : 0;
+
+    int mismatch = received != branches;
+    for (int i = 0; i < branches; i++)
+        mismatch += res_fork[i].w_end != res_copy[i].w_end || res_fork[i].detumble_time != res_copy[i].detumble_time;
+    for (int i = 0; i < replays; i++)
+        mismatch += res_replay[i].w_end != res_copy[i].w_end || res_replay[i].detumble_time != res_copy[i].detumble_time;
+    double w_mean = 0, w_max = 0;
+    for (int i = 0; i < branches; i++)
+    {
+        w_mean += res_copy[i].w_end / branches;
+        w_max = res_copy[i].w_end > w_max ? res_copy[i].w_end : w_max;
+    }
+
+    static const char *point_name[] = {"time", "eclipse entry", "detumble"};
+    printf("%d branches of %.0f s at %s, t = %.1f s (%llu steps, %.1f ms), seed %llu%s\n", branches, horizon, point_name[at], snap.tnow,
+           (unsigned long long)trunk_steps, wall_trunk * 1e3, (unsigned long long)seed, fault_file != NULL ? ", faults" : "");
+    printf("end rate (deg/s): mean %.3f, max %.3f\n", w_mean * 180 / M_PI, w_max * 180 / M_PI);
+    printf("snapshot %zu bytes: capture %.2f us, restore %.2f us\n", sizeof(snap), wall_snap * 1e6, wall_restore * 1e6 / branches);
+    printf("per branch: snapshot %.2f ms, replay %.2f ms (%.1fx), fork %.2f ms wall (%ld CPUs)\n", wall_copy * 1e3 / branches,
+           wall_replay * 1e3, wall_replay > 0 ? wall_replay * branches / wall_copy : 0, wall_fork * 1e3 / branches, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("branches %s between snapshot, fork and replay\n", mismatch ? "DIFFER" : "agree");
+    if (outfile != NULL)
+    {
+        FILE *fp = fopen(outfile, "a");
+        if (fp == NULL)
+            perror("[BENCH] fopen");
+        else
+        {
+            fprintf(fp, "{\"suite\":\"branch\",\"branches\":%d,\"horizon_s\":%.1f,\"point\":\"%s\",\"t_branch_s\":%.1f,\"seed\":%llu,\"faults\":%d,"
+                        "\"trunk_ms\":%.3f,\"restore_us\":%.3f,\"snapshot_ms\":%.3f,\"replay_ms\":%.3f,\"fork_ms\":%.3f,\"agree\":%d,\"time\":%lld}\n",
+                    branches, horizon, point_name[at], snap.tnow, (unsigned long long)seed, fault_file != NULL, wall_trunk * 1e3, wall_restore * 1e6 / branches,
+                    wall_copy * 1e3 / branches, wall_replay * 1e3, wall_fork * 1e3 / branches, !mismatch, (long long)time(NULL));
+            fclose(fp);
+        }
+    }
+    if (plans != NULL)
+    {
+        for (int i = 0; i < branches; i++)
+            fault_free(&plans[i]);
+        free(plans);
+    }
+    free(pids);
+    free(res);
+    return mismatch ? 1 : 0;
+}
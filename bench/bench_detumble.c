@@ -0,0 +1,249 @@
+/**
+ * @file bench_detumble.c
+ * @brief Closed-loop SITL detumble benchmark. Runs the B-dot controlled simulation from
+ * many random initial tumbles and reports the detumble time distribution and run throughput.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <unistd.h>
+#include "bench/bench.h"
+#include "acs-datagen.h"
+
+/**
+ * @brief Runs of the high-rate case, which start above the ~0.25 rad/s at which B-dot acting on a lagging B-dot
+ * spins the satellite up, and must all detumble within HIGH_RATE_T_MAX.
+ *
+ */
+#define HIGH_RATE_RUNS 4
+#define HIGH_RATE_MIN 0.30   // rad s^-1
+#define HIGH_RATE_MAX 0.40   // rad s^-1
+#define HIGH_RATE_T_MAX 14400 // s
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = 100;
+    unsigned int seed = 1;
+    double t_max = 4 * 3600; // give up after this much simulation time (s)
+    double w_min = 0.02, w_max = 0.15;
+    int use_ephem = 0;
+    const char *fault_file = NULL;
+    double grid_step = 0; // lookup grid spacing (deg), 0 to evaluate the field expansion directly
+    const char *outfile = NULL;
+    const char *restore_file = NULL; // start every run from this checkpoint instead of a random tumble
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:s:t:w:W:eg:F:R:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            if (loadScenario(optarg) < 0)
+                return 1;
+            seed = g_scenario.seed;
+            if (g_scenario.fault_file[0] != '\0')
+                fault_file = g_scenario.fault_file;
+            break;
+        case 'n':
+            runs = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            t_max = atof(optarg);
+            break;
+        case 'w':
+            w_min = atof(optarg);
+            break;
+        case 'W':
+            w_max = atof(optarg);
+            break;
+        case 'e':
+            use_ephem = 1;
+            break;
+        case 'g':
+            grid_step = atof(optarg);
+            break;
+        case 'F':
+            fault_file = optarg;
+            break;
+        case 'R':
+            restore_file = optarg;
+            break;
+        case 'o':
+            outfile = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-i scenario.ini] [-n runs] [-s seed] [-t max sim time (s)] [-w min rate] [-W max rate (rad/s)] [-e] [-g step (deg)] [-F fault script] [-R checkpoint] [-o results.json]\n"
+                            "\t-e: share one cached ephemeris between all runs instead of propagating the orbit\n"
+                            "\t-g: interpolate the magnetic field from a lookup grid of the given spacing\n"
+                            "\t-F: inject the faults in the script, with the probabilistic faults drawn anew for each run\n"
+                            "\t-R: branch every run from the checkpoint, runs differ in sensor noise and fault draws\n"
+                            "\tOptions are applied in order, so options after -i override the scenario.\n",
+                    argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (runs < 1)
+        runs = 1;
+    double *times = (double *)malloc(runs * sizeof(double));
+    if (times == NULL)
+    {
+        perror("[BENCH] malloc");
+        return 1;
+    }
+    calculateBessel(bessel_coeff, besselSize(), g_scenario.bessel_order, g_scenario.bessel_cutoff);
+    orbit_ephem_t eph;
+    if (use_ephem) // all runs share one orbit, tabulated once
+    {
+        orbit_state_t init;
+        orbit_from_elements(&init, &g_orbit_elements);
+        if (orbit_ephem_build(&eph, &init, orbit_period(&g_orbit_elements), 0) < 0)
+            return 1;
+        g_ephem = &eph;
+    }
+    if (field_load(&g_field, g_scenario.coef_file, g_scenario.field_degree) < 0)
+        field_dipole(&g_field);
+    if (grid_step > 0) // shell around the orbit, covers the J2 drift and eccentricity
+    {
+        double ra = g_orbit_elements.a * (1 + g_orbit_elements.e), rp = g_orbit_elements.a * (1 - g_orbit_elements.e);
+        if (field_grid_build(&g_field, rp - 50, ra + 50, 5, grid_step * M_PI / 180) < 0)
+            return 1;
+    }
+
+    fault_plan_t faults;
+    fault_init(&faults);
+    if (fault_file != NULL)
+    {
+        if (fault_load(&faults, fault_file) < 0)
+            return 1;
+        g_faults = &faults;
+    }
+
+    acs_checkpoint_t cp;
+    if (restore_file != NULL && loadCheckpoint(restore_file, &cp) < 0)
+        return 1;
+
+    int detumbled = 0;
+    int flagged = 0, locked = 0;     // runs in which acsDetumbled() fired before the true detumble, in which the sun locked
+    double lead = 0, lock_time = 0; // sums of the lead of acsDetumbled() on the true detumble and of the sun-lock times
+    uint64_t steps = 0, fss_valid = 0, night = 0;
+    uint64_t tstart = bench_nsec();
+    for (int i = 0; i < runs; i++)
+    {
+        srand(seed + i);
+        dyn_state_t init;
+        bench_random_state(&init, w_min, w_max);
+        if (g_faults != NULL && fault_compile(&faults, (uint64_t)(t_max * 1e6 / DETUMBLE_TIME_STEP) + 1, DETUMBLE_TIME_STEP * 1e-6, seed + i) < 0)
+            return 1;
+        resetSim(&init);
+        if (restore_file != NULL && restoreCheckpoint(&cp) < 0)
+            return 1;
+        seedRand(seed + i); // after the restore, so that the branches draw different noise
+        while (g_detumble_time < 0 && g_tnow < t_max)
+        {
+            readSensors();
+            fss_valid += g_FSS_RET == FSS_OK;
+            night += g_night;
+        }
+        steps += acs_ct;
+        if (g_detumble_time >= 0)
+            times[detumbled++] = g_detumble_time;
+        if (g_detumble_est_time >= 0)
+        {
+            flagged++;
+            lead += g_tnow - g_detumble_est_time;
+        }
+        if (g_sunlock_time >= 0)
+        {
+            locked++;
+            lock_time += g_sunlock_time;
+        }
+    }
+    double wall = (bench_nsec() - tstart) * 1e-9;
+
+    double p50 = 0, p90 = 0, pmax = 0, mean = 0;
+    if (detumbled > 0)
+    {
+        qsort(times, detumbled, sizeof(double), cmp_double);
+        for (int i = 0; i < detumbled; i++)
+            mean += times[i];
+        mean /= detumbled;
+        p50 = times[detumbled / 2];
+        p90 = times[(90 * detumbled + 99) / 100 - 1];
+        pmax = times[detumbled - 1];
+    }
+    printf("%d runs, initial rate %.3f...%.3f rad/s, seed %u, orbit %s, field %s%s\n", runs, w_min, w_max, seed, use_ephem ? "cached" : "propagated",
+           grid_step > 0 ? "grid" : "expansion", fault_file != NULL ? ", faults" : "");
+    if (restore_file != NULL)
+        printf("branched from %s at t = %.1f s\n", restore_file, cp.tnow);
+    printf("detumbled %d/%d within %.0f s\n", detumbled, runs, t_max);
+    printf("detumble time (s): mean %.1f, p50 %.1f, p90 %.1f, max %.1f\n", mean, p50, p90, pmax);
+    printf("ACS detumble check fired early in %d/%d runs, %.1f s ahead on average; sun locked in %d/%d runs, at %.1f s on average\n",
+           flagged, runs, flagged > 0 ? lead / flagged : 0, locked, runs, locked > 0 ? lock_time / locked : 0);
+    printf("sun vector source: FSS %.1f%%, CSS %.1f%%, night %.1f%% of steps\n", 100.0 * fss_valid / steps,
+           100.0 * (steps - fss_valid - night) / steps, 100.0 * night / steps);
+    printf("throughput: %.2f runs/s, %.0f steps/s, %.1f ns/step\n", runs / wall, steps / wall, wall * 1e9 / steps);
+    printFilters(stdout);
+    int status = 0;
+    if (flagged > 0)
+    {
+        fprintf(stderr, "[BENCH] ACS detumble check fired before the true detumble in %d runs\n", flagged);
+        status = 1;
+    }
+
+    // high-rate case, from fresh tumbles of the same satellite without faults
+    g_faults = NULL;
+    int high_detumbled = 0;
+    double high_max = 0;
+    for (int i = 0; i < HIGH_RATE_RUNS; i++)
+    {
+        srand(seed + runs + i);
+        dyn_state_t init;
+        bench_random_state(&init, HIGH_RATE_MIN, HIGH_RATE_MAX);
+        resetSim(&init);
+        seedRand(seed + runs + i);
+        while (g_detumble_time < 0 && g_tnow < HIGH_RATE_T_MAX)
+            readSensors();
+        if (g_detumble_time >= 0)
+        {
+            high_detumbled++;
+            high_max = g_detumble_time > high_max ? g_detumble_time : high_max;
+        }
+    }
+    printf("high-rate case: detumbled %d/%d from %.2f...%.2f rad/s within %d s, max %.1f s\n", high_detumbled, HIGH_RATE_RUNS,
+           HIGH_RATE_MIN, HIGH_RATE_MAX, HIGH_RATE_T_MAX, high_max);
+    if (high_detumbled < HIGH_RATE_RUNS)
+    {
+        fprintf(stderr, "[BENCH] B-dot did not detumble every high-rate run\n");
+        status = 1;
+    }
+    if (outfile != NULL)
+    {
+        FILE *fp = fopen(outfile, "a");
+        if (fp == NULL)
+            perror("[BENCH] fopen");
+        else
+        {
+            fprintf(fp, "{\"suite\":\"detumble\",\"runs\":%d,\"seed\":%u,\"ephem\":%d,\"grid_deg\":%.2f,\"w_min\":%.4f,\"w_max\":%.4f,\"t_max\":%.1f,"
+                        "\"detumbled\":%d,\"mean_s\":%.2f,\"p50_s\":%.2f,\"p90_s\":%.2f,\"max_s\":%.2f,\"fss_frac\":%.4f,\"night_frac\":%.4f,"
+                        "\"runs_per_s\":%.3f,\"steps_per_s\":%.1f,\"time\":%lld}\n",
+                    runs, seed, use_ephem, grid_step, w_min, w_max, t_max, detumbled, mean, p50, p90, pmax, (double)fss_valid / steps, (double)night / steps, runs / wall, steps / wall, (long long)time(NULL));
+            fclose(fp);
+        }
+    }
+    if (use_ephem)
+        orbit_ephem_free(&eph);
+    field_grid_free(&g_field);
+    fault_free(&faults);
+    free(times);
+    return status;
+}
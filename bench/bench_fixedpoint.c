@@ -0,0 +1,184 @@
+/**
+ * @file bench_fixedpoint.c
+ * @brief Fixed-point pipeline benchmark. Runs detumble simulations with the Q15/Q31 B, B-dot and omega pipeline
+ * of the flight computer alongside the floating point one, reports the error of each signal, and times the
+ * fixed-point Bessel filter and omega estimate against the floating point ones.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef ACS_FIXEDPOINT
+#define ACS_FIXEDPOINT
+#endif
+#include <unistd.h>
+#include "bench/bench.h"
+#include "acs-datagen.h"
+
+BENCH_BUFFER(bench_d, double);
+BENCH_BUFFER(bench_f, float);
+BENCH_BUFFER(bench_q, q31_t);
+BENCH_BUFFER(bench_w, float);
+BENCH_BUFFER(bench_qw, q31_t);
+
+static void bm_dfilterBessel(void *ctx, uint64_t iters)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+        acc += dfilterBessel(x_bench_d, i & (SH_BUFFER_SIZE - 1));
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_qfilterBessel(void *ctx, uint64_t iters)
+{
+    int64_t acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+        acc += qfilterBessel(q_bessel_B, q_taps_B, x_bench_q, i & (SH_BUFFER_SIZE - 1));
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_omega(void *ctx, uint64_t iters)
+{
+    float freq = 10;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        int k = i & (SH_BUFFER_SIZE - 1);
+        int m = (k + 1) & (SH_BUFFER_SIZE - 1);
+        CROSS_PRODUCT(bench_w[k], bench_f[k], bench_f[m]);
+        float norm2 = NORM2(bench_f[m]);
+        VECTOR_MIXED(bench_w[k], bench_w[k], freq / norm2, *);
+    }
+    BENCH_CLOBBER();
+}
+
+static void bm_qomega(void *ctx, uint64_t iters)
+{
+    int32_t k16 = q16_gain(10 / FXP_W_SCALE);
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        int k = i & (SH_BUFFER_SIZE - 1);
+        int m = (k + 1) & (SH_BUFFER_SIZE - 1);
+        DECLARE_VECTOR(c, int64_t);
+        QCROSS_PRODUCT(c, bench_q[k], bench_q[m]);
+        int64_t norm2 = QNORM2(bench_q[m]);
+        x_bench_qw[k] = q31_gain(q31_div64(x_c >> 1, norm2), k16);
+        y_bench_qw[k] = q31_gain(q31_div64(y_c >> 1, norm2), k16);
+        z_bench_qw[k] = q31_gain(q31_div64(z_c >> 1, norm2), k16);
+    }
+    BENCH_CLOBBER();
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = 10;
+    unsigned int seed = 1;
+    double t_max = 4 * 3600;
+    double w_min = 0.02, w_max = 0.15;
+    const char *outfile = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:s:t:w:W:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            if (loadScenario(optarg) < 0)
+                return 1;
+            seed = g_scenario.seed;
+            break;
+        case 'n':
+            runs = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            t_max = atof(optarg);
+            break;
+        case 'w':
+            w_min = atof(optarg);
+            break;
+        case 'W':
+            w_max = atof(optarg);
+            break;
+        case 'o':
+            outfile = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-i scenario.ini] [-n runs] [-s seed] [-t max sim time (s)] [-w min rate] [-W max rate (rad/s)] [-o results.json]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    runs = runs < 1 ? 1 : runs;
+    calculateBessel(bessel_coeff, besselSize(), g_scenario.bessel_order, g_scenario.bessel_cutoff);
+    if (field_load(&g_field, g_scenario.coef_file, g_scenario.field_degree) < 0)
+        field_dipole(&g_field);
+
+    int detumbled = 0;
+    for (int i = 0; i < runs; i++)
+    {
+        srand(seed + i);
+        dyn_state_t init;
+        bench_random_state(&init, w_min, w_max);
+        resetSim(&init);
+        seedRand(seed + i);
+        while (g_detumble_time < 0 && g_tnow < t_max)
+            readSensors();
+        detumbled += g_detumble_time >= 0;
+    }
+    printf("%d runs, initial rate %.3f...%.3f rad/s, seed %u, detumbled %d/%d\n", runs, w_min, w_max, seed, detumbled, runs);
+    printf("full scale: B %g mG, B-dot %g mG/s, omega %g rad/s; Q15 weights, %d/%d/%d taps\n", FXP_B_SCALE, FXP_BT_SCALE, FXP_W_SCALE,
+           q_taps_B, q_taps_Bt, q_taps_W);
+    printFilters(stdout);
+    printFixedPoint(stdout);
+
+    // kernels, on a B-like buffer of the default depth
+    setBesselDepth(SH_BUFFER_SIZE);
+    for (int i = 0; i < SH_BUFFER_SIZE; i++)
+    {
+        x_bench_d[i] = 300 * sin(0.1 * i);
+        y_bench_d[i] = 300 * cos(0.1 * i);
+        z_bench_d[i] = 150 * sin(0.07 * i + 1);
+        x_bench_f[i] = x_bench_d[i];
+        y_bench_f[i] = y_bench_d[i];
+        z_bench_f[i] = z_bench_d[i];
+        x_bench_q[i] = q31_from_double(x_bench_d[i], FXP_B_SCALE);
+        y_bench_q[i] = q31_from_double(y_bench_d[i], FXP_B_SCALE);
+        z_bench_q[i] = q31_from_double(z_bench_d[i], FXP_B_SCALE);
+    }
+    struct
+    {
+        const char *name;
+        bench_fn fn;
+    } benchmarks[] = {
+        {"dfilterBessel", bm_dfilterBessel},
+        {"qfilterBessel", bm_qfilterBessel},
+        {"omega (float)", bm_omega},
+        {"omega (Q31)", bm_qomega},
+    };
+    FILE *fp = NULL;
+    if (outfile != NULL && (fp = fopen(outfile, "a")) == NULL)
+        perror("[BENCH] fopen");
+    bench_print_header();
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+    {
+        bench_result res = bench_run(benchmarks[i].name, benchmarks[i].fn, NULL);
+        bench_print(&res);
+        bench_write_json(fp, "fixedpoint", &res);
+    }
+    if (fp != NULL)
+    {
+        const fxp_stats_t *st[3] = {&g_fxp_B, &g_fxp_Bt, &g_fxp_W};
+        const char *names[3] = {"B", "Bdot", "omega"};
+        for (int i = 0; i < 3; i++)
+        {
+            double n = st[i]->n > 0 ? st[i]->n : 1;
+            fprintf(fp, "{\"suite\":\"fixedpoint\",\"name\":\"%s error\",\"vectors\":%llu,\"rms\":%.4e,\"max\":%.4e,\"snr_db\":%.2f,\"saturated\":%llu,\"time\":%lld}\n",
+                    names[i], (unsigned long long)st[i]->n, sqrt(st[i]->err2 / n), st[i]->max_err,
+                    st[i]->err2 > 0 ? 10 * log10(st[i]->ref2 / st[i]->err2) : 999., (unsigned long long)st[i]->saturations, (long long)time(NULL));
+        }
+        fclose(fp);
+    }
+    field_grid_free(&g_field);
+    return 0;
+}
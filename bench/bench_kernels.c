@@ -0,0 +1,809 @@
+/**
+ * @file bench_kernels.c
+ * @brief Microbenchmarks of the math and filter kernels used by the ACS step.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <unistd.h>
+#include "bench/bench.h"
+#include "acs-datagen.h"
+#include "vecmath.h"
+
+/**
+ * @brief Number of distinct scalar inputs cycled through by the inverse square root kernels.
+ *
+ */
+#define BENCH_NUM_INPUTS 1024
+
+float bench_f[BENCH_NUM_INPUTS];   // scalar inputs
+BENCH_BUFFER(bench_vf, float);   // float vector inputs
+BENCH_BUFFER(bench_vd, double);  // double vector inputs
+BENCH_BUFFER(bench_out, float);  // vector outputs
+float bench_ax[BENCH_NUM_INPUTS], bench_ay[BENCH_NUM_INPUTS], bench_az[BENCH_NUM_INPUTS]; // arrays of vectors
+float bench_aout[3][BENCH_NUM_INPUTS];                                                     // array outputs
+double bench_pos[BENCH_NUM_INPUTS][3]; // positions in low Earth orbit (km)
+
+/**
+ * @brief Length of the recorded log averaged by the long-window average benchmarks.
+ *
+ */
+#define BENCH_LOG_SIZE (1 << 20)
+
+float bench_logf[BENCH_LOG_SIZE];  // magnetometer-like log, float
+double bench_logd[BENCH_LOG_SIZE]; // same log, double
+
+static void init_inputs(void)
+{
+    srand(42);
+    for (int i = 0; i < BENCH_NUM_INPUTS; i++)
+        bench_f[i] = 1e-3f + (1e4f * rand()) / RAND_MAX;
+    for (int i = 0; i < BENCH_NUM_INPUTS; i++)
+    {
+        double ct = 2.0 * rand() / RAND_MAX - 1, ph = 2 * M_PI * rand() / RAND_MAX;
+        double r = EARTH_RADIUS + 400 + 200.0 * rand() / RAND_MAX, st = sqrt(1 - ct * ct);
+        bench_pos[i][0] = r * st * cos(ph);
+        bench_pos[i][1] = r * st * sin(ph);
+        bench_pos[i][2] = r * ct;
+    }
+    for (int i = 0; i < BENCH_NUM_INPUTS; i++)
+    {
+        bench_ax[i] = (2.0f * rand()) / RAND_MAX - 1;
+        bench_ay[i] = (2.0f * rand()) / RAND_MAX - 1;
+        bench_az[i] = (2.0f * rand()) / RAND_MAX - 1;
+    }
+    for (int i = 0; i < BENCH_LOG_SIZE; i++) // offset field with a slow rotation and noise, as logged in orbit
+    {
+        bench_logd[i] = 300 + 150 * sin(2 * M_PI * i / 55000.0) + (5.0 * rand()) / RAND_MAX - 2.5;
+        bench_logf[i] = bench_logd[i];
+    }
+    for (int i = 0; i < SH_BUFFER_SIZE; i++)
+    {
+        x_bench_vf[i] = (2.0f * rand()) / RAND_MAX - 1;
+        y_bench_vf[i] = (2.0f * rand()) / RAND_MAX - 1;
+        z_bench_vf[i] = (2.0f * rand()) / RAND_MAX - 1;
+        x_bench_vd[i] = 500.0 * rand() / RAND_MAX - 250;
+        y_bench_vd[i] = 500.0 * rand() / RAND_MAX - 250;
+        z_bench_vd[i] = 500.0 * rand() / RAND_MAX - 250;
+    }
+}
+
+static void bm_calculateBessel(void *ctx, uint64_t iters)
+{
+    float arr[SH_BUFFER_SIZE];
+    while (iters--)
+    {
+        calculateBessel(arr, SH_BUFFER_SIZE, 3, BESSEL_FREQ_CUTOFF);
+        BENCH_CLOBBER();
+    }
+}
+
+static void bm_computeBessel(void *ctx, uint64_t iters)
+{
+    float arr[SH_BUFFER_SIZE];
+    while (iters--)
+    {
+        computeBessel(arr, SH_BUFFER_SIZE, 3, BESSEL_FREQ_CUTOFF);
+        BENCH_CLOBBER();
+    }
+}
+
+static void bm_dfilterBessel(void *ctx, uint64_t iters)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+        acc += dfilterBessel(x_bench_vd, i & (SH_BUFFER_SIZE - 1));
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_ffilterBessel(void *ctx, uint64_t iters)
+{
+    float acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+        acc += ffilterBessel(x_bench_vf, i & (SH_BUFFER_SIZE - 1));
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_dfilterBesselFixed(void *ctx, uint64_t iters)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+        acc += dfilterBesselFixed(x_bench_vd, i & (SH_BUFFER_SIZE - 1));
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_ffilterBesselFixed(void *ctx, uint64_t iters)
+{
+    float acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+        acc += ffilterBesselFixed(x_bench_vf, i & (SH_BUFFER_SIZE - 1));
+    BENCH_ESCAPE(acc);
+}
+
+/**
+ * @brief Filter bank settings benchmarked, one filter of each type.
+ *
+ */
+static const char *bench_filter_specs[FILTER_TYPE_COUNT] = {
+    "none",
+    "bessel 3 5",
+    "butterworth 2 5",
+    "moving_average 8",
+    "alpha_beta 0.5 0.1",
+};
+static filter_t bench_filters[FILTER_TYPE_COUNT];
+static winstat3_t bench_stat;
+static arena_t bench_arena; // histories of bench_filters, windows of bench_stat
+BENCH_BUFFER(bench_filt, double); // filtered in place
+
+/**
+ * @brief Filters one vector per operation as readSensors() does: the raw sample is written to the buffer,
+ * then filtered in place. APPLY_DBESSEL() is the reference without the filter bank.
+ *
+ */
+static void bm_filter(filter_type type, uint64_t iters)
+{
+    filter_t *f = &bench_filters[type];
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        int k = i & (SH_BUFFER_SIZE - 1);
+        x_bench_filt[k] = x_bench_vd[k];
+        y_bench_filt[k] = y_bench_vd[k];
+        z_bench_filt[k] = z_bench_vd[k];
+        APPLY_DFILTER(f, bench_filt, k);
+    }
+    BENCH_CLOBBER();
+}
+
+static void bm_APPLY_DBESSEL(void *ctx, uint64_t iters)
+{
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        int k = i & (SH_BUFFER_SIZE - 1);
+        x_bench_filt[k] = x_bench_vd[k];
+        y_bench_filt[k] = y_bench_vd[k];
+        z_bench_filt[k] = z_bench_vd[k];
+        APPLY_DBESSEL(bench_filt, k);
+    }
+    BENCH_CLOBBER();
+}
+
+#define BENCH_FILTER(name, type)                                \
+    static void bm_filter_##name(void *ctx, uint64_t iters)     \
+    {                                                           \
+        bm_filter(type, iters);                                 \
+    }
+BENCH_FILTER(none, FILTER_NONE)
+BENCH_FILTER(bessel, FILTER_BESSEL)
+BENCH_FILTER(butterworth, FILTER_BUTTERWORTH)
+BENCH_FILTER(moving_average, FILTER_MOVING_AVERAGE)
+BENCH_FILTER(alpha_beta, FILTER_ALPHA_BETA)
+#undef BENCH_FILTER
+
+/**
+ * @brief Checks the generated tables against computeBessel(), and the fixed filters against the general ones
+ * with the default table in bessel_coeff, and prints the largest differences.
+ *
+ */
+static void bessel_table_check(void)
+{
+    float table[SH_BUFFER_SIZE], computed[SH_BUFFER_SIZE];
+    double max_coeff = 0, max_dfilter = 0, max_ffilter = 0;
+    int ntables = 0;
+#define BENCH_BESSEL_TABLE(order, cutoff, name)                                       \
+    calculateBessel(table, SH_BUFFER_SIZE, order, cutoff);                            \
+    computeBessel(computed, SH_BUFFER_SIZE, order, cutoff);                           \
+    for (int i = 0; i < SH_BUFFER_SIZE; i++)                                          \
+        max_coeff = fmax(max_coeff, fabs((double)table[i] - computed[i]));            \
+    ntables++;
+    BESSEL_TABLES(BENCH_BESSEL_TABLE)
+#undef BENCH_BESSEL_TABLE
+    calculateBessel(bessel_coeff, besselSize(), BESSEL_DEFAULT_ORDER, BESSEL_DEFAULT_CUTOFF);
+    for (int i = 0; i < SH_BUFFER_SIZE; i++)
+    {
+        max_dfilter = fmax(max_dfilter, fabs(dfilterBesselFixed(x_bench_vd, i) - dfilterBessel(x_bench_vd, i)));
+        max_ffilter = fmax(max_ffilter, fabs(ffilterBesselFixed(x_bench_vf, i) - ffilterBessel(x_bench_vf, i)));
+    }
+    printf("\n%d Bessel tables, max difference to computeBessel() %.3e, fixed filters max difference %.3e (double) %.3e (float)\n",
+           ntables, max_coeff, max_dfilter, max_ffilter);
+}
+
+static void bm_q2isqrt(void *ctx, uint64_t iters)
+{
+    float acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+        acc += q2isqrt(bench_f[i & (BENCH_NUM_INPUTS - 1)]);
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_invsqrtf(void *ctx, uint64_t iters)
+{
+    float acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+        acc += 1.0f / sqrtf(bench_f[i & (BENCH_NUM_INPUTS - 1)]);
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_NORMALIZE(void *ctx, uint64_t iters)
+{
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        int k = i & (SH_BUFFER_SIZE - 1);
+        NORMALIZE(bench_out[k], bench_vf[k]);
+    }
+    BENCH_CLOBBER();
+}
+
+/**
+ * @brief Array kernels at an instruction set level, one operation per element.
+ *
+ */
+static void bm_vec_isqrtf(vec_isa isa, uint64_t iters)
+{
+    vec_select(isa);
+    for (uint64_t i = 0; i < iters; i += BENCH_NUM_INPUTS)
+    {
+        vec_isqrtf(bench_aout[0], bench_f, iters - i < BENCH_NUM_INPUTS ? iters - i : BENCH_NUM_INPUTS);
+        BENCH_CLOBBER();
+    }
+}
+
+static void bm_vec_normalize3f(vec_isa isa, uint64_t iters)
+{
+    vec_select(isa);
+    for (uint64_t i = 0; i < iters; i += BENCH_NUM_INPUTS)
+    {
+        vec_normalize3f(bench_aout[0], bench_aout[1], bench_aout[2], bench_ax, bench_ay, bench_az,
+                        iters - i < BENCH_NUM_INPUTS ? iters - i : BENCH_NUM_INPUTS);
+        BENCH_CLOBBER();
+    }
+}
+
+static void bm_vec_cross3f(void *ctx, uint64_t iters)
+{
+    for (uint64_t i = 0; i < iters; i += BENCH_NUM_INPUTS - 1) // each vector with the next one
+    {
+        int n = iters - i < BENCH_NUM_INPUTS - 1 ? iters - i : BENCH_NUM_INPUTS - 1;
+        vec_cross3f(bench_aout[0], bench_aout[1], bench_aout[2], bench_ax, bench_ay, bench_az, bench_ax + 1, bench_ay + 1, bench_az + 1, n);
+        BENCH_CLOBBER();
+    }
+}
+
+static void bm_vec_matvec3f(void *ctx, uint64_t iters)
+{
+    for (uint64_t i = 0; i < iters; i += BENCH_NUM_INPUTS)
+    {
+        vec_matvec3f(bench_aout[0], bench_aout[1], bench_aout[2], (const float(*)[3])MOI, bench_ax, bench_ay, bench_az,
+                     iters - i < BENCH_NUM_INPUTS ? iters - i : BENCH_NUM_INPUTS);
+        BENCH_CLOBBER();
+    }
+}
+
+#define BENCH_VEC_ISA(name, isa)                                      \
+    static void bm_vec_isqrtf_##name(void *ctx, uint64_t iters)       \
+    {                                                                 \
+        bm_vec_isqrtf(isa, iters);                                    \
+    }                                                                 \
+    static void bm_vec_normalize3f_##name(void *ctx, uint64_t iters)  \
+    {                                                                 \
+        bm_vec_normalize3f(isa, iters);                               \
+    }
+BENCH_VEC_ISA(scalar, VEC_ISA_SCALAR)
+BENCH_VEC_ISA(sse, VEC_ISA_SSE)
+BENCH_VEC_ISA(avx2, VEC_ISA_AVX2)
+BENCH_VEC_ISA(avx512, VEC_ISA_AVX512)
+#undef BENCH_VEC_ISA
+
+/**
+ * @brief Checks the array kernels of every supported instruction set level against 1/sqrt() in double precision,
+ * over log-uniform inputs spanning the normal floats, and prints the largest errors.
+ *
+ * @param fp JSON output, NULL for none
+ */
+static void vec_accuracy(FILE *fp)
+{
+#define BENCH_ACC_INPUTS (1 << 16)
+    static float in[BENCH_ACC_INPUTS], out[BENCH_ACC_INPUTS], n[3][BENCH_ACC_INPUTS];
+    srand(7);
+    for (int i = 0; i < BENCH_ACC_INPUTS; i++)
+        in[i] = ldexpf(1.0f + (1.0f * rand()) / RAND_MAX, -126 + rand() % 253);
+    vec_isa top = vec_select(VEC_ISA_COUNT);
+    printf("\n%-10s %14s %10s %16s\n", "isa", "isqrt max rel", "max ulp", "normalize |n|-1");
+    for (vec_isa isa = VEC_ISA_SCALAR; isa <= top; isa++)
+    {
+        vec_select(isa);
+        vec_isqrtf(out, in, BENCH_ACC_INPUTS);
+        double max_rel = 0, max_ulp = 0, max_norm = 0;
+        for (int i = 0; i < BENCH_ACC_INPUTS; i++)
+        {
+            double ref = 1.0 / sqrt((double)in[i]);
+            double err = fabs(out[i] - ref);
+            max_rel = err / ref > max_rel ? err / ref : max_rel;
+            double ulp = ldexp(1.0, ilogb(ref) - 23);
+            max_ulp = err / ulp > max_ulp ? err / ulp : max_ulp;
+        }
+        vec_normalize3f(n[0], n[1], n[2], bench_ax, bench_ay, bench_az, BENCH_NUM_INPUTS);
+        for (int i = 0; i < BENCH_NUM_INPUTS; i++)
+        {
+            double err = fabs(sqrt((double)n[0][i] * n[0][i] + (double)n[1][i] * n[1][i] + (double)n[2][i] * n[2][i]) - 1);
+            max_norm = err > max_norm ? err : max_norm;
+        }
+        printf("%-10s %14.3e %10.2f %16.3e\n", vec_isa_name(isa), max_rel, max_ulp, max_norm);
+        if (fp != NULL)
+            fprintf(fp, "{\"suite\":\"kernels\",\"name\":\"vec accuracy (%s)\",\"unit\":\"rel\",\"isqrt_max_rel\":%.4e,\"isqrt_max_ulp\":%.3f,"
+                        "\"normalize_max_err\":%.4e,\"time\":%lld}\n",
+                    vec_isa_name(isa), max_rel, max_ulp, max_norm, (long long)time(NULL));
+    }
+    vec_select(top);
+#undef BENCH_ACC_INPUTS
+}
+
+static void bm_CROSS_PRODUCT(void *ctx, uint64_t iters)
+{
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        int k = i & (SH_BUFFER_SIZE - 1);
+        int m = (k + 1) & (SH_BUFFER_SIZE - 1);
+        CROSS_PRODUCT(bench_out[k], bench_vf[k], bench_vf[m]);
+    }
+    BENCH_CLOBBER();
+}
+
+static void bm_MATVECMUL(void *ctx, uint64_t iters)
+{
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        int k = i & (SH_BUFFER_SIZE - 1);
+        MATVECMUL(bench_out[k], MOI, bench_vf[k]);
+    }
+    BENCH_CLOBBER();
+}
+
+/**
+ * @brief faverage() as it was, one accumulator summing backwards: serial, and its error grows with the length.
+ *
+ */
+static float faverage_serial(const float arr[], int size)
+{
+    float result = 0;
+    int count = size;
+    while (count--)
+        result += arr[count];
+    return result / size;
+}
+
+static void bm_faverage_serial(void *ctx, uint64_t iters)
+{
+    float acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        acc += faverage_serial(x_bench_vf, SH_BUFFER_SIZE);
+        BENCH_CLOBBER();
+    }
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_faverage(void *ctx, uint64_t iters)
+{
+    float acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        acc += faverage(x_bench_vf, SH_BUFFER_SIZE);
+        BENCH_CLOBBER();
+    }
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_faverage_serial_log(void *ctx, uint64_t iters)
+{
+    float acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        acc += faverage_serial(bench_logf, BENCH_LOG_SIZE);
+        BENCH_CLOBBER();
+    }
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_faverage_log(void *ctx, uint64_t iters)
+{
+    float acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        acc += faverage(bench_logf, BENCH_LOG_SIZE);
+        BENCH_CLOBBER();
+    }
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_daverage_log(void *ctx, uint64_t iters)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        acc += daverage(bench_logd, BENCH_LOG_SIZE);
+        BENCH_CLOBBER();
+    }
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_ravg_replace(void *ctx, uint64_t iters)
+{
+    running_avg_t r;
+    ravg_reset(&r);
+    for (int i = 0; i < SH_BUFFER_SIZE; i++)
+        ravg_push(&r, bench_logd[i]);
+    double acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        int k = i & (BENCH_LOG_SIZE - 1);
+        ravg_replace(&r, bench_logd[(k - SH_BUFFER_SIZE) & (BENCH_LOG_SIZE - 1)], bench_logd[k]);
+        acc += ravg_mean(&r);
+    }
+    BENCH_ESCAPE(acc);
+}
+
+/**
+ * @brief Average of the 48 newest samples of a ring whose head moves every call, so that the window wraps around
+ * the end of the storage in most calls: two contiguous spans summed by dsum().
+ *
+ */
+static void bm_ring_daverage(void *ctx, uint64_t iters)
+{
+    ring_t r = RING_INITIALIZER(SH_BUFFER_SIZE);
+    double acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        ring_push(&r);
+        acc += ring_daverage(&r, x_bench_vd, 48);
+        BENCH_CLOBBER();
+    }
+    BENCH_ESCAPE(acc);
+}
+
+/**
+ * @brief The same window walked one sample at a time, wrapping every index: what ring_daverage() replaces.
+ *
+ */
+static void bm_wrapped_average(void *ctx, uint64_t iters)
+{
+    int head = SH_BUFFER_SIZE - 1;
+    double acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        head = (head + 1) % SH_BUFFER_SIZE;
+        double sum = 0;
+        for (int k = 0, j = head; k < 48; k++)
+        {
+            sum += x_bench_vd[j];
+            j = j == 0 ? SH_BUFFER_SIZE - 1 : j - 1;
+        }
+        acc += sum / 48;
+        BENCH_CLOBBER();
+    }
+    BENCH_ESCAPE(acc);
+}
+
+/**
+ * @brief Prints the relative error of the averages of the log against a long double reference, and of a
+ * 64-sample running average slid over the whole log against the window averaged anew.
+ *
+ */
+static void average_accuracy(FILE *fp)
+{
+    long double ref = 0;
+    for (int i = 0; i < BENCH_LOG_SIZE; i++)
+        ref += bench_logd[i];
+    ref /= BENCH_LOG_SIZE;
+    double e_serial = fabsl((faverage_serial(bench_logf, BENCH_LOG_SIZE) - ref) / ref);
+    double e_pairwise = fabsl((faverage(bench_logf, BENCH_LOG_SIZE) - ref) / ref);
+    double e_double = fabsl((daverage(bench_logd, BENCH_LOG_SIZE) - ref) / ref);
+    running_avg_t r;
+    ravg_reset(&r);
+    double e_running = 0;
+    for (int i = 0; i < BENCH_LOG_SIZE; i++)
+    {
+        if (i < SH_BUFFER_SIZE)
+            ravg_push(&r, bench_logd[i]);
+        else
+            ravg_replace(&r, bench_logd[i - SH_BUFFER_SIZE], bench_logd[i]);
+        if (i >= SH_BUFFER_SIZE && (i & 1023) == 0)
+        {
+            double avg = daverage(bench_logd + i + 1 - SH_BUFFER_SIZE, SH_BUFFER_SIZE);
+            double e = fabs((ravg_mean(&r) - avg) / avg);
+            e_running = e > e_running ? e : e_running;
+        }
+    }
+    printf("\naverage of %d samples, relative error: faverage serial %.2e, faverage %.2e, daverage %.2e; running average %.2e\n",
+           BENCH_LOG_SIZE, e_serial, e_pairwise, e_double, e_running);
+    if (fp != NULL)
+        fprintf(fp, "{\"suite\":\"kernels\",\"name\":\"average accuracy\",\"unit\":\"rel\",\"faverage_serial\":%.4e,\"faverage\":%.4e,"
+                    "\"daverage\":%.4e,\"running\":%.4e,\"time\":%lld}\n",
+                e_serial, e_pairwise, e_double, e_running, (long long)time(NULL));
+}
+
+static void bm_winstat3_push(void *ctx, uint64_t iters)
+{
+    winstat3_init(&bench_stat, SH_BUFFER_SIZE);
+    double acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        int k = i & (SH_BUFFER_SIZE - 1);
+        winstat3_push(&bench_stat, x_bench_vd[k], y_bench_vd[k], z_bench_vd[k]);
+        acc += winstat_max(&bench_stat.norm) + winstat3_var(&bench_stat);
+    }
+    BENCH_ESCAPE(acc);
+}
+
+/**
+ * @brief Mean, variance, minimum and maximum of the three axes and the norm of a buffer, by rescanning it: what
+ * winstat3_push() saves.
+ *
+ */
+static void bm_winstat_rescan(void *ctx, uint64_t iters)
+{
+    double acc = 0;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        double *ax[3] = {x_bench_vd, y_bench_vd, z_bench_vd};
+        double nmax = 0, var = 0;
+        for (int a = 0; a < 3; a++)
+        {
+            double mean = daverage(ax[a], SH_BUFFER_SIZE), m2 = 0, lo = ax[a][0], hi = ax[a][0];
+            for (int j = 0; j < SH_BUFFER_SIZE; j++)
+            {
+                double d = ax[a][j] - mean;
+                m2 += d * d;
+                lo = ax[a][j] < lo ? ax[a][j] : lo;
+                hi = ax[a][j] > hi ? ax[a][j] : hi;
+            }
+            var += m2 / SH_BUFFER_SIZE;
+            acc += lo + hi;
+        }
+        for (int j = 0; j < SH_BUFFER_SIZE; j++)
+        {
+            double n = sqrt(x_bench_vd[j] * x_bench_vd[j] + y_bench_vd[j] * y_bench_vd[j] + z_bench_vd[j] * z_bench_vd[j]);
+            nmax = n > nmax ? n : nmax;
+        }
+        acc += nmax + var;
+        BENCH_CLOBBER();
+    }
+    BENCH_ESCAPE(acc);
+}
+
+static void bm_dynamics_rk4(void *ctx, uint64_t iters)
+{
+    dyn_input_t u = {.torque = {0}, .dipole = {0.2, -0.1, 0.05}, .B_I = {3e-5, 0, 4e-5}};
+    while (iters--)
+        dynamics_rk4(&g_dyn, &g_dyn_params, &u, DETUMBLE_TIME_STEP * 1e-6 / DYNAMICS_SUBSTEPS);
+    BENCH_CLOBBER();
+}
+
+static void bm_dynamics_rk45(void *ctx, uint64_t iters)
+{
+    dyn_input_t u = {.torque = {0}, .dipole = {0.2, -0.1, 0.05}, .B_I = {3e-5, 0, 4e-5}};
+    while (iters--) // one full ACS period per operation
+        dynamics_rk45(&g_dyn, &g_dyn_params, &u, DETUMBLE_TIME_STEP * 1e-6);
+    BENCH_CLOBBER();
+}
+
+static void bm_orbit_propagate(void *ctx, uint64_t iters)
+{
+    while (iters--) // one ACS period per operation
+        orbit_propagate(&g_orbit, DETUMBLE_TIME_STEP * 1e-6);
+    BENCH_CLOBBER();
+}
+
+static void bm_orbit_ephem_eval(void *ctx, uint64_t iters)
+{
+    const orbit_ephem_t *eph = (const orbit_ephem_t *)ctx;
+    orbit_state_t s;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        orbit_ephem_eval(eph, i * DETUMBLE_TIME_STEP * 1e-6, &s);
+        BENCH_ESCAPE(s.r[0]);
+    }
+}
+
+/**
+ * @brief Copy of the field model with a lookup grid attached, built in main().
+ *
+ */
+static field_model_t bench_field_grid;
+
+static void bm_field_eval_ecef(void *ctx, uint64_t iters)
+{
+    double B[3];
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        field_eval_ecef(&g_field, bench_pos[i & (BENCH_NUM_INPUTS - 1)], B);
+        BENCH_ESCAPE(B[0]);
+    }
+}
+
+static void bm_field_grid_eval(void *ctx, uint64_t iters)
+{
+    double B[3];
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        field_grid_eval(bench_field_grid.grid, bench_pos[i & (BENCH_NUM_INPUTS - 1)], B);
+        BENCH_ESCAPE(B[0]);
+    }
+}
+
+static void bm_sun_position(void *ctx, uint64_t iters)
+{
+    double r[3];
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        sun_position(g_epoch_jd + i * 1e-3, r);
+        BENCH_ESCAPE(r[0]);
+    }
+}
+
+static void bm_sun_shadow(void *ctx, uint64_t iters)
+{
+    double f = 0;
+    for (uint64_t i = 0; i < iters; i++)
+        f += sun_shadow(bench_pos[i & (BENCH_NUM_INPUTS - 1)], g_eclipse.r_sun, SUN_SHADOW_CONICAL);
+    BENCH_ESCAPE(f);
+}
+
+static void bm_sun_eclipse_predict(void *ctx, uint64_t iters)
+{
+    const orbit_ephem_t *eph = (const orbit_ephem_t *)ctx;
+    sun_eclipse_t ec;
+    for (uint64_t i = 0; i < iters; i++)
+    {
+        sun_eclipse_predict(&ec, &g_orbit, eph, 0, eph->span, g_epoch_jd, SUN_SHADOW_CONICAL);
+        BENCH_ESCAPE(ec.exit);
+    }
+}
+
+static void bm_readSensors(void *ctx, uint64_t iters)
+{
+    int acc = 0;
+    while (iters--)
+        acc += readSensors();
+    BENCH_ESCAPE(acc);
+}
+
+/**
+ * @brief Benchmark table, in the order in which the benchmarks are run.
+ *
+ */
+static const struct
+{
+    const char *name;
+    bench_fn fn;
+    vec_isa isa; // instruction set level needed
+} benchmarks[] = {
+    {"calculateBessel", bm_calculateBessel},
+    {"computeBessel", bm_computeBessel},
+    {"dfilterBessel", bm_dfilterBessel},
+    {"ffilterBessel", bm_ffilterBessel},
+    {"dfilterBesselFixed", bm_dfilterBesselFixed},
+    {"ffilterBesselFixed", bm_ffilterBesselFixed},
+    {"APPLY_DBESSEL", bm_APPLY_DBESSEL},
+    {"APPLY_DFILTER (none)", bm_filter_none},
+    {"APPLY_DFILTER (bessel 3 5)", bm_filter_bessel},
+    {"APPLY_DFILTER (butterworth 2 5)", bm_filter_butterworth},
+    {"APPLY_DFILTER (moving_average 8)", bm_filter_moving_average},
+    {"APPLY_DFILTER (alpha_beta 0.5 0.1)", bm_filter_alpha_beta},
+    {"q2isqrt", bm_q2isqrt},
+    {"1/sqrtf", bm_invsqrtf},
+    {"NORMALIZE", bm_NORMALIZE},
+    {"vec_isqrtf (scalar)", bm_vec_isqrtf_scalar, VEC_ISA_SCALAR},
+    {"vec_isqrtf (sse)", bm_vec_isqrtf_sse, VEC_ISA_SSE},
+    {"vec_isqrtf (avx2)", bm_vec_isqrtf_avx2, VEC_ISA_AVX2},
+    {"vec_isqrtf (avx512)", bm_vec_isqrtf_avx512, VEC_ISA_AVX512},
+    {"vec_normalize3f (scalar)", bm_vec_normalize3f_scalar, VEC_ISA_SCALAR},
+    {"vec_normalize3f (sse)", bm_vec_normalize3f_sse, VEC_ISA_SSE},
+    {"vec_normalize3f (avx2)", bm_vec_normalize3f_avx2, VEC_ISA_AVX2},
+    {"vec_normalize3f (avx512)", bm_vec_normalize3f_avx512, VEC_ISA_AVX512},
+    {"CROSS_PRODUCT", bm_CROSS_PRODUCT},
+    {"MATVECMUL", bm_MATVECMUL},
+    {"vec_cross3f", bm_vec_cross3f},
+    {"vec_matvec3f", bm_vec_matvec3f},
+    {"faverage (serial, 64)", bm_faverage_serial},
+    {"faverage (64)", bm_faverage},
+    {"faverage (serial, 1M)", bm_faverage_serial_log},
+    {"faverage (1M)", bm_faverage_log},
+    {"daverage (1M)", bm_daverage_log},
+    {"ravg_replace", bm_ravg_replace},
+    {"ring_daverage (48 of 64)", bm_ring_daverage},
+    {"wrapped average (48 of 64)", bm_wrapped_average},
+    {"winstat3_push", bm_winstat3_push},
+    {"window stats (rescan)", bm_winstat_rescan},
+    {"dynamics_rk4 (1 substep)", bm_dynamics_rk4},
+    {"dynamics_rk45 (1 period)", bm_dynamics_rk45},
+    {"orbit_propagate (1 period)", bm_orbit_propagate},
+    {"orbit_ephem_eval", bm_orbit_ephem_eval},
+    {"field_eval_ecef", bm_field_eval_ecef},
+    {"field_grid_eval", bm_field_grid_eval},
+    {"sun_position", bm_sun_position},
+    {"sun_shadow (conical)", bm_sun_shadow},
+    {"sun_eclipse_predict (1 orbit)", bm_sun_eclipse_predict},
+    {"readSensors", bm_readSensors},
+};
+
+int main(int argc, char *argv[])
+{
+    const char *outfile = NULL;
+    const char *filter = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:f:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'o':
+            outfile = optarg;
+            break;
+        case 'f':
+            filter = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-o results.json] [-f name_substring]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    FILE *fp = NULL;
+    if (outfile != NULL && (fp = fopen(outfile, "a")) == NULL)
+    {
+        perror("[BENCH] fopen");
+        return 1;
+    }
+
+    init_inputs();
+    calculateBessel(bessel_coeff, besselSize(), 3, BESSEL_FREQ_CUTOFF);
+    if (arena_init(&bench_arena, FILTER_TYPE_COUNT * FILTER_ARENA_SIZE(SH_BUFFER_SIZE) + WINSTAT3_ARENA_SIZE(SH_BUFFER_SIZE)) < 0 ||
+        winstat3_alloc(&bench_stat, &bench_arena, SH_BUFFER_SIZE) < 0)
+        return 1;
+    for (int i = 0; i < FILTER_TYPE_COUNT; i++)
+    {
+        filter_config_t cfg;
+        if (filter_parse(&cfg, bench_filter_specs[i]) < 0 || filter_alloc(&bench_filters[i], &bench_arena, SH_BUFFER_SIZE) < 0 ||
+            filter_init(&bench_filters[i], &cfg) < 0)
+            return 1;
+    }
+    for (int i = 0; i < 10; i++) // fill up the buffers the same way datavis does before its loop
+        readSensors();
+    orbit_ephem_t eph;
+    orbit_ephem_build(&eph, &g_orbit, orbit_period(&g_orbit_elements), 0);
+    bench_field_grid = g_field;
+    bench_field_grid.grid = NULL;
+    if (field_grid_build(&bench_field_grid, EARTH_RADIUS + 300, EARTH_RADIUS + 700, 9, M_PI / 90) < 0)
+        return 1;
+
+    vec_isa isa = vec_select(VEC_ISA_COUNT);
+    bench_print_header();
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+    {
+        if ((filter != NULL && strstr(benchmarks[i].name, filter) == NULL) || benchmarks[i].isa > isa)
+            continue;
+        bench_result res = bench_run(benchmarks[i].name, benchmarks[i].fn, &eph);
+        bench_print(&res);
+        bench_write_json(fp, "kernels", &res);
+    }
+    vec_select(isa);
+    if (filter == NULL || strstr("vec_isqrtf vec_normalize3f", filter) != NULL)
+        vec_accuracy(fp);
+    if (filter == NULL || strstr("calculateBessel computeBessel dfilterBesselFixed ffilterBesselFixed", filter) != NULL)
+        bessel_table_check();
+    if (filter == NULL || strstr("faverage daverage ravg_replace", filter) != NULL)
+        average_accuracy(fp);
+    if (filter == NULL || strstr("APPLY_DFILTER", filter) != NULL)
+    {
+        printf("\n");
+        for (int i = 0; i < FILTER_TYPE_COUNT; i++)
+            filter_print(stdout, "bench", &bench_filters[i]);
+    }
+    orbit_ephem_free(&eph);
+    field_grid_free(&bench_field_grid);
+    arena_free(&bench_arena);
+    if (fp != NULL)
+        fclose(fp);
+    return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file bench_omega.c
+ * @brief Offline angular velocity recomputation benchmark. Records the B-dot samples of a simulation
+ * as a log, then recomputes the unfiltered omega estimate of getOmega() over the whole log, one vector
+ * at a time with the macros of macros.h and in one pass with vec_omega3f(), against a copy of the same
+ * bytes as the memory bandwidth reference.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <unistd.h>
+#include "bench/bench.h"
+#include "acs-datagen.h"
+#include "vecmath.h"
+
+/**
+ * @brief Recomputes omega one vector at a time, as getOmega() does.
+ *
+ */
+static void omega_macros(float *wx, float *wy, float *wz, const float *x, const float *y, const float *z, float freq, int n)
+{
+    for (int i = 1; i < n; i++)
+    {
+        DECLARE_VECTOR(b1, float);
+        DECLARE_VECTOR(b0, float);
+        DECLARE_VECTOR(w, float);
+        x_b1 = x[i];
+        y_b1 = y[i];
+        z_b1 = z[i];
+        x_b0 = x[i - 1];
+        y_b0 = y[i - 1];
+        z_b0 = z[i - 1];
+        CROSS_PRODUCT(w, b1, b0);
+        float norm2 = NORM2(b0);
+        VECTOR_MIXED(w, w, freq / norm2, *);
+        wx[i] = x_w;
+        wy[i] = y_w;
+        wz[i] = z_w;
+    }
+}
+
+/**
+ * @brief Times a pass over the log, best of reps.
+ *
+ */
+#define BENCH_BEST(best, reps, stmt)                      \
+    do                                                    \
+    {                                                     \
+        best = INFINITY;                                  \
+        for (int r__ = 0; r__ < (reps); r__++)            \
+        {                                                 \
+            uint64_t t0__ = bench_nsec();                 \
+            stmt;                                         \
+            BENCH_CLOBBER();                              \
+            double dt__ = (bench_nsec() - t0__) * 1e-9;   \
+            best = dt__ < best ? dt__ : best;             \
+        }                                                 \
+    } while (0)
+
+int main(int argc, char *argv[])
+{
+    int n = 1 << 22;     // samples in the log
+    int steps = 1 << 15; // ACS steps simulated, the recorded samples are repeated to fill the log
+    int reps = 10;
+    const char *outfile = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:s:r:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            if (loadScenario(optarg) < 0)
+                return 1;
+            break;
+        case 'n':
+            n = atoi(optarg);
+            break;
+        case 's':
+            steps = atoi(optarg);
+            break;
+        case 'r':
+            reps = atoi(optarg);
+            break;
+        case 'o':
+            outfile = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-i scenario.ini] [-n log samples] [-s simulated steps] [-r repetitions] [-o results.json]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    n = n < 2 ? 2 : n;
+    reps = reps < 1 ? 1 : reps;
+    calculateBessel(bessel_coeff, besselSize(), g_scenario.bessel_order, g_scenario.bessel_cutoff);
+    float *buf = (float *)malloc(9 * (size_t)n * sizeof(float));
+    if (buf == NULL)
+    {
+        perror("[BENCH] malloc");
+        return 1;
+    }
+    float *bx = buf, *by = buf + n, *bz = buf + 2 * (size_t)n;
+    float *wx = buf + 3 * (size_t)n, *wy = buf + 4 * (size_t)n, *wz = buf + 5 * (size_t)n;
+    float *vx = buf + 6 * (size_t)n, *vy = buf + 7 * (size_t)n, *vz = buf + 8 * (size_t)n;
+
+    // record the filtered B-dot samples, as the datavis packets carry them
+    int recorded = 0;
+    uint64_t last = RING_COUNT(g_Bt);
+    for (int i = 0; i < steps && recorded < n; i++)
+    {
+        readSensors();
+        if (RING_COUNT(g_Bt) != last)
+        {
+            int bdot_index = RING_HEAD(g_Bt);
+            bx[recorded] = x_g_Bt[bdot_index];
+            by[recorded] = y_g_Bt[bdot_index];
+            bz[recorded] = z_g_Bt[bdot_index];
+            recorded++;
+        }
+        last = RING_COUNT(g_Bt);
+    }
+    if (recorded < 2)
+    {
+        fprintf(stderr, "[BENCH] No B-dot samples in %d steps\n", steps);
+        return 1;
+    }
+    for (int i = recorded; i < n; i++)
+    {
+        bx[i] = bx[i % recorded];
+        by[i] = by[i % recorded];
+        bz[i] = bz[i % recorded];
+    }
+    float freq = 1e6 / g_mag_dt;
+
+    double t_macros, t_vec, t_copy;
+    BENCH_BEST(t_macros, reps, omega_macros(wx, wy, wz, bx, by, bz, freq, n));
+    BENCH_BEST(t_vec, reps, vec_omega3f(vx + 1, vy + 1, vz + 1, bx + 1, by + 1, bz + 1, bx, by, bz, freq, n - 1));
+    // same traffic as the recomputation: the log read once, the estimates written once
+    BENCH_BEST(t_copy, reps, (memcpy(vx, bx, n * sizeof(float)), memcpy(vy, by, n * sizeof(float)), memcpy(vz, bz, n * sizeof(float))));
+    // the copy overwrote the estimates, recompute them for the comparison
+    vec_omega3f(vx + 1, vy + 1, vz + 1, bx + 1, by + 1, bz + 1, bx, by, bz, freq, n - 1);
+
+    double max_rel = 0;
+    for (int i = 1; i < n; i++)
+    {
+        double d = sqrt((double)(vx[i] - wx[i]) * (vx[i] - wx[i]) + (double)(vy[i] - wy[i]) * (vy[i] - wy[i]) + (double)(vz[i] - wz[i]) * (vz[i] - wz[i]));
+        double w = sqrt((double)wx[i] * wx[i] + (double)wy[i] * wy[i] + (double)wz[i] * wz[i]);
+        if (w > 0 && d / w > max_rel)
+            max_rel = d / w;
+    }
+    double bytes = 6.0 * n * sizeof(float);
+    printf("%d samples (%d recorded over %d steps), %.1f MB read and written per pass\n", n, recorded, steps, bytes * 1e-6);
+    printf("%-20s %10s %10s %10s\n", "pass", "ms", "ns/sample", "GB/s");
+    printf("%-20s %10.3f %10.3f %10.2f\n", "macros", t_macros * 1e3, t_macros * 1e9 / n, bytes / t_macros * 1e-9);
+    printf("%-20s %10.3f %10.3f %10.2f\n", "vec_omega3f", t_vec * 1e3, t_vec * 1e9 / n, bytes / t_vec * 1e-9);
+    printf("%-20s %10.3f %10.3f %10.2f\n", "memcpy", t_copy * 1e3, t_copy * 1e9 / n, bytes / t_copy * 1e-9);
+    printf("speedup %.1fx, %.0f%% of the copy bandwidth, max relative difference %.2e\n", t_macros / t_vec, 100 * t_copy / t_vec, max_rel);
+    if (outfile != NULL)
+    {
+        FILE *fp = fopen(outfile, "a");
+        if (fp == NULL)
+            perror("[BENCH] fopen");
+        else
+        {
+            fprintf(fp, "{\"suite\":\"omega\",\"samples\":%d,\"macros_ns\":%.4f,\"vec_ns\":%.4f,\"copy_ns\":%.4f,\"vec_gbps\":%.3f,\"copy_gbps\":%.3f,"
+                        "\"max_rel\":%.4e,\"time\":%lld}\n",
+                    n, t_macros * 1e9 / n, t_vec * 1e9 / n, t_copy * 1e9 / n, bytes / t_vec * 1e-9, bytes / t_copy * 1e-9, max_rel, (long long)time(NULL));
+            fclose(fp);
+        }
+    }
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,300 @@
+/**
+ * @file bench_precision.c
+ * @brief Precision benchmark. Records the attitude and field of a simulation, then runs the estimation
+ * pipeline of readSensors() (field to the body frame, Bessel filtered field, B-dot, omega, B-dot command)
+ * over the log once in double and once in single precision, written once with the type-generic kernels
+ * of vec3.h. Reports, stage by stage, the error of the float pipeline against the error the magnetometer
+ * noise already causes, and the cost of both precisions.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <unistd.h>
+#include "bench/bench.h"
+#include "acs-datagen.h"
+#include "vec3.h"
+#include "vecmath.h"
+
+/**
+ * @brief One step of the recorded log.
+ *
+ */
+typedef struct
+{
+    quatd_t q;     // true attitude
+    vec3d_t B_I;   // inertial field (mG)
+    vec3d_t w;     // true angular velocity (rad s^-1)
+    vec3d_t noise; // magnetometer noise (mG)
+} log_entry_t;
+
+/**
+ * @brief Stages of the pipeline, in order.
+ *
+ */
+enum
+{
+    STAGE_BODY = 0, // measured field in the body frame
+    STAGE_B,        // filtered field
+    STAGE_BDOT,     // filtered B-dot
+    STAGE_OMEGA,    // filtered angular velocity estimate
+    STAGE_CMD,      // saturated B-dot dipole command
+    STAGE_COUNT
+};
+
+static const char *stage_name[STAGE_COUNT] = {"field (body)", "field (filtered)", "B-dot", "omega", "dipole command"};
+
+/**
+ * @brief Defines the pipeline of one precision: its state pipe_<sfx>_t and pipe_<sfx>_step(). The body
+ * is the same for both precisions, the kernels follow the type of the operands.
+ *
+ * @param sfx f or d
+ * @param T float or double
+ */
+#define PIPELINE(sfx, T)                                                                                              \
+    typedef struct                                                                                                    \
+    {                                                                                                                 \
+        T B[3][SH_BUFFER_MAX], Bt[3][SH_BUFFER_MAX], W[3][SH_BUFFER_MAX];                                             \
+        int n;                                                                                                        \
+    } pipe_##sfx##_t;                                                                                                 \
+    /* Bessel filters the newest element of a buffer and stores the result in its place, as APPLY_DBESSEL() */      \
+    static inline vec3##sfx##_t filter_##sfx(T buf[3][SH_BUFFER_MAX], int idx, vec3##sfx##_t v, int ntaps)           \
+    {                                                                                                                 \
+        buf[0][idx] = v.x;                                                                                            \
+        buf[1][idx] = v.y;                                                                                            \
+        buf[2][idx] = v.z;                                                                                            \
+        T acc[3] = {0, 0, 0}, csum = 0;                                                                               \
+        for (int k = 0; k < ntaps; k++)                                                                               \
+        {                                                                                                             \
+            int j = (idx - k) & bessel_mask;                                                                          \
+            T c = bessel_coeff[k];                                                                                    \
+            for (int a = 0; a < 3; a++)                                                                               \
+                acc[a] += c * buf[a][j];                                                                              \
+            csum += c;                                                                                                \
+        }                                                                                                             \
+        for (int a = 0; a < 3; a++)                                                                                   \
+            buf[a][idx] = acc[a] / csum;                                                                              \
+        return (vec3##sfx##_t){buf[0][idx], buf[1][idx], buf[2][idx]};                                                \
+    }                                                                                                                 \
+    static inline vec3##sfx##_t ring_##sfx(T buf[3][SH_BUFFER_MAX], int idx)                                          \
+    {                                                                                                                 \
+        return (vec3##sfx##_t){buf[0][idx], buf[1][idx], buf[2][idx]};                                                \
+    }                                                                                                                 \
+    static void pipe_##sfx##_step(pipe_##sfx##_t *p, const log_entry_t *e, int noisy, int ntaps, vec3d_t out[])       \
+    {                                                                                                                 \
+        const T freq = 1e6 / DETUMBLE_TIME_STEP, gain = BDOT_GAIN, m_sat = DIPOLE_MOMENT;                             \
+        int idx = p->n & bessel_mask;                                                                                 \
+        p->n++;                                                                                                       \
+        vec3##sfx##_t Bb = QUAT_TO_BODY(quatd_to_##sfx(e->q), vec3d_to_##sfx(e->B_I));                                \
+        if (noisy)                                                                                                    \
+            Bb = VEC3_ADD(Bb, vec3d_to_##sfx(e->noise));                                                              \
+        out[STAGE_BODY] = vec3##sfx##_to_d(Bb);                                                                       \
+        vec3##sfx##_t B = filter_##sfx(p->B, idx, Bb, ntaps);                                                         \
+        out[STAGE_B] = vec3##sfx##_to_d(B);                                                                           \
+        for (int s = STAGE_BDOT; s < STAGE_COUNT; s++)                                                                \
+            out[s] = (vec3d_t){0, 0, 0};                                                                              \
+        if (p->n < 2)                                                                                                 \
+            return;                                                                                                   \
+        int bidx = (p->n - 2) & bessel_mask;                                                                          \
+        vec3##sfx##_t Bt = VEC3_SCALE(VEC3_SUB(B, ring_##sfx(p->B, (idx - 1) & bessel_mask)), freq);                  \
+        Bt = filter_##sfx(p->Bt, bidx, Bt, ntaps);                                                                    \
+        out[STAGE_BDOT] = vec3##sfx##_to_d(Bt);                                                                       \
+        if (p->n >= 3)                                                                                                \
+        {                                                                                                             \
+            vec3##sfx##_t Bp = ring_##sfx(p->Bt, (bidx - 1) & bessel_mask);                                           \
+            vec3##sfx##_t W = VEC3_SCALE(VEC3_CROSS(Bt, Bp), freq / VEC3_NORM2(Bp));                                  \
+            W = filter_##sfx(p->W, (p->n - 3) & bessel_mask, W, ntaps);                                               \
+            out[STAGE_OMEGA] = vec3##sfx##_to_d(W);                                                                   \
+        }                                                                                                             \
+        vec3##sfx##_t m = VEC3_SCALE(Bt, -gain);                                                                      \
+        T ax = m.x < 0 ? -m.x : m.x, ay = m.y < 0 ? -m.y : m.y, az = m.z < 0 ? -m.z : m.z;                            \
+        T m_max = ax > ay ? ax : ay;                                                                                  \
+        m_max = az > m_max ? az : m_max;                                                                              \
+        if (m_max > m_sat)                                                                                            \
+            m = VEC3_SCALE(m, m_sat / m_max);                                                                         \
+        out[STAGE_CMD] = vec3##sfx##_to_d(m);                                                                         \
+    }
+
+PIPELINE(f, float)
+PIPELINE(d, double)
+
+/**
+ * @brief Runs the pipeline of one precision over the whole log.
+ *
+ * @return double Wall time (s)
+ */
+static double run_f(const log_entry_t *log, int n, int noisy, int ntaps, vec3d_t (*out)[STAGE_COUNT])
+{
+    static pipe_f_t p;
+    memset(&p, 0, sizeof(p));
+    uint64_t t0 = bench_nsec();
+    for (int i = 0; i < n; i++)
+        pipe_f_step(&p, &log[i], noisy, ntaps, out[i]);
+    return (bench_nsec() - t0) * 1e-9;
+}
+
+static double run_d(const log_entry_t *log, int n, int noisy, int ntaps, vec3d_t (*out)[STAGE_COUNT])
+{
+    static pipe_d_t p;
+    memset(&p, 0, sizeof(p));
+    uint64_t t0 = bench_nsec();
+    for (int i = 0; i < n; i++)
+        pipe_d_step(&p, &log[i], noisy, ntaps, out[i]);
+    return (bench_nsec() - t0) * 1e-9;
+}
+
+/**
+ * @brief RMS of |a - b| over |b|, for one stage, skipping the first samples while the filters fill up.
+ *
+ */
+static double rms_rel(vec3d_t (*a)[STAGE_COUNT], vec3d_t (*b)[STAGE_COUNT], int stage, int n, int skip)
+{
+    double num = 0, den = 0;
+    for (int i = skip; i < n; i++)
+    {
+        vec3d_t d = VEC3_SUB(a[i][stage], b[i][stage]);
+        num += VEC3_NORM2(d);
+        den += VEC3_NORM2(b[i][stage]);
+    }
+    return den > 0 ? sqrt(num / den) : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int steps = 20000;
+    int reps = 10;
+    unsigned int seed = 1;
+    const char *outfile = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:r:s:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            if (loadScenario(optarg) < 0)
+                return 1;
+            seed = g_scenario.seed;
+            break;
+        case 'n':
+            steps = atoi(optarg);
+            break;
+        case 'r':
+            reps = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            outfile = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-i scenario.ini] [-n steps] [-r repetitions] [-s seed] [-o results.json]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    steps = steps < 100 ? 100 : steps;
+    reps = reps < 1 ? 1 : reps;
+    calculateBessel(bessel_coeff, besselSize(), g_scenario.bessel_order, g_scenario.bessel_cutoff);
+    int ntaps = 1;
+    while (ntaps < bessel_depth && bessel_coeff[ntaps] >= BESSEL_MIN_THRESHOLD)
+        ntaps++;
+    log_entry_t *log = (log_entry_t *)malloc(steps * sizeof(log_entry_t));
+    vec3d_t(*out)[STAGE_COUNT] = malloc(3 * (size_t)steps * sizeof(*out));
+    if (log == NULL || out == NULL)
+    {
+        perror("[BENCH] malloc");
+        return 1;
+    }
+    vec3d_t(*clean)[STAGE_COUNT] = out, (*dbl)[STAGE_COUNT] = out + steps, (*flt)[STAGE_COUNT] = out + 2 * steps;
+
+    // the closed-loop simulation, recorded step by step
+    srand(seed);
+    for (int i = 0; i < steps; i++)
+    {
+        readSensors();
+        log[i].q = (quatd_t){g_dyn.q[0], g_dyn.q[1], g_dyn.q[2], g_dyn.q[3]};
+        log[i].B_I = (vec3d_t){g_B_I[0], g_B_I[1], g_B_I[2]};
+        log[i].w = (vec3d_t){g_dyn.w[0], g_dyn.w[1], g_dyn.w[2]};
+        log[i].noise = (vec3d_t){MAG_NOISE * ((1.0 * rand()) / RAND_MAX - 0.5), MAG_NOISE * ((1.0 * rand()) / RAND_MAX - 0.5),
+                                 MAG_NOISE * ((1.0 * rand()) / RAND_MAX - 0.5)};
+    }
+
+    run_d(log, steps, 0, ntaps, clean);
+    double t_d = INFINITY, t_f = INFINITY;
+    for (int r = 0; r < reps; r++)
+    {
+        double t = run_d(log, steps, 1, ntaps, dbl);
+        t_d = t < t_d ? t : t_d;
+        t = run_f(log, steps, 1, ntaps, flt);
+        t_f = t < t_f ? t : t_f;
+    }
+    // the omega estimate against the truth
+    double w_err_d = 0, w_err_f = 0, w_rms = 0;
+    int skip = 3 * bessel_depth;
+    for (int i = skip; i < steps; i++)
+    {
+        w_err_d += VEC3_NORM2(VEC3_SUB(dbl[i][STAGE_OMEGA], log[i].w));
+        w_err_f += VEC3_NORM2(VEC3_SUB(flt[i][STAGE_OMEGA], log[i].w));
+        w_rms += VEC3_NORM2(log[i].w);
+    }
+
+    // the array kernels, where single precision doubles the SIMD width
+    int n = steps - 1;
+    float *af = (float *)malloc(6 * (size_t)steps * sizeof(float));
+    double *ad = (double *)malloc(6 * (size_t)steps * sizeof(double));
+    if (af == NULL || ad == NULL)
+    {
+        perror("[BENCH] malloc");
+        return 1;
+    }
+    for (int i = 0; i < steps; i++)
+    {
+        ad[i] = af[i] = dbl[i][STAGE_BDOT].x;
+        ad[steps + i] = af[steps + i] = dbl[i][STAGE_BDOT].y;
+        ad[2 * steps + i] = af[2 * steps + i] = dbl[i][STAGE_BDOT].z;
+    }
+    double ta_f = INFINITY, ta_d = INFINITY;
+    float ffreq = 1e6 / DETUMBLE_TIME_STEP;
+    for (int r = 0; r < reps * 10; r++)
+    {
+        uint64_t t0 = bench_nsec();
+        VEC_OMEGA3(af + 3 * steps, af + 4 * steps, af + 5 * steps, af + 1, af + steps + 1, af + 2 * steps + 1, af, af + steps, af + 2 * steps, ffreq, n);
+        BENCH_CLOBBER();
+        double t = (bench_nsec() - t0) * 1e-9;
+        ta_f = t < ta_f ? t : ta_f;
+        t0 = bench_nsec();
+        VEC_OMEGA3(ad + 3 * steps, ad + 4 * steps, ad + 5 * steps, ad + 1, ad + steps + 1, ad + 2 * steps + 1, ad, ad + steps, ad + 2 * steps, 1e6 / DETUMBLE_TIME_STEP, n);
+        BENCH_CLOBBER();
+        t = (bench_nsec() - t0) * 1e-9;
+        ta_d = t < ta_d ? t : ta_d;
+    }
+
+    FILE *fp = NULL;
+    if (outfile != NULL && (fp = fopen(outfile, "a")) == NULL)
+        perror("[BENCH] fopen");
+    printf("%d steps, magnetometer noise %d mG peak to peak, %d filter taps\n", steps, MAG_NOISE, ntaps);
+    printf("%-18s %14s %14s %10s\n", "stage", "noise rms rel", "float rms rel", "ratio");
+    for (int s = 0; s < STAGE_COUNT; s++)
+    {
+        double e_noise = rms_rel(dbl, clean, s, steps, skip), e_float = rms_rel(flt, dbl, s, steps, skip);
+        printf("%-18s %14.3e %14.3e %10.2e\n", stage_name[s], e_noise, e_float, e_noise > 0 ? e_float / e_noise : 0);
+        if (fp != NULL)
+            fprintf(fp, "{\"suite\":\"precision\",\"stage\":\"%s\",\"noise_rel\":%.4e,\"float_rel\":%.4e,\"time\":%lld}\n", stage_name[s], e_noise,
+                    e_float, (long long)time(NULL));
+    }
+    printf("omega vs true rate, rms rel: double %.4e, float %.4e\n", sqrt(w_err_d / w_rms), sqrt(w_err_f / w_rms));
+    printf("pipeline: double %.1f ns/step, float %.1f ns/step\n", t_d * 1e9 / steps, t_f * 1e9 / steps);
+    printf("vec_omega3: double %.3f ns/sample, float %.3f ns/sample (%.1fx)\n", ta_d * 1e9 / n, ta_f * 1e9 / n, ta_d / ta_f);
+    if (fp != NULL)
+    {
+        fprintf(fp, "{\"suite\":\"precision\",\"pipeline_d_ns\":%.3f,\"pipeline_f_ns\":%.3f,\"omega3d_ns\":%.4f,\"omega3f_ns\":%.4f,\"time\":%lld}\n",
+                t_d * 1e9 / steps, t_f * 1e9 / steps, ta_d * 1e9 / n, ta_f * 1e9 / n, (long long)time(NULL));
+        fclose(fp);
+    }
+    free(log);
+    free(out);
+    free(af);
+    free(ad);
+    return 0;
+}
@@ -0,0 +1,324 @@
+/**
+ * @file bench_server.c
+ * @brief End-to-end throughput benchmark of the DataVis telemetry server.
+ * Starts the server on loopback, attaches K synthetic clients and measures
+ * frames/sec, bytes/sec and publication-to-receipt latency.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <stddef.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include "bench/bench.h"
+#include "datavis.h"
+
+/**
+ * @brief Size of a frame on the wire, the length byte followed by the packet.
+ *
+ */
+#define FRAME_SIZE (PACK_SIZE + sizeof(char))
+/**
+ * @brief Maximum number of latency samples kept per client (reservoir sampled).
+ *
+ */
+#define MAX_LAT_SAMPLES (1 << 16)
+
+/**
+ * @brief State and results of one synthetic client.
+ *
+ */
+typedef struct
+{
+    int port;
+    double duration;           // measurement window (s)
+    pthread_barrier_t *start;  // released once every client is connected
+    int ok;                    // connected and received at least one frame
+    uint64_t frames;           // frames received in the window
+    uint64_t bytes;            // bytes received in the window
+    uint64_t bad_frames;       // frames with a broken start marker
+    uint32_t overruns0;        // server overrun count at the start of the window
+    uint32_t overruns1;        // server overrun count at the end of the window
+    uint32_t nlat;             // latency samples stored
+    uint32_t seed;             // reservoir sampling seed
+    uint32_t lat[MAX_LAT_SAMPLES]; // publication to receipt latency (usec)
+} client_t;
+
+static inline uint64_t usec_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts); // same clock as get_usec() in the server
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static int connect_retry(int port, double timeout)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    uint64_t tend = bench_nsec() + timeout * 1e9;
+    while (bench_nsec() < tend)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+            return fd;
+        close(fd);
+        usleep(10000);
+    }
+    return -1;
+}
+
+static void *client_thread(void *arg)
+{
+    client_t *cl = (client_t *)arg;
+    int fd = connect_retry(cl->port, 5);
+    pthread_barrier_wait(cl->start);
+    if (fd < 0)
+        return NULL;
+    struct timeval tv = {.tv_sec = 1, .tv_usec = 0}; // do not hang if the server stops
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    unsigned char buf[FRAME_SIZE * 256];
+    size_t have = 0;
+    uint64_t seen = 0; // frames offered to the latency reservoir
+    uint64_t tstart = bench_nsec();
+    uint64_t tend = tstart + cl->duration * 1e9;
+    int first = 1;
+    while (bench_nsec() < tend)
+    {
+        ssize_t sz = recv(fd, buf + have, sizeof(buf) - have, 0);
+        if (sz <= 0)
+            break;
+        uint64_t trecv = usec_now();
+        have += sz;
+        cl->bytes += sz;
+        size_t off = 0;
+        for (; have - off >= FRAME_SIZE; off += FRAME_SIZE)
+        {
+            datavis_p pack;
+            memcpy(&pack, buf + off + 1, PACK_SIZE);
+            if (buf[off] != (uint8_t)PACK_SIZE || memcmp(pack.start, "FBEGIN", 6) != 0)
+            {
+                cl->bad_frames++;
+                continue;
+            }
+            if (first)
+            {
+                cl->overruns0 = pack.loop_overruns;
+                first = 0;
+            }
+            cl->overruns1 = pack.loop_overruns;
+            cl->frames++;
+            uint32_t lat = trecv > pack.tpub ? trecv - pack.tpub : 0;
+            if (cl->nlat < MAX_LAT_SAMPLES)
+                cl->lat[cl->nlat++] = lat;
+            else
+            {
+                uint64_t j = rand_r(&cl->seed) % (seen + 1);
+                if (j < MAX_LAT_SAMPLES)
+                    cl->lat[j] = lat;
+            }
+            seen++;
+        }
+        memmove(buf, buf + off, have - off);
+        have -= off;
+    }
+    cl->duration = (bench_nsec() - tstart) * 1e-9;
+    cl->ok = cl->frames > 0;
+    close(fd);
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static pid_t start_server(const char *path, int port, double rate, int clients)
+{
+    char sport[16], srate[32], sclients[16];
+    snprintf(sport, sizeof(sport), "%d", port);
+    snprintf(srate, sizeof(srate), "%f", rate);
+    snprintf(sclients, sizeof(sclients), "%d", clients);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0)
+            dup2(devnull, STDOUT_FILENO);
+        if (rate > 0)
+            execl(path, path, "-p", sport, "-c", sclients, "-r", srate, (char *)NULL);
+        else
+            execl(path, path, "-p", sport, "-c", sclients, "-f", (char *)NULL);
+        perror("[BENCH] execl");
+        _exit(127);
+    }
+    return pid;
+}
+
+static int run(const char *server, int port, double rate, int k, double duration, FILE *fp)
+{
+    pid_t pid = start_server(server, port, rate, k);
+    if (pid < 0)
+    {
+        perror("[BENCH] fork");
+        return -1;
+    }
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, k);
+    client_t *cls = (client_t *)calloc(k, sizeof(client_t));
+    pthread_t *tids = (pthread_t *)calloc(k, sizeof(pthread_t));
+    if (cls == NULL || tids == NULL)
+    {
+        perror("[BENCH] calloc");
+        kill(pid, SIGINT);
+        waitpid(pid, NULL, 0);
+        free(cls);
+        free(tids);
+        return -1;
+    }
+    for (int i = 0; i < k; i++)
+    {
+        cls[i].port = port;
+        cls[i].duration = duration;
+        cls[i].start = &barrier;
+        cls[i].seed = 1 + i;
+        pthread_create(&tids[i], NULL, client_thread, &cls[i]);
+    }
+    for (int i = 0; i < k; i++)
+        pthread_join(tids[i], NULL);
+    kill(pid, SIGINT);
+    waitpid(pid, NULL, 0);
+    pthread_barrier_destroy(&barrier);
+
+    // aggregate
+    int nok = 0;
+    uint64_t frames = 0, bytes = 0, bad = 0, nlat = 0, overruns = 0;
+    double fps_min = INFINITY, fps_sum = 0;
+    for (int i = 0; i < k; i++)
+    {
+        if (!cls[i].ok)
+            continue;
+        nok++;
+        double fps = cls[i].frames / cls[i].duration;
+        fps_min = fps < fps_min ? fps : fps_min;
+        fps_sum += fps;
+        frames += cls[i].frames;
+        bytes += cls[i].bytes;
+        bad += cls[i].bad_frames;
+        nlat += cls[i].nlat;
+        uint32_t ovr = cls[i].overruns1 - cls[i].overruns0;
+        overruns = ovr > overruns ? ovr : overruns;
+    }
+    uint32_t *lat = (uint32_t *)malloc((nlat > 0 ? nlat : 1) * sizeof(uint32_t));
+    uint64_t n = 0;
+    for (int i = 0; i < k && lat != NULL; i++)
+        for (uint32_t j = 0; cls[i].ok && j < cls[i].nlat; j++)
+            lat[n++] = cls[i].lat[j];
+    double p50 = 0, p99 = 0, pmax = 0;
+    if (n > 0)
+    {
+        qsort(lat, n, sizeof(uint32_t), cmp_u32);
+        p50 = lat[n / 2];
+        p99 = lat[(99 * n + 99) / 100 - 1];
+        pmax = lat[n - 1];
+    }
+    free(lat);
+    if (nok == 0)
+        fps_min = 0;
+    double fps_total = fps_sum;
+    double bps_total = 0;
+    for (int i = 0; i < k; i++)
+        if (cls[i].ok)
+            bps_total += cls[i].bytes / cls[i].duration;
+
+    printf("%4d %5d %12.1f %12.1f %10.3f %10.0f %10.0f %10.0f %9llu %6llu\n", k, nok, fps_min, fps_total,
+           bps_total / 1e6, p50, p99, pmax, (unsigned long long)overruns, (unsigned long long)bad);
+    if (fp != NULL)
+        fprintf(fp, "{\"suite\":\"server\",\"clients\":%d,\"connected\":%d,\"rate\":%.3f,\"duration\":%.3f,"
+                    "\"steps_per_s\":%.3f,\"frames_per_s\":%.3f,\"bytes_per_s\":%.3f,"
+                    "\"lat_p50_us\":%.0f,\"lat_p99_us\":%.0f,\"lat_max_us\":%.0f,\"overruns\":%llu,\"bad_frames\":%llu,\"time\":%lld}\n",
+                k, nok, rate, duration, fps_min, fps_total, bps_total, p50, p99, pmax,
+                (unsigned long long)overruns, (unsigned long long)bad, (long long)time(NULL));
+    free(cls);
+    free(tids);
+    return nok == k ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *server = "./acs-datagen.out";
+    const char *outfile = NULL;
+    char klist_def[] = "1,2,4,8,16";
+    char *klist = klist_def;
+    int port = PORT + 1; // stay off the port of a running instance
+    double rate = 0;     // 0 == as fast as possible
+    double duration = 3;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:p:k:r:t:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            server = optarg;
+            break;
+        case 'p':
+            port = atoi(optarg);
+            break;
+        case 'k':
+            klist = optarg;
+            break;
+        case 'r':
+            rate = atof(optarg);
+            break;
+        case 't':
+            duration = atof(optarg);
+            break;
+        case 'o':
+            outfile = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-s server] [-p port] [-k clients,...] [-r step rate (Hz), 0 == as fast as possible] [-t seconds] [-o results.json]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    FILE *fp = NULL;
+    if (outfile != NULL && (fp = fopen(outfile, "a")) == NULL)
+    {
+        perror("[BENCH] fopen");
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    printf("server %s, %s, %.1f s per run, %zu byte frames\n", server, rate > 0 ? "fixed rate" : "as fast as possible", duration, FRAME_SIZE);
+    if (rate > 0)
+        printf("requested step rate %.1f Hz\n", rate);
+    printf("%4s %5s %12s %12s %10s %10s %10s %10s %9s %6s\n", "K", "conn", "steps/s", "frames/s", "MB/s", "p50 us", "p99 us", "max us", "overruns", "bad");
+    int ret = 0;
+    for (char *tok = strtok(klist, ","); tok != NULL; tok = strtok(NULL, ","))
+    {
+        int k = atoi(tok);
+        if (k < 1 || k > DATAVIS_MAX_CLIENTS)
+        {
+            fprintf(stderr, "[BENCH] Skipping K = %s, must be within 1...%d\n", tok, DATAVIS_MAX_CLIENTS);
+            continue;
+        }
+        if (run(server, port, rate, k, duration, fp) < 0)
+            ret = 1;
+    }
+    if (fp != NULL)
+        fclose(fp);
+    return ret;
+}
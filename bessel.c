@@ -9,24 +9,66 @@
  * 
  */
 #include <bessel.h>
+#include <ring.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
+#ifndef BESSEL_GEN
 /**
- * @brief Coefficients for the Bessel filter, calculated using calculateBessel().
+ * @brief Coefficients for the Bessel filter, set to the default table at build time and changed using calculateBessel().
  * 
  */
-float bessel_coeff[SH_BUFFER_SIZE]; // coefficients for Bessel filter, declared as floating point
+float bessel_coeff[SH_BUFFER_MAX] = BESSEL_DEFAULT_TABLE; // coefficients for Bessel filter, declared as floating point
+
+#define BESSEL_TABLE_ARRAY(order, cutoff, name) static const float bessel_table_##name[SH_BUFFER_SIZE] = BESSEL_TABLE_##name;
+BESSEL_TABLES(BESSEL_TABLE_ARRAY)
+#undef BESSEL_TABLE_ARRAY
+
+/**
+ * @brief Coefficient tables generated at build time, see bessel_tables.h.
+ * 
+ */
+static const struct
+{
+    int order;
+    float cutoff;
+    const float *coeff;
+} bessel_tables[] = {
+#define BESSEL_TABLE_ENTRY(order, cutoff, name) {order, cutoff, bessel_table_##name},
+    BESSEL_TABLES(BESSEL_TABLE_ENTRY)
+#undef BESSEL_TABLE_ENTRY
+};
+#else  // BESSEL_GEN
+float bessel_coeff[SH_BUFFER_MAX];
+#endif // BESSEL_GEN
+/**
+ * @brief Number of past elements the filters read from the circular buffers, at most SH_BUFFER_MAX. Set at runtime by the scenario, using setBesselDepth().
+ * 
+ */
+int bessel_depth = SH_BUFFER_SIZE;
+/**
+ * @brief Capacity of the circular buffers - 1, the filters index them with (index - k) & bessel_mask.
+ * 
+ */
+uint32_t bessel_mask = SH_BUFFER_SIZE - 1;
+
+int setBesselDepth(int depth)
+{
+    bessel_depth = depth < 1 ? 1 : depth > SH_BUFFER_MAX ? SH_BUFFER_MAX : depth;
+    bessel_mask = ring_capacity(bessel_depth) - 1;
+    return bessel_mask + 1;
+}
 
 /**
  * @brief Calculates factorial of the input. This function is inlined, and is available only in the scope of bessel.c.
  * 
  * @param i Input
- * @return float Factorial of input
+ * @return double Factorial of input
  */
-static inline float factorial(int i)
+static inline double factorial(int i)
 {
-    float result = 1;
+    double result = 1;
     i = i + 1;
     while (--i > 0)
         result *= i;
@@ -35,8 +77,26 @@ static inline float factorial(int i)
 
 void calculateBessel(float arr[], int size, int order, float freq_cutoff)
 {
-    if (order > 5) // max 5th order
-        order = 5;
+#ifndef BESSEL_GEN
+    for (size_t i = 0; i < sizeof(bessel_tables) / sizeof(bessel_tables[0]); i++)
+    {
+        if (bessel_tables[i].order == order && bessel_tables[i].cutoff == freq_cutoff && size <= SH_BUFFER_SIZE)
+        {
+            memcpy(arr, bessel_tables[i].coeff, size * sizeof(float));
+            return;
+        }
+    }
+#endif // BESSEL_GEN
+    computeBessel(arr, size, order, freq_cutoff);
+}
+
+void computeBessel(float arr[], int size, int order, float freq_cutoff)
+{
+    if (order > BESSEL_MAX_ORDER)
+    {
+        fprintf(stderr, "[BESSEL] Order %d capped at %d\n", order, BESSEL_MAX_ORDER);
+        order = BESSEL_MAX_ORDER;
+    }
     float *coeff = (float *)calloc(order + 1, sizeof(float)); // declare array to hold numeric coeff
     if (coeff == NULL)
     {
@@ -65,41 +125,71 @@ void calculateBessel(float arr[], int size, int order, float freq_cutoff)
 }
 
 double dfilterBessel(double arr[], int index)
+{
+    return dfilterBesselCoeff(bessel_coeff, arr, index);
+}
+
+double dfilterBesselCoeff(const float coeff[], double arr[], int index)
 {
     double val = 0;
-    // index is guaranteed to be a number between 0...SH_BUFFER_SIZE by the readSensors() or getOmega() function.
-    int coeff_index = 0;
     double coeff_sum = 0; // sum of the coefficients to calculate weighted average
-    for (int i = index;;) // initiate the loop, break condition will be dealt with inside the loop
+    // the newest value always counts, then past values while the coefficient stays above the threshold, at most bessel_depth in all
+    for (int k = 0; k < bessel_depth && (k == 0 || coeff[k] >= BESSEL_MIN_THRESHOLD); k++)
     {
-        val += bessel_coeff[coeff_index] * arr[i]; // add weighted value
-        coeff_sum += bessel_coeff[coeff_index];    // sum the weights to average with
-        i--;                                       // read the previous element
-        i = i < 0 ? SH_BUFFER_SIZE - 1 : i;        // allow for circular buffer issues
-        coeff_index++;                             // use the next coefficient
-        // looped around to the same element, coefficient crosses threshold OR (should never come to this) coeff_index overflows, break loop
-        if (i == index || bessel_coeff[coeff_index] < BESSEL_MIN_THRESHOLD || coeff_index > SH_BUFFER_SIZE)
-            break;
+        val += coeff[k] * arr[(index - k) & bessel_mask]; // add weighted value, k samples back in the circular buffer
+        coeff_sum += coeff[k];                                   // sum the weights to average with
     }
     return val / coeff_sum;
 }
 
 float ffilterBessel(float arr[], int index)
+{
+    return ffilterBesselCoeff(bessel_coeff, arr, index);
+}
+
+float ffilterBesselCoeff(const float coeff[], float arr[], int index)
 {
     float val = 0;
-    // index is guaranteed to be a number between 0...SH_BUFFER_SIZE by the readSensors() or getOmega() function.
-    int coeff_index = 0;
-    float coeff_sum = 0;  // sum of the coefficients to calculate weighted average
-    for (int i = index;;) // initiate the loop, break condition will be dealt with inside the loop
+    float coeff_sum = 0; // sum of the coefficients to calculate weighted average
+    // the newest value always counts, then past values while the coefficient stays above the threshold, at most bessel_depth in all
+    for (int k = 0; k < bessel_depth && (k == 0 || coeff[k] >= BESSEL_MIN_THRESHOLD); k++)
     {
-        val += bessel_coeff[coeff_index] * arr[i]; // add weighted value
-        coeff_sum += bessel_coeff[coeff_index];    // sum the weights to average with
-        i--;                                       // read the previous element
-        i = i < 0 ? SH_BUFFER_SIZE - 1 : i;        // allow for circular buffer issues
-        coeff_index++;                             // use the next coefficient
-        // looped around to the same element, coefficient crosses threshold OR (should never come to this) coeff_index overflows, break loop
-        if (i == index || bessel_coeff[coeff_index] < BESSEL_MIN_THRESHOLD || coeff_index > SH_BUFFER_SIZE)
-            break;
+        val += coeff[k] * arr[(index - k) & bessel_mask]; // add weighted value, k samples back in the circular buffer
+        coeff_sum += coeff[k];                                   // sum the weights to average with
     }
     return val / coeff_sum;
-}
\ No newline at end of file
+}
+
+#ifndef BESSEL_GEN
+int calculateBesselQ15(q15_t w[], const float coeff[], int depth)
+{
+    int taps = 1;
+    double sum = coeff[0];
+    while (taps < depth && coeff[taps] >= BESSEL_MIN_THRESHOLD) // the taps of dfilterBessel()
+        sum += coeff[taps++];
+    int wsum = 0;
+    for (int i = 0; i < taps; i++)
+    {
+        w[i] = q15_from_double(coeff[i] / sum);
+        wsum += w[i];
+    }
+    for (int i = taps; i < SH_BUFFER_MAX; i++)
+        w[i] = 0;
+    int32_t w0 = w[0] + Q15_ONE - wsum; // rounding residue to the largest weight, unit gain at DC
+    if (w0 > INT16_MAX)                 // a single tap of 1.0, one LSB short of unit gain
+    {
+        w0 = INT16_MAX;
+        fxp_saturations++;
+    }
+    w[0] = w0;
+    return taps;
+}
+
+q31_t qfilterBessel(const q15_t w[], int taps, q31_t arr[], int index)
+{
+    int64_t acc = 0; // Q46, the weights add up to 1.0 so the sum cannot overflow
+    for (int k = 0; k < taps; k++)
+        acc += (int64_t)w[k] * arr[(index - k) & bessel_mask]; // circular buffer
+    return q31_sat((acc + (1 << 14)) >> 15);
+}
+#endif // BESSEL_GEN
@@ -10,7 +10,16 @@
  */
 #ifndef __SHFLIGHT_BESSEL_H
 #define __SHFLIGHT_BESSEL_H
-#define SH_BUFFER_SIZE 64
+#include <stdint.h>
+#define SH_BUFFER_SIZE 64 // default buffer depth, and length of the generated coefficient tables
+/**
+ * @brief Largest buffer depth. The circular buffers are sized at runtime to the depth rounded up to a power of 2.
+ * 
+ */
+#ifndef SH_BUFFER_MAX
+#define SH_BUFFER_MAX 512
+#endif
+_Static_assert((SH_BUFFER_MAX & (SH_BUFFER_MAX - 1)) == 0 && SH_BUFFER_MAX >= SH_BUFFER_SIZE, "SH_BUFFER_MAX must be a power of 2, at least SH_BUFFER_SIZE");
 /**
  * @brief Bessel coefficient minimum value threshold for computation
  * 
@@ -26,10 +35,42 @@
 #define BESSEL_FREQ_CUTOFF 5 // cutoff frequency 5 == 5*DETUMBLE_TIME_STEP seconds cycle == 2 Hz at 100ms loop speed
 #endif
 
-extern float bessel_coeff[SH_BUFFER_SIZE]; // coefficients for Bessel filter, declared as floating point
+#ifndef BESSEL_MAX_ORDER
+#define BESSEL_MAX_ORDER 10 // highest order, the polynomial coefficients are exact in double precision up to 11
+#endif
+
+#ifndef BESSEL_GEN
+#include "bessel_tables.h" // generated by bessel_gen.out, see the Makefile
+#include "fixedpt.h"
+#endif
+
+extern float bessel_coeff[SH_BUFFER_MAX]; // coefficients for Bessel filter, declared as floating point
+extern int bessel_depth;                  // number of past elements the filters read from the circular buffers, at most SH_BUFFER_MAX
+extern uint32_t bessel_mask;              // capacity of the circular buffers - 1, the capacity is bessel_depth rounded up to a power of 2
 
 /**
- * @brief Calculates discrete Bessel filter coefficients for the given order and cutoff frequency.
+ * @brief Sets the depth of the circular buffers, and the mask the filters index them with. The buffers must
+ * then be reallocated to the new capacity.
+ * 
+ * @param depth Number of past elements the filters read, 1 to SH_BUFFER_MAX
+ * @return int Capacity of the circular buffers
+ */
+int setBesselDepth(int depth);
+
+/**
+ * @brief Number of coefficients calculateBessel() should compute for the current depth: the depth, and at
+ * least the length of the generated tables so that they still apply.
+ * 
+ */
+static inline int besselSize(void)
+{
+    return bessel_depth > SH_BUFFER_SIZE ? bessel_depth : SH_BUFFER_SIZE;
+}
+
+/**
+ * @brief Gets discrete Bessel filter coefficients for the given order and cutoff frequency: copied from the
+ * tables generated at build time (bessel_tables.h) when there is one for the order and cut-off, computed
+ * with computeBessel() otherwise.
  * 
  * @param arr Stores the filter coefficients
  * @param size Size of the filter coefficients array
@@ -38,6 +79,17 @@ extern float bessel_coeff[SH_BUFFER_SIZE]; // coefficients for Bessel filter, de
  */
 void calculateBessel(float arr[], int size, int order, float freq_cutoff);
 
+/**
+ * @brief Calculates discrete Bessel filter coefficients for the given order and cutoff frequency.
+ * Used by bessel_gen.out to generate the tables. Orders above BESSEL_MAX_ORDER are capped, with a warning.
+ * 
+ * @param arr Stores the filter coefficients
+ * @param size Size of the filter coefficients array
+ * @param order Order of the Bessel filter
+ * @param freq_cutoff Cut-off frequency of the Bessel filter
+ */
+void computeBessel(float arr[], int size, int order, float freq_cutoff);
+
 /**
  * @brief Returns the filtered value at the current index using past values
  * 
@@ -57,7 +109,133 @@ double dfilterBessel(double arr[], int index);
 float ffilterBessel(float arr[], int index);
 
 /**
- * @brief Applies double precision Bessel filter on a buffer declared using DECLARE_BUFFER(), and stores the filtered value at the current index.
+ * @brief Returns the filtered value at the current index using past values, with the given coefficients
+ * instead of bessel_coeff.
+ * 
+ * @param coeff Filter coefficients, at least bessel_depth elements
+ * @param arr Input array
+ * @param index Index of current value in the array
+ * @return double Filtered value
+ */
+double dfilterBesselCoeff(const float coeff[], double arr[], int index);
+
+/**
+ * @brief Returns the filtered value at the current index using past values, with the given coefficients
+ * instead of bessel_coeff.
+ * 
+ * @param coeff Filter coefficients, at least bessel_depth elements
+ * @param arr Input array
+ * @param index Index of current value in the array
+ * @return float Filtered value
+ */
+float ffilterBesselCoeff(const float coeff[], float arr[], int index);
+
+#ifndef BESSEL_GEN
+/**
+ * @brief Calculates the Q15 weights of the fixed-point Bessel filter: the coefficients that dfilterBessel() would
+ * use on buffers of the given depth, divided by their sum and rounded so that the weights add up to exactly 1.0,
+ * which spares the division of every filtered sample. A single tap saturates at the largest Q15 weight, counted
+ * in fxp_saturations.
+ * 
+ * @param w Stores the weights, SH_BUFFER_MAX elements
+ * @param coeff Filter coefficients, from calculateBessel()
+ * @param depth Depth of the filtered buffers
+ * @return int Number of taps
+ */
+int calculateBesselQ15(q15_t w[], const float coeff[], int depth);
+
+/**
+ * @brief Returns the fixed-point filtered value at the current index using past values, as dfilterBessel().
+ * The products are accumulated in 64 bits (SMLAL on ARM) and the result saturated.
+ * 
+ * @param w Weights from calculateBesselQ15()
+ * @param taps Number of taps from calculateBesselQ15()
+ * @param arr Input array
+ * @param index Index of current value in the array
+ * @return q31_t Filtered value
+ */
+q31_t qfilterBessel(const q15_t w[], int taps, q31_t arr[], int index);
+
+/**
+ * @brief Applies the fixed-point Bessel filter on a Q31 buffer declared using DECLARE_RING(), and stores the filtered value at the current index.
+ * 
+ * @param name Name of the buffer
+ * @param index Current index
+ * @param w Weights from calculateBesselQ15()
+ * @param taps Number of taps from calculateBesselQ15()
+ */
+#define APPLY_QBESSEL(name, index, w, taps)                   \
+    x_##name[index] = qfilterBessel(w, taps, x_##name, index); \
+    y_##name[index] = qfilterBessel(w, taps, y_##name, index); \
+    z_##name[index] = qfilterBessel(w, taps, z_##name, index)
+
+/**
+ * @brief Returns the filtered value at the current index using past values, with the default coefficient table
+ * (BESSEL_DEFAULT_TABLE) instead of bessel_coeff. The coefficients and the number of taps are known at compile
+ * time, so the loop is fully unrolled and the sum of the coefficients folded. Falls back to dfilterBessel() on
+ * buffers shallower than the table.
+ * 
+ * @param arr Input array
+ * @param index Index of current value in the array
+ * @return double Filtered value
+ */
+static inline double dfilterBesselFixed(double arr[], int index)
+{
+    static const float coeff[SH_BUFFER_SIZE] = BESSEL_DEFAULT_TABLE;
+    if (bessel_depth < BESSEL_DEFAULT_TAPS)
+        return dfilterBessel(arr, index);
+    double val = 0, coeff_sum = 0;
+#pragma GCC unroll 64
+    for (int k = 0; k < BESSEL_DEFAULT_TAPS; k++)
+    {
+        val += coeff[k] * arr[(index - k) & bessel_mask]; // circular buffer
+        coeff_sum += coeff[k];
+    }
+    return val / coeff_sum;
+}
+
+/**
+ * @brief Returns the filtered value at the current index using past values, with the default coefficient table.
+ * See dfilterBesselFixed().
+ * 
+ * @param arr Input array
+ * @param index Index of current value in the array
+ * @return float Filtered value
+ */
+static inline float ffilterBesselFixed(float arr[], int index)
+{
+    static const float coeff[SH_BUFFER_SIZE] = BESSEL_DEFAULT_TABLE;
+    if (bessel_depth < BESSEL_DEFAULT_TAPS)
+        return ffilterBessel(arr, index);
+    float val = 0, coeff_sum = 0;
+#pragma GCC unroll 64
+    for (int k = 0; k < BESSEL_DEFAULT_TAPS; k++)
+    {
+        val += coeff[k] * arr[(index - k) & bessel_mask]; // circular buffer
+        coeff_sum += coeff[k];
+    }
+    return val / coeff_sum;
+}
+#endif // BESSEL_GEN
+
+#ifdef BESSEL_FIXED
+/*
+ * Flight builds with a fixed filter: APPLY_DBESSEL() and APPLY_FBESSEL() filter with the default table, unrolled,
+ * whatever order and cut-off calculateBessel() was given. The filter bank uses the table only for filters at
+ * BESSEL_DEFAULT_ORDER and BESSEL_DEFAULT_CUTOFF.
+ */
+#define APPLY_DBESSEL(name, index)                         \
+    x_##name[index] = dfilterBesselFixed(x_##name, index); \
+    y_##name[index] = dfilterBesselFixed(y_##name, index); \
+    z_##name[index] = dfilterBesselFixed(z_##name, index)
+
+#define APPLY_FBESSEL(name, index)                         \
+    x_##name[index] = ffilterBesselFixed(x_##name, index); \
+    y_##name[index] = ffilterBesselFixed(y_##name, index); \
+    z_##name[index] = ffilterBesselFixed(z_##name, index)
+#else // BESSEL_FIXED
+/**
+ * @brief Applies double precision Bessel filter on a buffer declared using DECLARE_RING(), and stores the filtered value at the current index.
  * 
  * @param name Name of the buffer
  * @param index Index of the current value in the buffer
@@ -70,7 +248,7 @@ float ffilterBessel(float arr[], int index);
     z_##name[index] = dfilterBessel(z_##name, index)
 
 /**
- * @brief Applies floating point Bessel filter on a buffer declared using DECLARE_BUFFER(), and stores the filtered value at the current index.
+ * @brief Applies floating point Bessel filter on a buffer declared using DECLARE_RING(), and stores the filtered value at the current index.
  * 
  * @param name Name of the buffer
  * @param index Index of the current value in the buffer
@@ -81,5 +259,6 @@ float ffilterBessel(float arr[], int index);
     x_##name[index] = ffilterBessel(x_##name, index); \
     y_##name[index] = ffilterBessel(y_##name, index); \
     z_##name[index] = ffilterBessel(z_##name, index)
+#endif // BESSEL_FIXED
 
 #endif // __SHFLIGHT_BESSEL_H
\ No newline at end of file
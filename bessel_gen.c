@@ -0,0 +1,159 @@
+/**
+ * @file bessel_gen.c
+ * @brief Build step that generates bessel_tables.h: the Bessel filter coefficients of the configured orders and
+ * cut-offs as constant tables, computed with computeBessel() so that they are the values calculateBessel()
+ * would compute at run time, bit for bit.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <bessel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BESSEL_GEN_MAX 64 // maximum number of orders or cut-offs
+
+/**
+ * @brief Parses a space separated list of numbers.
+ *
+ * @return int Number of values, -1 on error
+ */
+static int parse_list(const char *str, double *vals)
+{
+    int n = 0;
+    char *end;
+    for (;;)
+    {
+        while (*str == ' ')
+            str++;
+        if (*str == '\0')
+            return n;
+        double v = strtod(str, &end);
+        if (end == str || n == BESSEL_GEN_MAX)
+            return -1;
+        vals[n++] = v;
+        str = end;
+    }
+}
+
+/**
+ * @brief Name of a table, e.g. O3_C5 for order 3 and cut-off 5, O3_C2P5 for order 3 and cut-off 2.5.
+ *
+ */
+static void table_name(char *buf, size_t size, int order, float cutoff)
+{
+    snprintf(buf, size, "O%d_C%g", order, cutoff);
+    for (char *c = buf; *c; c++)
+        *c = *c == '.' ? 'P' : *c == '-' ? 'M' : *c;
+}
+
+/**
+ * @brief Number of coefficients dfilterBessel() uses, at most SH_BUFFER_SIZE.
+ *
+ */
+static int table_taps(const float *coeff)
+{
+    int taps = 1;
+    while (taps < SH_BUFFER_SIZE && coeff[taps] >= BESSEL_MIN_THRESHOLD)
+        taps++;
+    return taps;
+}
+
+static void print_table(int order, float cutoff)
+{
+    char name[64];
+    float coeff[SH_BUFFER_SIZE];
+    table_name(name, sizeof(name), order, cutoff);
+    computeBessel(coeff, SH_BUFFER_SIZE, order, cutoff);
+    printf("\n// order %d, cut-off %g samples\n", order, cutoff);
+    printf("#define BESSEL_TAPS_%s %d\n", name, table_taps(coeff));
+    printf("#define BESSEL_TABLE_%s \\\n    {", name);
+    for (int i = 0; i < SH_BUFFER_SIZE; i++)
+        printf("%s%af", i == 0 ? " \\\n        " : i % 4 ? ", " : ", \\\n        ", coeff[i]);
+    printf(" \\\n    }\n");
+}
+
+int main(int argc, char *argv[])
+{
+    double orders[BESSEL_GEN_MAX] = {3}, cutoffs[BESSEL_GEN_MAX] = {BESSEL_FREQ_CUTOFF};
+    int norders = 1, ncutoffs = 1;
+    int def_order = 3;
+    float def_cutoff = BESSEL_FREQ_CUTOFF;
+    int opt;
+    while ((opt = getopt(argc, argv, "O:c:d:D:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'O':
+            norders = parse_list(optarg, orders);
+            break;
+        case 'c':
+            ncutoffs = parse_list(optarg, cutoffs);
+            break;
+        case 'd':
+            def_order = atoi(optarg);
+            break;
+        case 'D':
+            def_cutoff = atof(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-O \"orders\"] [-c \"cut-offs\"] [-d default order] [-D default cut-off] > bessel_tables.h\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (norders < 1 || ncutoffs < 1)
+    {
+        fprintf(stderr, "[BESSEL] Invalid list of orders or cut-offs (at most %d each)\n", BESSEL_GEN_MAX);
+        return 1;
+    }
+
+    printf("/* Generated by bessel_gen.out, do not edit: change BESSEL_ORDERS, BESSEL_CUTOFFS, BESSEL_ORDER and\n"
+           " * BESSEL_CUTOFF in the Makefile instead. */\n");
+    printf("#ifndef __BESSEL_TABLES_H\n#define __BESSEL_TABLES_H\n\n");
+    printf("#if SH_BUFFER_SIZE != %d\n#error \"bessel_tables.h generated for another SH_BUFFER_SIZE, run make clean\"\n#endif\n", SH_BUFFER_SIZE);
+
+    // the default pair is always tabulated, listed or not
+    int def_listed = 0;
+    char list[8192] = "";
+    size_t len = 0;
+    for (int i = 0; i < norders; i++)
+    {
+        for (int j = 0; j < ncutoffs; j++)
+        {
+            char name[64];
+            int order = orders[i];
+            float cutoff = cutoffs[j];
+            table_name(name, sizeof(name), order, cutoff);
+            print_table(order, cutoff);
+            len += snprintf(list + len, sizeof(list) - len, " \\\n    X(%d, %af, %s)", order, cutoff, name);
+            def_listed |= order == def_order && cutoff == def_cutoff;
+        }
+    }
+    if (!def_listed)
+    {
+        char name[64];
+        table_name(name, sizeof(name), def_order, def_cutoff);
+        print_table(def_order, def_cutoff);
+        len += snprintf(list + len, sizeof(list) - len, " \\\n    X(%d, %af, %s)", def_order, def_cutoff, name);
+    }
+    if (len >= sizeof(list))
+    {
+        fprintf(stderr, "[BESSEL] Too many tables\n");
+        return 1;
+    }
+
+    char def_name[64];
+    table_name(def_name, sizeof(def_name), def_order, def_cutoff);
+    printf("\n// every table, as X(order, cut-off, name)\n#define BESSEL_TABLES(X)%s\n", list);
+    printf("\n// table of bessel_coeff before any call to calculateBessel(), and of the BESSEL_FIXED filters\n");
+    printf("#define BESSEL_DEFAULT_ORDER %d\n", def_order);
+    printf("#define BESSEL_DEFAULT_CUTOFF %af\n", def_cutoff);
+    printf("#define BESSEL_DEFAULT_TAPS BESSEL_TAPS_%s\n", def_name);
+    printf("#define BESSEL_DEFAULT_TABLE BESSEL_TABLE_%s\n", def_name);
+    printf("\n#endif // __BESSEL_TABLES_H\n");
+    return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file config.c
+ * @brief Minimal INI file parser for run scenarios.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/**
+ * @brief Strips leading and trailing whitespace in place.
+ *
+ * @param s String
+ * @return char* First non-whitespace character of s
+ */
+static char *config_trim(char *s)
+{
+    while (isspace((unsigned char)*s))
+        s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1]))
+        end--;
+    *end = '\0';
+    return s;
+}
+
+int config_parse(const char *path, config_handler handler, void *ctx)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        perror("[CONFIG] fopen");
+        return -1;
+    }
+    char line[CONFIG_MAX_LINE], section[64] = "";
+    int lineno = 0, err = 0;
+    while (err == 0 && fgets(line, sizeof(line), fp) != NULL)
+    {
+        lineno++;
+        char *s = config_trim(line);
+        if (*s == '\0' || *s == '#' || *s == ';')
+            continue;
+        if (*s == '[')
+        {
+            char *end = strchr(s, ']');
+            if (end == NULL || (size_t)(end - s - 1) >= sizeof(section))
+            {
+                err = lineno;
+                break;
+            }
+            *end = '\0';
+            strcpy(section, config_trim(s + 1));
+            continue;
+        }
+        char *eq = strchr(s, '=');
+        if (eq == NULL)
+        {
+            err = lineno;
+            break;
+        }
+        *eq = '\0';
+        char *value = eq + 1;
+        for (char *c = value; *c; c++) // trailing comment
+            if ((*c == '#' || *c == ';') && (c == value || isspace((unsigned char)c[-1])))
+            {
+                *c = '\0';
+                break;
+            }
+        if (!handler(ctx, section, config_trim(s), config_trim(value)))
+            err = lineno;
+    }
+    fclose(fp);
+    return err;
+}
+
+int config_doubles(const char *value, double *out, int n)
+{
+    int count = 0;
+    const char *s = value;
+    while (*s)
+    {
+        while (isspace((unsigned char)*s) || *s == ',')
+            s++;
+        if (*s == '\0')
+            break;
+        char *end;
+        double v = strtod(s, &end);
+        if (end == s || count == n)
+            return -1;
+        out[count++] = v;
+        s = end;
+    }
+    return count;
+}
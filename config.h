@@ -0,0 +1,53 @@
+/**
+ * @file config.h
+ * @brief Minimal INI file parser for run scenarios.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __CONFIG_H
+#define __CONFIG_H
+
+#ifndef CONFIG_MAX_LINE
+/**
+ * @brief Longest line accepted in a configuration file.
+ *
+ */
+#define CONFIG_MAX_LINE 512
+#endif
+
+/**
+ * @brief Called for every key = value pair, with surrounding whitespace and trailing comments removed.
+ *
+ * @param ctx User context
+ * @param section Current section, "" before the first section header
+ * @param key Key
+ * @param value Value
+ * @return int 1 if the pair was accepted, 0 to report an error on this line
+ */
+typedef int (*config_handler)(void *ctx, const char *section, const char *key, const char *value);
+
+/**
+ * @brief Parses an INI file: [section] headers, key = value pairs, and comments starting with '#' or ';'
+ * (at the start of a line, or after whitespace in a value).
+ *
+ * @param path Configuration file
+ * @param handler Handler of the key = value pairs
+ * @param ctx User context passed to the handler
+ * @return int 0 on success, the number of the first bad line, or -1 if the file could not be read
+ */
+int config_parse(const char *path, config_handler handler, void *ctx);
+
+/**
+ * @brief Parses up to n whitespace or comma separated numbers.
+ *
+ * @param value String to parse
+ * @param out Parsed numbers
+ * @param n Maximum number of values
+ * @return int Number of values parsed, -1 if the string holds anything else
+ */
+int config_doubles(const char *value, double *out, int n);
+
+#endif // __CONFIG_H
@@ -10,6 +10,7 @@
 #include <signal.h>
 #include <pthread.h>
 #include "bessel.h"
+#include "loopmon.h"
 #include "acs-datagen.h"
 
 volatile sig_atomic_t done = 0;
@@ -33,23 +34,146 @@ pthread_mutex_t datavis_mutex;
  * 
  */
 pthread_cond_t datavis_drdy;
+/**
+ * @brief Period, jitter and overrun monitor of the ACS loop.
+ * 
+ */
+loopmon_t g_loopmon;
 
 typedef struct sockaddr sk_sockaddr;
 
+/**
+ * @brief Accepts all pending DataVis connections on the non-blocking server socket. The client sockets are made
+ * non-blocking too (accept() does not inherit O_NONBLOCK on Linux), so that a stalled console cannot block the loop.
+ * 
+ * @param server_fd Listening socket
+ * @param clients Array of client sockets, -1 marks a free slot
+ * @param max_clients Length of the client array
+ * @return int Number of connected clients
+ */
+static int datavis_accept(int server_fd, int clients[], int max_clients)
+{
+    int num_clients = 0;
+    for (int i = 0; i < max_clients; i++)
+    {
+        if (clients[i] < 0)
+        {
+            if ((clients[i] = accept(server_fd, NULL, NULL)) < 0)
+            {
+#ifdef SERVER_DEBUG
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    perror("accept");
+#endif
+                continue;
+            }
+            int flags = fcntl(clients[i], F_GETFL, 0);
+            if (flags < 0 || fcntl(clients[i], F_SETFL, flags | O_NONBLOCK) < 0)
+            {
+                perror("fcntl");
+                close(clients[i]);
+                clients[i] = -1;
+                continue;
+            }
+        }
+        num_clients++;
+    }
+    return num_clients;
+}
+
 int main(int argc, char *argv[])
 {
     signal(SIGINT, sighandler);
+    signal(SIGTERM, sighandler);
+
+    int port = 0;
+    int fast = 0;                              // run steps back to back, without waiting for the next period
+    uint32_t loop_period = DETUMBLE_TIME_STEP; // wall clock period of the ACS loop (usec)
+    unsigned long long max_steps = 0;          // stop after this many ACS steps, 0 == run until interrupted
+    int max_clients = DATAVIS_MAX_CLIENTS;
+    const char *fault_file = NULL;
+    unsigned long long fault_seed = 1;
+    const char *restore_file = NULL;    // checkpoint to resume from
+    const char *checkpoint_file = NULL; // checkpoint written on exit
+    int c;
+    while ((c = getopt(argc, argv, "i:p:fr:n:c:F:S:R:C:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'i':
+            if (loadScenario(optarg) < 0)
+                return 1;
+            loop_period = DETUMBLE_TIME_STEP;
+            if (g_scenario.fault_file[0] != '\0')
+                fault_file = g_scenario.fault_file;
+            fault_seed = g_scenario.fault_seed;
+            break;
+        case 'p':
+            port = atoi(optarg);
+            break;
+        case 'f':
+            fast = 1;
+            break;
+        case 'r':
+            loop_period = 1000000 / (atof(optarg) > 0 ? atof(optarg) : 1);
+            break;
+        case 'n':
+            max_steps = strtoull(optarg, NULL, 10);
+            break;
+        case 'c':
+            max_clients = atoi(optarg);
+            if (max_clients < 1 || max_clients > DATAVIS_MAX_CLIENTS)
+                max_clients = DATAVIS_MAX_CLIENTS;
+            break;
+        case 'F':
+            fault_file = optarg;
+            break;
+        case 'S':
+            fault_seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'R':
+            restore_file = optarg;
+            break;
+        case 'C':
+            checkpoint_file = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-i scenario.ini] [-p port] [-f] [-r step rate (Hz)] [-n steps] [-c max clients] [-F fault script] [-S fault seed] [-R checkpoint] [-C checkpoint]\n"
+                            "\t-f: as fast as possible, ignores -r\n"
+                            "\t-R: resume from a checkpoint, -C: write a checkpoint on exit\n"
+                            "\tOptions are applied in order, so options after -i override the scenario.\n",
+                    argv[0]);
+            return c == 'h' ? 0 : 1;
+        }
+    }
+    if (fast)
+        loop_period = 0;
+    if (port == 0)
+        port = g_scenario.port > 0 ? g_scenario.port : PORT;
+    seedRand(g_scenario.seed);
+
+    fault_plan_t faults;
+    fault_init(&faults);
+    if (fault_file != NULL)
+    {
+        // compile the plan over the run, or a day of simulation time if the run is open ended or resumed
+        uint64_t horizon = max_steps > 0 && restore_file == NULL ? max_steps + 10 : 86400ULL * 1000000 / DETUMBLE_TIME_STEP;
+        if (fault_load(&faults, fault_file) < 0 || fault_compile(&faults, horizon, DETUMBLE_TIME_STEP * 1e-6, fault_seed) < 0)
+            return 1;
+        g_faults = &faults;
+    }
 
     // init for bessel coefficients
-    calculateBessel(bessel_coeff, SH_BUFFER_SIZE, 3, BESSEL_FREQ_CUTOFF);
+    calculateBessel(bessel_coeff, besselSize(), g_scenario.bessel_order, g_scenario.bessel_cutoff);
     // initialize target omega
     z_g_W_target = 1;                       // 1 rad s^-1
     MATVECMUL(g_L_target, MOI, g_W_target); // calculate target angular momentum
 
-    int server_fd, new_socket = -1;
+    int server_fd;
+    int clients[DATAVIS_MAX_CLIENTS];
+    for (int i = 0; i < DATAVIS_MAX_CLIENTS; i++)
+        clients[i] = -1;
     struct sockaddr_in address;
     int opt = 1;
-    int addrlen = sizeof(address);
 
     // Creating socket file descriptor
     if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0)
@@ -82,7 +206,7 @@ int main(int argc, char *argv[])
 
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(PORT);
+    address.sin_port = htons(port);
 
     // Forcefully attaching socket to the port 8080
     if (bind(server_fd, (struct sockaddr *)&address,
@@ -91,20 +215,32 @@ int main(int argc, char *argv[])
         perror("bind failed");
         pthread_exit(NULL);
     }
-    if (listen(server_fd, 3) < 0)
+    if (listen(server_fd, max_clients) < 0)
     {
         perror("listen");
         pthread_exit(NULL);
     }
     for (int i = 0; i < 10; i++)
         readSensors();
+    if (restore_file != NULL)
+    {
+        if (loadCheckpoint(restore_file, NULL) < 0)
+            return 1;
+        if (max_steps > 0)
+            max_steps += acs_ct; // count the steps of this session only
+    }
     memcpy(g_datavis_st.data.start, "FBEGIN", 6);
     memcpy(g_datavis_st.data.end, "FEND", 4);
-    while (!done)
+    loopmon_init(&g_loopmon, loop_period);
+    uint64_t tstart = get_usec();
+    while (!done && (max_steps == 0 || acs_ct < max_steps))
     {
+        loopmon_start(&g_loopmon, get_usec()); // actual start of this period
         readSensors();
-        g_datavis_st.data.tstart = 0;
-        g_datavis_st.data.tnow = acs_ct * 100 * 1000;
+        g_t_acs = get_usec();
+        g_datavis_st.data.tstart = tstart;
+        g_datavis_st.data.tnow = acs_ct * DETUMBLE_TIME_STEP;
+        int mag_index = RING_HEAD(g_B), bdot_index = RING_HEAD(g_Bt), omega_index = RING_HEAD(g_W), sol_index = RING_HEAD(g_S);
         // VECTOR_ASSIGN(B, g_datavis_st.data., g_B[mag_index]);
         {
             g_datavis_st.data.x_B = x_g_B[mag_index];
@@ -123,29 +259,59 @@ int main(int argc, char *argv[])
             g_datavis_st.data.y_W = y_g_W[omega_index];
             g_datavis_st.data.z_W = z_g_W[omega_index];
         }
-        // VECTOR_ASSIGN(S, g_datavis_st.data., g_S[mag_index]);
+        // VECTOR_ASSIGN(S, g_datavis_st.data., g_S[sol_index]);
+        {
+            g_datavis_st.data.x_S = x_g_S[sol_index];
+            g_datavis_st.data.y_S = y_g_S[sol_index];
+            g_datavis_st.data.z_S = z_g_S[sol_index];
+        }
         {
-            g_datavis_st.data.x_S = x_g_S[mag_index];
-            g_datavis_st.data.y_S = y_g_S[mag_index];
-            g_datavis_st.data.z_S = z_g_S[mag_index];
+            loopmon_stats_t stats;
+            loopmon_stats(&g_loopmon, &stats);
+            g_datavis_st.data.loop_min = stats.min;
+            g_datavis_st.data.loop_mean = stats.mean;
+            g_datavis_st.data.loop_p99 = stats.p99;
+            g_datavis_st.data.loop_max = stats.max;
+            g_datavis_st.data.loop_exec = g_t_acs - g_loopmon.t_start; // time taken by ACS step
+            g_datavis_st.data.loop_overruns = g_loopmon.overruns;
+            g_datavis_st.data.loop_jitter_rms = stats.jitter_rms;
+            g_datavis_st.data.loop_jitter_max = stats.jitter_max;
         }
         char buf[PACK_SIZE + sizeof(char)];
+        int num_clients = datavis_accept(server_fd, clients, max_clients);
+        g_datavis_st.data.tpub = get_usec(); // publication time, for end-to-end latency
         memcpy(buf + sizeof(char), g_datavis_st.buf, PACK_SIZE);
-        *(char *)buf = PACK_SIZE;
-        ssize_t sz = send(new_socket, buf, sizeof(buf), MSG_NOSIGNAL);
-        if (sz < 0 && !done)
+        *(uint8_t *)buf = PACK_SIZE;
+        for (int i = 0; i < max_clients && num_clients > 0; i++)
         {
-            if ((new_socket = accept(server_fd, (struct sockaddr *)&address,
-                                     (socklen_t *)&addrlen)) < 0)
+            if (clients[i] < 0)
+                continue;
+            num_clients--;
+            ssize_t sz = send(clients[i], buf, sizeof(buf), MSG_NOSIGNAL);
+            if (sz < (ssize_t)sizeof(buf) && !done) // client went away or is not keeping up (EAGAIN, short write), free the slot
             {
 #ifdef SERVER_DEBUG
-                perror("accept");
+                perror("send");
 #endif
+                close(clients[i]);
+                clients[i] = -1;
             }
         }
-        usleep(1000000 / 10); // 10 Hz, 100 ms
+        uint32_t sleep_time = loopmon_end(&g_loopmon, get_usec()); // sleep until the next period, not for a whole period
+        if (sleep_time > 0)
+            usleep(sleep_time); // 10 Hz, 100 ms by default
     }
-    close(new_socket);
+    for (int i = 0; i < DATAVIS_MAX_CLIENTS; i++)
+        if (clients[i] >= 0)
+            close(clients[i]);
     close(server_fd);
+    printFilters(stdout);
+    printWindowStats(stdout);
+#ifdef ACS_FIXEDPOINT
+    printFixedPoint(stdout);
+#endif
+    if (checkpoint_file != NULL && saveCheckpoint(checkpoint_file) < 0)
+        return 1;
+    fault_free(&faults);
     return 0;
 }
\ No newline at end of file
@@ -17,6 +17,12 @@
  */ 
 #define PORT 12376
 #endif
+#ifndef DATAVIS_MAX_CLIENTS
+/**
+ * @brief Maximum number of simultaneous DataVis connections.
+ */
+#define DATAVIS_MAX_CLIENTS 64
+#endif
 #include <stdint.h>
 #include <macros.h>
 /**
@@ -70,6 +76,51 @@ typedef struct
      * 
      */
     DECLARE_VECTOR2(S, float); // Sun vector
+    /**
+     * @brief Minimum ACS loop period over the monitor window (usec)
+     *
+     */
+    uint32_t loop_min; // Loop period min
+    /**
+     * @brief Mean ACS loop period over the monitor window (usec)
+     *
+     */
+    uint32_t loop_mean; // Loop period mean
+    /**
+     * @brief 99th percentile ACS loop period over the monitor window (usec)
+     *
+     */
+    uint32_t loop_p99; // Loop period p99
+    /**
+     * @brief Maximum ACS loop period over the monitor window (usec)
+     *
+     */
+    uint32_t loop_max; // Loop period max
+    /**
+     * @brief Execution time of the last ACS loop iteration (usec)
+     *
+     */
+    uint32_t loop_exec; // Loop execution time
+    /**
+     * @brief Number of ACS loop iterations that ran past their deadline
+     *
+     */
+    uint32_t loop_overruns; // Loop overrun count
+    /**
+     * @brief RMS distance of the ACS loop start from its deadline over the monitor window (usec)
+     *
+     */
+    uint32_t loop_jitter_rms; // Loop start jitter RMS
+    /**
+     * @brief Maximum distance of the ACS loop start from its deadline over the monitor window (usec)
+     *
+     */
+    uint32_t loop_jitter_max; // Loop start jitter max
+    /**
+     * @brief Time at which this packet was published to the clients, from UTC (usec)
+     *
+     */
+    uint64_t tpub; // Time published
     char end[4];
 } datavis_p;
 /**
@@ -0,0 +1,245 @@
+/**
+ * @file dynamics.c
+ * @brief Rigid-body attitude dynamics propagator (Euler's equations and quaternion kinematics).
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <dynamics.h>
+#include <macros.h>
+#include <math.h>
+
+/**
+ * @brief Length of the state vector, quaternion followed by angular velocity.
+ *
+ */
+#define DYN_N 7
+
+void dynamics_init(dyn_params_t *p, float MOI[3][3], float IMOI[3][3])
+{
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+        {
+            p->MOI[i][j] = MOI[i][j];
+            p->IMOI[i][j] = IMOI[i][j];
+        }
+    p->atol = 1e-9;
+    p->rtol = 1e-7;
+    p->h_min = 1e-6;
+}
+
+/**
+ * @brief Rotates an inertial frame vector into the body frame of the (unit) quaternion q.
+ * Uses \f$u = -q_v\f$, \f$t = 2 u \times v\f$, \f$v_B = v + q_0 t + u \times t\f$.
+ *
+ * @param q Attitude quaternion (w, x, y, z), body to inertial
+ * @param vi Vector in the inertial frame
+ * @param bx X component of the vector in the body frame
+ * @param by Y component of the vector in the body frame
+ * @param bz Z component of the vector in the body frame
+ */
+static inline void rotate_to_body(const double q[4], const double vi[3], double *bx, double *by, double *bz)
+{
+    double ux = -q[1], uy = -q[2], uz = -q[3];
+    double tx = 2 * (uy * vi[2] - uz * vi[1]);
+    double ty = 2 * (uz * vi[0] - ux * vi[2]);
+    double tz = 2 * (ux * vi[1] - uy * vi[0]);
+    *bx = vi[0] + q[0] * tx + (uy * tz - uz * ty);
+    *by = vi[1] + q[0] * ty + (uz * tx - ux * tz);
+    *bz = vi[2] + q[0] * tz + (ux * ty - uy * tx);
+}
+
+/**
+ * @brief Calculates the time derivative of the state vector.
+ * \f$\dot{q} = \frac{1}{2} q \otimes (0, \vec{\omega})\f$,
+ * \f$\dot{\vec{\omega}} = I^{-1}(\vec{\tau} + \vec{m} \times \vec{B} - \vec{\omega} \times I\vec{\omega})\f$.
+ *
+ * @param y State vector
+ * @param p Parameters
+ * @param u Inputs
+ * @param dy Derivative of the state vector
+ */
+static inline void derivative(const double y[DYN_N], const dyn_params_t *p, const dyn_input_t *u, double dy[DYN_N])
+{
+    const double *q = y;
+    DECLARE_VECTOR(w, double);
+    x_w = y[4];
+    y_w = y[5];
+    z_w = y[6];
+    dy[0] = 0.5 * (-q[1] * x_w - q[2] * y_w - q[3] * z_w);
+    dy[1] = 0.5 * (q[0] * x_w + q[2] * z_w - q[3] * y_w);
+    dy[2] = 0.5 * (q[0] * y_w + q[3] * x_w - q[1] * z_w);
+    dy[3] = 0.5 * (q[0] * z_w + q[1] * y_w - q[2] * x_w);
+    DECLARE_VECTOR(L, double);
+    MATVECMUL(L, p->MOI, w); // angular momentum
+    DECLARE_VECTOR(wxL, double);
+    CROSS_PRODUCT(wxL, w, L); // gyroscopic torque
+    DECLARE_VECTOR(B, double);
+    rotate_to_body(q, u->B_I, &x_B, &y_B, &z_B); // field in the current body frame
+    DECLARE_VECTOR(m, double);
+    x_m = u->dipole[0];
+    y_m = u->dipole[1];
+    z_m = u->dipole[2];
+    DECLARE_VECTOR(mxB, double);
+    CROSS_PRODUCT(mxB, m, B); // magnetic torque
+    DECLARE_VECTOR(h, double);
+    x_h = u->torque[0] + x_mxB - x_wxL;
+    y_h = u->torque[1] + y_mxB - y_wxL;
+    z_h = u->torque[2] + z_mxB - z_wxL;
+    DECLARE_VECTOR(dw, double);
+    MATVECMUL(dw, p->IMOI, h);
+    dy[4] = x_dw;
+    dy[5] = y_dw;
+    dy[6] = z_dw;
+}
+
+/**
+ * @brief Renormalizes the quaternion part of the state vector to counter integration drift.
+ *
+ * @param y State vector
+ */
+static inline void normalize_q(double y[DYN_N])
+{
+    double n = 1.0 / sqrt(y[0] * y[0] + y[1] * y[1] + y[2] * y[2] + y[3] * y[3]);
+    for (int i = 0; i < 4; i++)
+        y[i] *= n;
+}
+
+static inline void load(const dyn_state_t *s, double y[DYN_N])
+{
+    for (int i = 0; i < 4; i++)
+        y[i] = s->q[i];
+    for (int i = 0; i < 3; i++)
+        y[4 + i] = s->w[i];
+}
+
+static inline void store(dyn_state_t *s, const double y[DYN_N])
+{
+    for (int i = 0; i < 4; i++)
+        s->q[i] = y[i];
+    for (int i = 0; i < 3; i++)
+        s->w[i] = y[4 + i];
+}
+
+void dynamics_rk4(dyn_state_t *s, const dyn_params_t *p, const dyn_input_t *u, double dt)
+{
+    double y[DYN_N], yt[DYN_N], k1[DYN_N], k2[DYN_N], k3[DYN_N], k4[DYN_N];
+    load(s, y);
+    derivative(y, p, u, k1);
+    for (int i = 0; i < DYN_N; i++)
+        yt[i] = y[i] + 0.5 * dt * k1[i];
+    derivative(yt, p, u, k2);
+    for (int i = 0; i < DYN_N; i++)
+        yt[i] = y[i] + 0.5 * dt * k2[i];
+    derivative(yt, p, u, k3);
+    for (int i = 0; i < DYN_N; i++)
+        yt[i] = y[i] + dt * k3[i];
+    derivative(yt, p, u, k4);
+    for (int i = 0; i < DYN_N; i++)
+        y[i] += dt / 6.0 * (k1[i] + 2 * k2[i] + 2 * k3[i] + k4[i]);
+    normalize_q(y);
+    store(s, y);
+}
+
+// Dormand-Prince 5(4) tableau
+static const double a21 = 1.0 / 5;
+static const double a31 = 3.0 / 40, a32 = 9.0 / 40;
+static const double a41 = 44.0 / 45, a42 = -56.0 / 15, a43 = 32.0 / 9;
+static const double a51 = 19372.0 / 6561, a52 = -25360.0 / 2187, a53 = 64448.0 / 6561, a54 = -212.0 / 729;
+static const double a61 = 9017.0 / 3168, a62 = -355.0 / 33, a63 = 46732.0 / 5247, a64 = 49.0 / 176, a65 = -5103.0 / 18656;
+static const double b1 = 35.0 / 384, b3 = 500.0 / 1113, b4 = 125.0 / 192, b5 = -2187.0 / 6784, b6 = 11.0 / 84;
+// difference between the 5th and the embedded 4th order solutions
+static const double e1 = 71.0 / 57600, e3 = -71.0 / 16695, e4 = 71.0 / 1920, e5 = -17253.0 / 339200, e6 = 22.0 / 525, e7 = -1.0 / 40;
+
+int dynamics_rk45(dyn_state_t *s, const dyn_params_t *p, const dyn_input_t *u, double dt)
+{
+    double y[DYN_N], yt[DYN_N], yn[DYN_N];
+    double k1[DYN_N], k2[DYN_N], k3[DYN_N], k4[DYN_N], k5[DYN_N], k6[DYN_N], k7[DYN_N];
+    load(s, y);
+    double h = s->h > 0 ? s->h : dt / DYNAMICS_SUBSTEPS;
+    double t = 0;
+    int steps = 0;
+    derivative(y, p, u, k1);
+    while (t < dt)
+    {
+        int last = 0;
+        if (t + h >= dt) // do not step past the end
+        {
+            h = dt - t;
+            last = 1;
+        }
+        for (int i = 0; i < DYN_N; i++)
+            yt[i] = y[i] + h * a21 * k1[i];
+        derivative(yt, p, u, k2);
+        for (int i = 0; i < DYN_N; i++)
+            yt[i] = y[i] + h * (a31 * k1[i] + a32 * k2[i]);
+        derivative(yt, p, u, k3);
+        for (int i = 0; i < DYN_N; i++)
+            yt[i] = y[i] + h * (a41 * k1[i] + a42 * k2[i] + a43 * k3[i]);
+        derivative(yt, p, u, k4);
+        for (int i = 0; i < DYN_N; i++)
+            yt[i] = y[i] + h * (a51 * k1[i] + a52 * k2[i] + a53 * k3[i] + a54 * k4[i]);
+        derivative(yt, p, u, k5);
+        for (int i = 0; i < DYN_N; i++)
+            yt[i] = y[i] + h * (a61 * k1[i] + a62 * k2[i] + a63 * k3[i] + a64 * k4[i] + a65 * k5[i]);
+        derivative(yt, p, u, k6);
+        for (int i = 0; i < DYN_N; i++)
+            yn[i] = y[i] + h * (b1 * k1[i] + b3 * k3[i] + b4 * k4[i] + b5 * k5[i] + b6 * k6[i]);
+        derivative(yn, p, u, k7);
+        // RMS of the scaled error estimate
+        double err = 0;
+        for (int i = 0; i < DYN_N; i++)
+        {
+            double ei = h * (e1 * k1[i] + e3 * k3[i] + e4 * k4[i] + e5 * k5[i] + e6 * k6[i] + e7 * k7[i]);
+            double sc = p->atol + p->rtol * fmax(fabs(y[i]), fabs(yn[i]));
+            err += (ei / sc) * (ei / sc);
+        }
+        err = sqrt(err / DYN_N);
+        if (!isfinite(err)) // no step size helps, the state or the inputs are not finite
+        {
+            store(s, y);
+            return -1;
+        }
+        double fac = err > 0 ? 0.9 * pow(err, -0.2) : 5;
+        fac = fac < 0.2 ? 0.2 : (fac > 5 ? 5 : fac);
+        if (err <= 1 || h <= p->h_min) // accept
+        {
+            t = last ? dt : t + h;
+            for (int i = 0; i < DYN_N; i++)
+                y[i] = yn[i];
+            normalize_q(y);
+            derivative(y, p, u, k1); // first same as last, up to the renormalization
+            steps++;
+            if (!last) // the clipped last step is not a good guess for the next call
+                s->h = h * fac;
+            h = s->h;
+        }
+        else // reject, retry with a smaller step
+        {
+            h = h * fac;
+            h = h < p->h_min ? p->h_min : h;
+        }
+    }
+    store(s, y);
+    return steps;
+}
+
+void dynamics_propagate(dyn_state_t *s, const dyn_params_t *p, const dyn_input_t *u, double dt, int nsub, dyn_integrator integrator)
+{
+    if (integrator == DYN_RK45)
+    {
+        dynamics_rk45(s, p, u, dt);
+        return;
+    }
+    nsub = nsub < 1 ? 1 : nsub;
+    double h = dt / nsub;
+    for (int i = 0; i < nsub; i++)
+        dynamics_rk4(s, p, u, h);
+}
+
+void dynamics_to_body(const dyn_state_t *s, const double vi[3], double vb[3])
+{
+    rotate_to_body(s->q, vi, &vb[0], &vb[1], &vb[2]);
+}
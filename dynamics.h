@@ -0,0 +1,168 @@
+/**
+ * @file dynamics.h
+ * @brief Rigid-body attitude dynamics propagator (Euler's equations and quaternion kinematics).
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __DYNAMICS_H
+#define __DYNAMICS_H
+
+#include <stdint.h>
+
+#ifndef DYNAMICS_SUBSTEPS
+/**
+ * @brief Default number of integrator steps per ACS loop period.
+ *
+ */
+#define DYNAMICS_SUBSTEPS 10
+#endif
+
+/**
+ * @brief Attitude state of the satellite.
+ * The quaternion is stored scalar first and rotates body frame vectors into the inertial frame,
+ * \f$v_I = q \otimes v_B \otimes q^*\f$.
+ *
+ */
+typedef struct
+{
+    /**
+     * @brief Attitude quaternion (w, x, y, z), body to inertial
+     *
+     */
+    double q[4];
+    /**
+     * @brief Angular velocity in the body frame (rad s^-1)
+     *
+     */
+    double w[3];
+    /**
+     * @brief Step size carried over between calls by the adaptive integrator (s), 0 == pick one
+     *
+     */
+    double h;
+} dyn_state_t;
+
+/**
+ * @brief Constant parameters of the rigid body and the integrator.
+ *
+ */
+typedef struct
+{
+    /**
+     * @brief Moment of inertia (SI)
+     *
+     */
+    double MOI[3][3];
+    /**
+     * @brief Inverse of the moment of inertia (SI)
+     *
+     */
+    double IMOI[3][3];
+    /**
+     * @brief Absolute error tolerance of the adaptive integrator
+     *
+     */
+    double atol;
+    /**
+     * @brief Relative error tolerance of the adaptive integrator
+     *
+     */
+    double rtol;
+    /**
+     * @brief Smallest step the adaptive integrator is allowed to take (s)
+     *
+     */
+    double h_min;
+} dyn_params_t;
+
+/**
+ * @brief Inputs held constant over a propagation interval.
+ * The magnetic torque \f$\vec{m} \times \vec{B}\f$ is re-evaluated along the way with the field rotated into the current body frame.
+ *
+ */
+typedef struct
+{
+    /**
+     * @brief External torque in the body frame (N m)
+     *
+     */
+    double torque[3];
+    /**
+     * @brief Magnetic dipole moment of the satellite in the body frame (A m^2)
+     *
+     */
+    double dipole[3];
+    /**
+     * @brief Magnetic field in the inertial frame (T)
+     *
+     */
+    double B_I[3];
+} dyn_input_t;
+
+/**
+ * @brief Integrator used by dynamics_propagate().
+ *
+ */
+typedef enum
+{
+    DYN_RK4 = 0,  // fixed step, 4th order Runge-Kutta
+    DYN_RK45 = 1, // adaptive step, Dormand-Prince 5(4)
+} dyn_integrator;
+
+/**
+ * @brief Initializes the dynamics parameters from the single precision MOI and IMOI matrices.
+ *
+ * @param p Parameters to initialize
+ * @param MOI Moment of inertia (SI)
+ * @param IMOI Inverse of the moment of inertia (SI)
+ */
+void dynamics_init(dyn_params_t *p, float MOI[3][3], float IMOI[3][3]);
+
+/**
+ * @brief Advances the state by one fixed 4th order Runge-Kutta step. The inputs are held constant over the step.
+ *
+ * @param s State, updated in place
+ * @param p Parameters
+ * @param u Inputs
+ * @param dt Step size (s)
+ */
+void dynamics_rk4(dyn_state_t *s, const dyn_params_t *p, const dyn_input_t *u, double dt);
+
+/**
+ * @brief Advances the state by dt using adaptive Dormand-Prince 5(4) steps. The inputs are held constant over dt.
+ * The last accepted step size is stored in the state and used as the first guess in the next call.
+ *
+ * @param s State, updated in place
+ * @param p Parameters
+ * @param u Inputs
+ * @param dt Time to advance (s)
+ * @return int Number of accepted steps taken, -1 if the error estimate is not finite (the state is left at the
+ * last accepted step)
+ */
+int dynamics_rk45(dyn_state_t *s, const dyn_params_t *p, const dyn_input_t *u, double dt);
+
+/**
+ * @brief Advances the state by dt with the selected integrator. The fixed step integrator takes nsub steps.
+ *
+ * @param s State, updated in place
+ * @param p Parameters
+ * @param u Inputs
+ * @param dt Time to advance (s)
+ * @param nsub Number of fixed steps (ignored by the adaptive integrator)
+ * @param integrator DYN_RK4 or DYN_RK45
+ */
+void dynamics_propagate(dyn_state_t *s, const dyn_params_t *p, const dyn_input_t *u, double dt, int nsub, dyn_integrator integrator);
+
+/**
+ * @brief Rotates an inertial frame vector into the body frame, \f$v_B = q^* \otimes v_I \otimes q\f$.
+ *
+ * @param s State
+ * @param vi Vector in the inertial frame
+ * @param vb Vector in the body frame, must be different from vi
+ */
+void dynamics_to_body(const dyn_state_t *s, const double vi[3], double vb[3]);
+
+#endif // __DYNAMICS_H
@@ -0,0 +1,225 @@
+/**
+ * @file fault.c
+ * @brief Sensor fault injector. Time-triggered and probabilistic faults are compiled ahead of the run
+ * into a per-step event list, so a step without events costs one comparison.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <fault.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/**
+ * @brief Script names of the fault types, in fault_type order.
+ *
+ */
+static const char *fault_names[FAULT_NUM_TYPES] = {"css_stuck", "css_noise", "css_dead", "css_nan", "mag_freeze", "mag_nan", "fss_dead", "mux_err"};
+
+void fault_init(fault_plan_t *p)
+{
+    memset(p, 0, sizeof(fault_plan_t));
+}
+
+int fault_add(fault_plan_t *p, const fault_spec_t *f)
+{
+    if (p->nspec >= FAULT_MAX_SPECS || f->type < 0 || f->type >= FAULT_NUM_TYPES)
+        return -1;
+    if (f->type <= FAULT_CSS_NAN && (f->channel < 0 || f->channel >= FAULT_CSS_CHANNELS))
+        return -1;
+    if (f->type == FAULT_MUX_ERR && (f->channel < 0 || f->channel >= FAULT_MUX_CHANNELS))
+        return -1;
+    p->spec[p->nspec] = *f;
+    return p->nspec++;
+}
+
+int fault_load(fault_plan_t *p, const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        perror("[FAULT] fopen");
+        return -1;
+    }
+    char line[256];
+    int n = 0, lineno = 0;
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        lineno++;
+        char name[32];
+        fault_spec_t f = {0};
+        int nread = sscanf(line, "%31s %d %lf %lf %f %lf", name, &f.channel, &f.t_start, &f.duration, &f.value, &f.rate);
+        if (nread <= 0 || name[0] == '#')
+            continue;
+        f.type = FAULT_NUM_TYPES;
+        for (int i = 0; i < FAULT_NUM_TYPES; i++)
+            if (strcmp(name, fault_names[i]) == 0)
+                f.type = i;
+        if (nread < 4 || fault_add(p, &f) < 0)
+        {
+            fprintf(stderr, "[FAULT] %s:%d: invalid fault\n", path, lineno);
+            fclose(fp);
+            return -1;
+        }
+        n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+/**
+ * @brief Appends an event to the list, growing it as needed.
+ *
+ * @return int 1 on success, -1 on allocation failure
+ */
+static int fault_push(fault_plan_t *p, uint64_t step, int spec, int on)
+{
+    if (p->nev == p->cap)
+    {
+        int cap = p->cap > 0 ? 2 * p->cap : 64;
+        fault_event_t *ev = (fault_event_t *)realloc(p->ev, cap * sizeof(fault_event_t));
+        if (ev == NULL)
+        {
+            perror("[FAULT] Event list alloc failed");
+            return -1;
+        }
+        p->ev = ev;
+        p->cap = cap;
+    }
+    p->ev[p->nev++] = (fault_event_t){.step = step, .spec = spec, .on = on};
+    return 1;
+}
+
+/**
+ * @brief Orders events by step, turning faults off before turning them on within a step.
+ *
+ */
+static int fault_cmp(const void *a, const void *b)
+{
+    const fault_event_t *x = (const fault_event_t *)a, *y = (const fault_event_t *)b;
+    if (x->step != y->step)
+        return x->step < y->step ? -1 : 1;
+    if (x->on != y->on)
+        return x->on - y->on;
+    return x->spec - y->spec;
+}
+
+/**
+ * @brief xorshift64* generator for the onsets, kept apart from the sensor noise.
+ *
+ * @param s Generator state, nonzero
+ * @return double Uniform deviate in (0, 1]
+ */
+static inline double fault_uniform(uint64_t *s)
+{
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return ((*s * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0) + (1.0 / 9007199254740992.0);
+}
+
+int fault_compile(fault_plan_t *p, uint64_t steps, double dt, uint64_t seed)
+{
+    p->nev = 0;
+    uint64_t rng = seed * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL;
+    rng = rng ? rng : 1;
+    for (int i = 0; i < p->nspec; i++)
+    {
+        const fault_spec_t *f = &p->spec[i];
+        uint64_t len = f->duration > 0 ? (uint64_t)ceil(f->duration / dt) : 0;
+        double t = f->t_start > 0 ? f->t_start : 0;
+        if (f->rate > 0) // first onset after an exponentially distributed wait
+            t -= log(fault_uniform(&rng)) * 3600.0 / f->rate;
+        while (t < steps * dt)
+        {
+            uint64_t on = (uint64_t)ceil(t / dt);
+            if (fault_push(p, on, i, 1) < 0)
+                return -1;
+            if (len == 0) // permanent
+                break;
+            if (on + len <= steps && fault_push(p, on + len, i, 0) < 0)
+                return -1;
+            if (f->rate <= 0)
+                break;
+            t -= log(fault_uniform(&rng)) * 3600.0 / f->rate;
+        }
+    }
+    qsort(p->ev, p->nev, sizeof(fault_event_t), fault_cmp);
+    fault_rewind(p);
+    return p->nev;
+}
+
+void fault_rewind(fault_plan_t *p)
+{
+    p->next = 0;
+    memset(p->depth, 0, sizeof(p->depth));
+    memset(&p->state, 0, sizeof(fault_state_t));
+}
+
+void fault_apply_events(fault_plan_t *p, uint64_t step)
+{
+    for (; p->next < p->nev && p->ev[p->next].step <= step; p->next++)
+    {
+        const fault_event_t *e = &p->ev[p->next];
+        if (e->on)
+            p->depth[e->spec]++;
+        else if (p->depth[e->spec] > 0)
+            p->depth[e->spec]--;
+    }
+    // rebuild the effective state from the active faults
+    fault_state_t *st = &p->state;
+    memset(st, 0, sizeof(fault_state_t));
+    for (int i = 0; i < p->nspec; i++)
+    {
+        if (p->depth[i] == 0)
+            continue;
+        const fault_spec_t *f = &p->spec[i];
+        st->any = 1;
+        switch (f->type)
+        {
+        case FAULT_CSS_STUCK:
+            st->css_stuck[f->channel] = 1;
+            st->css_value[f->channel] = f->value;
+            break;
+        case FAULT_CSS_NOISE:
+            st->css_noise[f->channel] += f->value;
+            break;
+        case FAULT_CSS_DEAD:
+            st->css_dead[f->channel] = 1;
+            break;
+        case FAULT_CSS_NAN:
+            st->css_nan[f->channel] = 1;
+            break;
+        case FAULT_MAG_FREEZE:
+            st->mag_freeze = 1;
+            break;
+        case FAULT_MAG_NAN:
+            st->mag_nan = 1;
+            break;
+        case FAULT_FSS_DEAD:
+            st->fss_dead = 1;
+            break;
+        case FAULT_MUX_ERR:
+            st->mux_err[f->channel] = 1;
+            for (int j = 0; j < FAULT_CSS_CHANNELS; j++)
+                if (FAULT_MUX_OF_CSS[j] == f->channel)
+                    st->css_dead[j] = 1;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void fault_free(fault_plan_t *p)
+{
+    free(p->ev);
+    p->ev = NULL;
+    p->nev = 0;
+    p->cap = 0;
+    p->next = 0;
+}
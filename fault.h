@@ -0,0 +1,195 @@
+/**
+ * @file fault.h
+ * @brief Sensor fault injector. Time-triggered and probabilistic faults are compiled ahead of the run
+ * into a per-step event list, so a step without events costs one comparison.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __FAULT_H
+#define __FAULT_H
+
+#include <stdint.h>
+
+#ifndef FAULT_MAX_SPECS
+/**
+ * @brief Maximum number of faults in a plan.
+ *
+ */
+#define FAULT_MAX_SPECS 64
+#endif
+
+/**
+ * @brief Number of coarse sun sensor channels.
+ *
+ */
+#define FAULT_CSS_CHANNELS 7
+/**
+ * @brief Number of I2C mux channels the coarse sun sensors are connected through.
+ *
+ */
+#define FAULT_MUX_CHANNELS 3
+
+/**
+ * @brief Fault types.
+ *
+ */
+typedef enum
+{
+    FAULT_CSS_STUCK = 0, // CSS channel reads a constant value
+    FAULT_CSS_NOISE,     // CSS channel gets extra uniform noise of the given peak to peak amplitude
+    FAULT_CSS_DEAD,      // CSS channel reads 0
+    FAULT_CSS_NAN,       // CSS channel reads NaN
+    FAULT_MAG_FREEZE,    // magnetometer repeats its last reading
+    FAULT_MAG_NAN,       // magnetometer reads NaN
+    FAULT_FSS_DEAD,      // fine sun sensor reports no sun
+    FAULT_MUX_ERR,       // mux channel error, the CSS channels behind it read 0
+    FAULT_NUM_TYPES
+} fault_type;
+
+/**
+ * @brief Description of one fault. A time-triggered fault (rate 0) is active from t_start for duration
+ * seconds; a probabilistic fault occurs at random (Poisson, rate per hour) from t_start on, and lasts
+ * duration seconds each time. A duration of 0 or less makes the fault permanent.
+ *
+ */
+typedef struct
+{
+    fault_type type;
+    int channel;     // CSS channel (0...6) or mux channel (0...2), unused by the other types
+    float value;     // stuck value or noise amplitude (lux)
+    double t_start;  // onset, or start of the onset window (s)
+    double duration; // duration of each occurrence (s)
+    double rate;     // occurrences per hour, 0 for time-triggered faults
+} fault_spec_t;
+
+/**
+ * @brief Compiled fault event: the fault spec switches on or off at the given step.
+ *
+ */
+typedef struct
+{
+    uint64_t step;
+    uint16_t spec;
+    uint16_t on;
+} fault_event_t;
+
+/**
+ * @brief Effective fault state of the sensors, rebuilt whenever an event fires.
+ *
+ */
+typedef struct
+{
+    int any;                                  // any fault active
+    uint8_t css_stuck[FAULT_CSS_CHANNELS];    // stuck CSS channels
+    float css_value[FAULT_CSS_CHANNELS];      // values of the stuck channels (lux)
+    float css_noise[FAULT_CSS_CHANNELS];      // extra noise amplitudes (lux), 0 for none
+    uint8_t css_dead[FAULT_CSS_CHANNELS];     // dead CSS channels, including those behind a mux error
+    uint8_t css_nan[FAULT_CSS_CHANNELS];      // CSS channels reading NaN
+    uint8_t mag_freeze;                       // magnetometer frozen
+    uint8_t mag_nan;                          // magnetometer reading NaN
+    uint8_t fss_dead;                         // fine sun sensor dead
+    uint8_t mux_err[FAULT_MUX_CHANNELS];      // mux channel errors
+} fault_state_t;
+
+/**
+ * @brief Fault plan: the fault specs, the compiled event list, and the replay position and state.
+ *
+ */
+typedef struct
+{
+    fault_spec_t spec[FAULT_MAX_SPECS];
+    int nspec;
+    fault_event_t *ev; // events sorted by step
+    int nev;
+    int cap;
+    int next;                         // next event to apply
+    uint16_t depth[FAULT_MAX_SPECS];  // number of occurrences of each spec currently active
+    fault_state_t state;
+} fault_plan_t;
+
+/**
+ * @brief CSS channels connected through each mux channel: ch0 CSS 0-2, ch1 CSS 3-5, ch2 CSS 6.
+ *
+ */
+static const int8_t FAULT_MUX_OF_CSS[FAULT_CSS_CHANNELS] = {0, 0, 0, 1, 1, 1, 2};
+
+/**
+ * @brief Initializes an empty fault plan.
+ *
+ * @param p Fault plan
+ */
+void fault_init(fault_plan_t *p);
+
+/**
+ * @brief Adds a fault to the plan. The plan must be recompiled afterwards.
+ *
+ * @param p Fault plan
+ * @param f Fault
+ * @return int Index of the fault, -1 if the plan is full or the fault is invalid
+ */
+int fault_add(fault_plan_t *p, const fault_spec_t *f);
+
+/**
+ * @brief Reads faults from a script, one per line: type channel t_start duration [value [rate]].
+ * Types are css_stuck, css_noise, css_dead, css_nan, mag_freeze, mag_nan, fss_dead and mux_err.
+ * Lines starting with '#' are ignored.
+ *
+ * @param p Fault plan
+ * @param path Fault script
+ * @return int Number of faults read, -1 on error
+ */
+int fault_load(fault_plan_t *p, const char *path);
+
+/**
+ * @brief Compiles the plan into the event list for a run, drawing the onsets of the probabilistic faults
+ * from the seed, and rewinds the plan. The same seed always gives the same events.
+ *
+ * @param p Fault plan
+ * @param steps Length of the run (steps)
+ * @param dt Step length (s)
+ * @param seed Seed of the probabilistic faults
+ * @return int Number of events, -1 on allocation failure
+ */
+int fault_compile(fault_plan_t *p, uint64_t steps, double dt, uint64_t seed);
+
+/**
+ * @brief Rewinds the compiled plan to step 0 and clears the fault state, to replay the same events.
+ *
+ * @param p Fault plan
+ */
+void fault_rewind(fault_plan_t *p);
+
+/**
+ * @brief Applies all events up to the given step. Use fault_step().
+ *
+ * @param p Fault plan
+ * @param step Current step
+ */
+void fault_apply_events(fault_plan_t *p, uint64_t step);
+
+/**
+ * @brief Advances the plan to the given step.
+ *
+ * @param p Fault plan
+ * @param step Current step
+ * @return int 1 if the fault state changed at this step, 0 otherwise
+ */
+static inline int fault_step(fault_plan_t *p, uint64_t step)
+{
+    if (p->next >= p->nev || p->ev[p->next].step > step)
+        return 0;
+    fault_apply_events(p, step);
+    return 1;
+}
+
+/**
+ * @brief Frees the compiled event list.
+ *
+ * @param p Fault plan
+ */
+void fault_free(fault_plan_t *p);
+
+#endif // __FAULT_H
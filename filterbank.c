@@ -0,0 +1,353 @@
+/**
+ * @file filterbank.c
+ * @brief Runtime-selectable filters for the vector signals of the ACS.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <filterbank.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <config.h>
+
+static const char *filter_names[FILTER_TYPE_COUNT] = {
+    "none",
+    "bessel",
+    "butterworth",
+    "moving_average",
+    "alpha_beta",
+};
+
+const char *filter_type_name(filter_type type)
+{
+    return type >= 0 && type < FILTER_TYPE_COUNT ? filter_names[type] : "unknown";
+}
+
+/**
+ * @brief Designs the Butterworth sections by the bilinear transform, with the cut-off prewarped.
+ * The sections have unit gain at DC.
+ *
+ */
+static void butterworth_design(filter_t *f)
+{
+    int n = f->cfg.order;
+    double k = tan(M_PI / f->cfg.cutoff); // prewarped cut-off, the cut-off frequency is 1 / cutoff cycles per sample
+    f->sections = (n + 1) / 2;
+    for (int s = 0; s < n / 2; s++)
+    {
+        double zeta = sin(M_PI * (2 * s + 1) / (2.0 * n)); // damping of the pole pair, H(s) = 1 / (s^2 + 2 zeta s + 1)
+        double norm = 1 / (1 + 2 * zeta * k + k * k);
+        f->sos[s][0] = k * k * norm;
+        f->sos[s][1] = 2 * f->sos[s][0];
+        f->sos[s][2] = f->sos[s][0];
+        f->sos[s][3] = 2 * (k * k - 1) * norm;
+        f->sos[s][4] = (1 - 2 * zeta * k + k * k) * norm;
+    }
+    if (n % 2) // real pole, H(s) = 1 / (s + 1)
+    {
+        double norm = 1 / (1 + k);
+        double *sos = f->sos[f->sections - 1];
+        sos[0] = k * norm;
+        sos[1] = sos[0];
+        sos[2] = 0;
+        sos[3] = (k - 1) * norm;
+        sos[4] = 0;
+    }
+}
+
+/**
+ * @brief Caps the moving average window at the capacity of the history, if there is one.
+ *
+ */
+static void filter_fit_window(filter_t *f)
+{
+    if (f->cfg.type == FILTER_MOVING_AVERAGE && f->hist_size > 0 && f->cfg.order > f->hist_size)
+    {
+        fprintf(stderr, "[FILTER] Moving average window %d capped at %d\n", f->cfg.order, f->hist_size);
+        f->cfg.order = f->hist_size;
+    }
+}
+
+int filter_init(filter_t *f, const filter_config_t *cfg)
+{
+    double *hist[3] = {f->hist[0], f->hist[1], f->hist[2]};
+    int hist_size = f->hist_size;
+    memset(f, 0, sizeof(filter_t));
+    memcpy(f->hist, hist, sizeof(hist));
+    f->hist_size = hist_size;
+    f->cfg = *cfg;
+    switch (cfg->type)
+    {
+    case FILTER_NONE:
+        break;
+    case FILTER_BESSEL:
+        if (cfg->order < 1 || !(cfg->cutoff > 0))
+            goto invalid;
+        calculateBessel(f->coeff, besselSize(), cfg->order, cfg->cutoff); // caps the order, with a warning
+        f->cfg.order = cfg->order > BESSEL_MAX_ORDER ? BESSEL_MAX_ORDER : cfg->order;
+        f->taps = 1;
+        while (f->taps < besselSize() && f->coeff[f->taps] >= BESSEL_MIN_THRESHOLD)
+            f->taps++;
+        f->fixed = f->cfg.order == BESSEL_DEFAULT_ORDER && f->cfg.cutoff == BESSEL_DEFAULT_CUTOFF;
+        break;
+    case FILTER_BUTTERWORTH:
+        if (cfg->order < 1 || !(cfg->cutoff > 2)) // below 2 samples per cycle the cut-off is past Nyquist
+            goto invalid;
+        if (cfg->order > FILTER_MAX_ORDER)
+        {
+            fprintf(stderr, "[FILTER] Butterworth order %d capped at %d\n", cfg->order, FILTER_MAX_ORDER);
+            f->cfg.order = FILTER_MAX_ORDER;
+        }
+        butterworth_design(f);
+        break;
+    case FILTER_MOVING_AVERAGE:
+        if (cfg->order < 1)
+            goto invalid;
+        filter_fit_window(f);
+        break;
+    case FILTER_ALPHA_BETA:
+        if (!(cfg->alpha > 0 && cfg->alpha <= 1 && cfg->beta > 0 && cfg->beta < 4 - 2 * cfg->alpha)) // stable gains
+            goto invalid;
+        break;
+    default:
+        goto invalid;
+    }
+    return 1;
+invalid:
+    fprintf(stderr, "[FILTER] Invalid %s filter: order %d, cut-off %g, alpha %g, beta %g\n", filter_type_name(cfg->type),
+            cfg->order, cfg->cutoff, cfg->alpha, cfg->beta);
+    f->cfg.type = FILTER_NONE;
+    return -1;
+}
+
+int filter_alloc(filter_t *f, arena_t *a, int capacity)
+{
+    for (int i = 0; i < 3; i++)
+        if ((f->hist[i] = arena_alloc(a, capacity * sizeof(double))) == NULL)
+            return -1;
+    f->hist_size = capacity;
+    filter_fit_window(f);
+    filter_reset(f);
+    return 1;
+}
+
+void filter_reset(filter_t *f)
+{
+    memset(&f->st, 0, sizeof(f->st));
+    return;
+}
+
+void filter_save(filter_save_t *s, const filter_t *f)
+{
+    s->st = f->st;
+    for (int i = 0; i < 3 && f->hist_size > 0; i++)
+        memcpy(s->hist[i], f->hist[i], f->hist_size * sizeof(double));
+    return;
+}
+
+void filter_restore(filter_t *f, const filter_save_t *s)
+{
+    f->st = s->st;
+    for (int i = 0; i < 3 && f->hist_size > 0; i++)
+        memcpy(f->hist[i], s->hist[i], f->hist_size * sizeof(double));
+    return;
+}
+
+/**
+ * @brief Filters the input of one axis with the filters that keep their own history.
+ *
+ */
+static double filter_step(filter_t *f, int axis, double in)
+{
+    filter_axis_t *a = &f->st.axis[axis];
+    switch (f->cfg.type)
+    {
+    case FILTER_BUTTERWORTH:
+    {
+        if (a->count == 0) // start at steady state on the first sample, instead of rising from 0
+        {
+            for (int s = 0; s < f->sections; s++)
+            {
+                a->z[2 * s + 1] = (f->sos[s][2] - f->sos[s][4]) * in;
+                a->z[2 * s] = (f->sos[s][1] - f->sos[s][3]) * in + a->z[2 * s + 1];
+            }
+        }
+        for (int s = 0; s < f->sections; s++) // transposed direct form II
+        {
+            const double *c = f->sos[s];
+            double out = c[0] * in + a->z[2 * s];
+            a->z[2 * s] = c[1] * in - c[3] * out + a->z[2 * s + 1];
+            a->z[2 * s + 1] = c[2] * in - c[4] * out;
+            in = out;
+        }
+        f->macs += 5 * f->sections;
+        break;
+    }
+    case FILTER_MOVING_AVERAGE:
+    {
+        if (f->hist_size == 0) // no history to average
+            break;
+        double *hist = f->hist[axis];
+        int window = f->cfg.order;
+        if (a->count >= window)
+            ravg_replace(&a->avg, hist[a->head], in); // oldest input leaves the window
+        else
+            ravg_push(&a->avg, in);
+        hist[a->head] = in;
+        a->head = (a->head + 1) % window;
+        in = ravg_mean(&a->avg);
+        f->macs += 4;
+        break;
+    }
+    case FILTER_ALPHA_BETA:
+    {
+        if (a->count == 0)
+        {
+            a->x = in;
+            a->v = 0;
+            break;
+        }
+        double r = in - (a->x + a->v); // residual of the prediction
+        a->x += a->v + f->cfg.alpha * r;
+        a->v += f->cfg.beta * r;
+        in = a->x;
+        f->macs += 4;
+        break;
+    }
+    default:
+        break;
+    }
+    if (a->count < SH_BUFFER_MAX)
+        a->count++;
+    return in;
+}
+
+double filter_dapply(filter_t *f, int axis, double arr[], int index)
+{
+    f->calls += axis == 0;
+    switch (f->cfg.type)
+    {
+    case FILTER_NONE:
+        return arr[index];
+    case FILTER_BESSEL:
+        f->macs += f->taps < bessel_depth ? f->taps : bessel_depth;
+#ifdef BESSEL_FIXED
+        if (f->fixed) // other orders and cut-offs fall back to their own coefficients
+            return dfilterBesselFixed(arr, index);
+#endif
+        return dfilterBesselCoeff(f->coeff, arr, index);
+    default:
+        return filter_step(f, axis, arr[index]);
+    }
+}
+
+float filter_fapply(filter_t *f, int axis, float arr[], int index)
+{
+    f->calls += axis == 0;
+    switch (f->cfg.type)
+    {
+    case FILTER_NONE:
+        return arr[index];
+    case FILTER_BESSEL:
+        f->macs += f->taps < bessel_depth ? f->taps : bessel_depth;
+#ifdef BESSEL_FIXED
+        if (f->fixed) // other orders and cut-offs fall back to their own coefficients
+            return ffilterBesselFixed(arr, index);
+#endif
+        return ffilterBesselCoeff(f->coeff, arr, index);
+    default:
+        return filter_step(f, axis, arr[index]);
+    }
+}
+
+int filter_parse(filter_config_t *cfg, const char *value)
+{
+    char name[32];
+    int len = 0;
+    if (sscanf(value, "%31s%n", name, &len) != 1)
+        return -1;
+    filter_type type = FILTER_TYPE_COUNT;
+    for (int i = 0; i < FILTER_TYPE_COUNT; i++)
+    {
+        if (strcmp(name, filter_names[i]) == 0)
+            type = i;
+    }
+    double v[2];
+    int n = config_doubles(value + len, v, 2);
+    memset(cfg, 0, sizeof(filter_config_t));
+    cfg->type = type;
+    switch (type)
+    {
+    case FILTER_NONE:
+        return n == 0 ? 1 : -1;
+    case FILTER_BESSEL:
+        if (n != 0 && n != 2)
+            return -1;
+        cfg->order = n ? v[0] : 0; // 0 for acs.bessel_order and acs.bessel_cutoff
+        cfg->cutoff = n ? v[1] : 0;
+        return 1;
+    case FILTER_BUTTERWORTH:
+        if (n != 2)
+            return -1;
+        cfg->order = v[0];
+        cfg->cutoff = v[1];
+        return 1;
+    case FILTER_MOVING_AVERAGE:
+        if (n != 1)
+            return -1;
+        cfg->order = v[0];
+        return 1;
+    case FILTER_ALPHA_BETA:
+        if (n != 2)
+            return -1;
+        cfg->alpha = v[0];
+        cfg->beta = v[1];
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief Cost of the two clock reads around a timed application, the smallest of a few.
+ *
+ */
+static double filter_clock_cost(void)
+{
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 32; i++)
+    {
+        uint64_t t0 = filter_nsec();
+        uint64_t dt = filter_nsec() - t0;
+        best = dt < best ? dt : best;
+    }
+    return best;
+}
+
+void filter_print(FILE *fp, const char *name, const filter_t *f)
+{
+    char settings[64];
+    switch (f->cfg.type)
+    {
+    case FILTER_BESSEL:
+    case FILTER_BUTTERWORTH:
+        snprintf(settings, sizeof(settings), "%s %d %g", filter_type_name(f->cfg.type), f->cfg.order, f->cfg.cutoff);
+        break;
+    case FILTER_MOVING_AVERAGE:
+        snprintf(settings, sizeof(settings), "%s %d", filter_type_name(f->cfg.type), f->cfg.order);
+        break;
+    case FILTER_ALPHA_BETA:
+        snprintf(settings, sizeof(settings), "%s %g %g", filter_type_name(f->cfg.type), f->cfg.alpha, f->cfg.beta);
+        break;
+    default:
+        snprintf(settings, sizeof(settings), "%s", filter_type_name(f->cfg.type));
+        break;
+    }
+    double ns = f->timed > 0 ? (double)f->nsec / f->timed - filter_clock_cost() : 0;
+    fprintf(fp, "[FILTER] %-6s %-20s %10llu samples %7.1f MAC/sample %8.1f ns/sample\n", name, settings, (unsigned long long)f->calls,
+            f->calls > 0 ? (double)f->macs / f->calls : 0, ns > 0 ? ns : 0);
+    return;
+}
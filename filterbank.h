@@ -0,0 +1,348 @@
+/**
+ * @file filterbank.h
+ * @brief Runtime-selectable filters for the vector signals of the ACS (B, B-dot, omega, sun vector): Bessel,
+ * Butterworth, moving average and alpha-beta, behind a common stateful interface with per-filter cost counters.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __FILTERBANK_H
+#define __FILTERBANK_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <macros.h>
+#include <bessel.h>
+#include <arena.h>
+
+#ifndef FILTER_MAX_ORDER
+/**
+ * @brief Highest Butterworth order, realized as FILTER_MAX_ORDER / 2 second order sections. Must be even.
+ *
+ */
+#define FILTER_MAX_ORDER 8
+#endif
+
+#ifndef FILTER_TIMING_PERIOD
+/**
+ * @brief One in FILTER_TIMING_PERIOD applications of a filter is timed, reading the clock costs more than the
+ * cheaper filters. Must be a power of 2.
+ *
+ */
+#define FILTER_TIMING_PERIOD 16
+#endif
+
+/**
+ * @brief Filter types.
+ *
+ */
+typedef enum
+{
+    FILTER_NONE,           // samples pass through
+    FILTER_BESSEL,         // Bessel weighted average of the circular buffer, see calculateBessel()
+    FILTER_BUTTERWORTH,    // IIR Butterworth low pass, cascade of second order sections
+    FILTER_MOVING_AVERAGE, // average of the last order samples
+    FILTER_ALPHA_BETA,     // alpha-beta tracker, constant rate model
+    FILTER_TYPE_COUNT
+} filter_type;
+
+/**
+ * @brief Filter settings.
+ *
+ */
+typedef struct
+{
+    /**
+     * @brief Filter type
+     *
+     */
+    filter_type type;
+    /**
+     * @brief Bessel and Butterworth order, moving average window (samples); 0 for the Bessel default
+     *
+     */
+    int order;
+    /**
+     * @brief Bessel and Butterworth cut-off, as the period of the cut-off frequency (samples); 0 for the Bessel default
+     *
+     */
+    float cutoff;
+    /**
+     * @brief Alpha-beta position gain, in (0, 1]
+     *
+     */
+    float alpha;
+    /**
+     * @brief Alpha-beta rate gain (per sample), in (0, 4 - 2 alpha)
+     *
+     */
+    float beta;
+} filter_config_t;
+
+/**
+ * @brief State of the filter of one axis.
+ *
+ */
+typedef struct
+{
+    double z[FILTER_MAX_ORDER]; // Butterworth delays, two per section
+    running_avg_t avg;          // moving average of the inputs in the history of the axis
+    double x, v;                // alpha-beta estimate and rate (per sample)
+    int head;                   // moving average index of the oldest input
+    int count;                  // samples filtered, saturates at SH_BUFFER_MAX
+} filter_axis_t;
+
+/**
+ * @brief State of a filter, reset by filter_reset() and saved in the simulation checkpoints with the history,
+ * see filter_save_t.
+ *
+ */
+typedef struct
+{
+    filter_axis_t axis[3];
+} filter_state_t;
+
+/**
+ * @brief Copy of the state and the history of a filter, saved in the simulation checkpoints.
+ *
+ */
+typedef struct
+{
+    filter_state_t st;
+    double hist[3][SH_BUFFER_MAX];
+} filter_save_t;
+
+/**
+ * @brief Bytes the history of a filter of the given capacity takes in an arena, to size the arena.
+ *
+ */
+#define FILTER_ARENA_SIZE(capacity) (3 * arena_round((size_t)(capacity) * sizeof(double)))
+
+/**
+ * @brief Filter of a vector signal, one per signal.
+ *
+ */
+typedef struct
+{
+    /**
+     * @brief Settings
+     *
+     */
+    filter_config_t cfg;
+    /**
+     * @brief Bessel coefficients, besselSize() of them computed
+     *
+     */
+    float coeff[SH_BUFFER_MAX];
+    /**
+     * @brief Bessel taps, coefficients above BESSEL_MIN_THRESHOLD
+     *
+     */
+    int taps;
+    /**
+     * @brief Bessel filter with the default order and cut-off, applied with the unrolled default table in
+     * BESSEL_FIXED builds
+     *
+     */
+    int fixed;
+    /**
+     * @brief Butterworth sections, b0 b1 b2 a1 a2 (a0 = 1)
+     *
+     */
+    double sos[FILTER_MAX_ORDER / 2][5];
+    /**
+     * @brief Number of Butterworth sections
+     *
+     */
+    int sections;
+    /**
+     * @brief Moving average inputs of the axes, hist_size of them, carved out of an arena by filter_alloc()
+     *
+     */
+    double *hist[3];
+    /**
+     * @brief Capacity of the history, the longest moving average window, 0 if not allocated
+     *
+     */
+    int hist_size;
+    /**
+     * @brief State
+     *
+     */
+    filter_state_t st;
+    /**
+     * @brief Number of samples filtered, per axis
+     *
+     */
+    uint64_t calls;
+    /**
+     * @brief Multiply-accumulate operations, all axes
+     *
+     */
+    uint64_t macs;
+    /**
+     * @brief Time spent in the timed applications of APPLY_DFILTER() and APPLY_FFILTER(), all axes (nsec)
+     *
+     */
+    uint64_t nsec;
+    /**
+     * @brief Number of timed applications
+     *
+     */
+    uint64_t timed;
+} filter_t;
+
+/**
+ * @brief Sets up a filter and resets its state and counters. Keeps the history carved by filter_alloc(). Orders
+ * above the highest supported, and moving average windows longer than the history, are capped, with a warning.
+ *
+ * @param f Filter
+ * @param cfg Settings, with the Bessel defaults filled in
+ * @return int 1 on success, -1 if the settings are invalid
+ */
+int filter_init(filter_t *f, const filter_config_t *cfg);
+
+/**
+ * @brief Carves the history of the filters that keep their inputs (moving average) out of an arena, and resets
+ * the state of the filter. Longer moving average windows are capped, with a warning. A moving average filter
+ * without a history passes its signal through.
+ *
+ * @param f Filter
+ * @param a Arena
+ * @param capacity Longest moving average window, the capacity of the circular buffers
+ * @return int 1 on success, -1 if the arena is exhausted
+ */
+int filter_alloc(filter_t *f, arena_t *a, int capacity);
+
+/**
+ * @brief Resets the state of a filter, the next sample starts it over.
+ *
+ * @param f Filter
+ */
+void filter_reset(filter_t *f);
+
+/**
+ * @brief Copies the state and the history of a filter.
+ *
+ * @param s Copy
+ * @param f Filter
+ */
+void filter_save(filter_save_t *s, const filter_t *f);
+
+/**
+ * @brief Restores the state and the history of a filter from a copy saved at the same capacity.
+ *
+ * @param f Filter
+ * @param s Copy
+ */
+void filter_restore(filter_t *f, const filter_save_t *s);
+
+/**
+ * @brief Returns the filtered value of the newest sample of one axis of a circular buffer, updating the state
+ * of the filter. The Bessel filter reads the past values in the buffer, the others keep their own history.
+ *
+ * @param f Filter
+ * @param axis Axis, 0 to 2
+ * @param arr Circular buffer of the axis, of capacity bessel_mask + 1
+ * @param index Index of the newest sample
+ * @return double Filtered value
+ */
+double filter_dapply(filter_t *f, int axis, double arr[], int index);
+
+/**
+ * @brief Returns the filtered value of the newest sample of one axis of a circular buffer, see filter_dapply().
+ *
+ * @param f Filter
+ * @param axis Axis, 0 to 2
+ * @param arr Circular buffer of the axis, of capacity bessel_mask + 1
+ * @param index Index of the newest sample
+ * @return float Filtered value
+ */
+float filter_fapply(filter_t *f, int axis, float arr[], int index);
+
+/**
+ * @brief Parses filter settings: "none", "bessel [order cut-off]", "butterworth order cut-off",
+ * "moving_average window" or "alpha_beta alpha beta".
+ *
+ * @param cfg Parsed settings
+ * @param value String to parse
+ * @return int 1 on success, -1 if the string is invalid
+ */
+int filter_parse(filter_config_t *cfg, const char *value);
+
+/**
+ * @brief Name of a filter type, as accepted by filter_parse().
+ *
+ * @param type Filter type
+ * @return const char* Name
+ */
+const char *filter_type_name(filter_type type);
+
+/**
+ * @brief Prints the settings and the cost counters of a filter on one line, per sample of the three axes.
+ *
+ * @param fp Output
+ * @param name Name of the filtered signal
+ * @param f Filter
+ */
+void filter_print(FILE *fp, const char *name, const filter_t *f);
+
+/**
+ * @brief Monotonic time for the filter cost counters.
+ *
+ * @return uint64_t Nanoseconds
+ */
+static inline uint64_t filter_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Applies a filter on a double precision buffer declared using DECLARE_RING(), and stores the filtered value at the current index.
+ * One in FILTER_TIMING_PERIOD applications is timed.
+ *
+ * @param f Filter
+ * @param name Name of the buffer
+ * @param index Current index
+ */
+#define APPLY_DFILTER(f, name, index)                                                           \
+    do                                                                                          \
+    {                                                                                           \
+        uint64_t fb__t0 = ((f)->calls & (FILTER_TIMING_PERIOD - 1)) == 0 ? filter_nsec() : 0;   \
+        x_##name[index] = filter_dapply(f, 0, x_##name, index);                                 \
+        y_##name[index] = filter_dapply(f, 1, y_##name, index);                                 \
+        z_##name[index] = filter_dapply(f, 2, z_##name, index);                                 \
+        if (fb__t0 != 0)                                                                        \
+        {                                                                                       \
+            (f)->nsec += filter_nsec() - fb__t0;                                                \
+            (f)->timed++;                                                                       \
+        }                                                                                       \
+    } while (0)
+
+/**
+ * @brief Applies a filter on a single precision buffer declared using DECLARE_RING(), and stores the filtered value at the current index.
+ *
+ * @param f Filter
+ * @param name Name of the buffer
+ * @param index Current index
+ */
+#define APPLY_FFILTER(f, name, index)                                                           \
+    do                                                                                          \
+    {                                                                                           \
+        uint64_t fb__t0 = ((f)->calls & (FILTER_TIMING_PERIOD - 1)) == 0 ? filter_nsec() : 0;   \
+        x_##name[index] = filter_fapply(f, 0, x_##name, index);                                 \
+        y_##name[index] = filter_fapply(f, 1, y_##name, index);                                 \
+        z_##name[index] = filter_fapply(f, 2, z_##name, index);                                 \
+        if (fb__t0 != 0)                                                                        \
+        {                                                                                       \
+            (f)->nsec += filter_nsec() - fb__t0;                                                \
+            (f)->timed++;                                                                       \
+        }                                                                                       \
+    } while (0)
+
+#endif // __FILTERBANK_H
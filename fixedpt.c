@@ -0,0 +1,40 @@
+/**
+ * @file fixedpt.c
+ * @brief Fixed-point saturation counter and error statistics.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <fixedpt.h>
+#include <math.h>
+
+uint64_t fxp_saturations = 0;
+
+void fxp_stats_add(fxp_stats_t *st, const double q[3], const double ref[3])
+{
+    double e2 = 0, r2 = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        e2 += (q[i] - ref[i]) * (q[i] - ref[i]);
+        r2 += ref[i] * ref[i];
+    }
+    if (!isfinite(r2))
+        return;
+    st->n++;
+    st->err2 += e2;
+    st->ref2 += r2;
+    if (sqrt(e2) > st->max_err)
+        st->max_err = sqrt(e2);
+    return;
+}
+
+void fxp_stats_print(FILE *fp, const char *name, const char *unit, const fxp_stats_t *st)
+{
+    double n = st->n > 0 ? st->n : 1;
+    double snr = st->err2 > 0 ? 10 * log10(st->ref2 / st->err2) : INFINITY;
+    fprintf(fp, "[FIXEDPT] %-6s %10llu vectors, RMS error %.3e %s, max %.3e %s, SNR %6.1f dB, %llu saturated\n", name,
+            (unsigned long long)st->n, sqrt(st->err2 / n), unit, st->max_err, unit, snr, (unsigned long long)st->saturations);
+    return;
+}
@@ -0,0 +1,302 @@
+/**
+ * @file fixedpt.h
+ * @brief Q15/Q31 fixed-point arithmetic with saturation, and Q31 versions of the vector macros of macros.h,
+ * as run by the flight computer. Values are fractions of a full scale chosen per signal, in [-1, 1).
+ * Products are formed in 64 bits (SMULL/SMLAL on ARM) and saturated when narrowed.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __FIXEDPT_H
+#define __FIXEDPT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef int16_t q15_t; // Q15, 1 sign bit and 15 fractional bits
+typedef int32_t q31_t; // Q31, 1 sign bit and 31 fractional bits
+
+#define Q15_ONE 32768       // 1.0 in Q15, one past the largest value
+#define Q31_ONE 2147483648. // 1.0 in Q31, one past the largest value
+
+/**
+ * @brief Number of results that saturated, over all fixed-point operations. Sticky, like the Q flag of the ARM
+ * saturating instructions; read and clear it around a pipeline stage to attribute saturations.
+ *
+ */
+extern uint64_t fxp_saturations;
+
+/**
+ * @brief Narrows a 64-bit value to Q31, saturating.
+ *
+ * @param x Value
+ * @return q31_t Saturated value
+ */
+static inline q31_t q31_sat(int64_t x)
+{
+    if (x > INT32_MAX)
+    {
+        fxp_saturations++;
+        return INT32_MAX;
+    }
+    if (x < INT32_MIN)
+    {
+        fxp_saturations++;
+        return INT32_MIN;
+    }
+    return (q31_t)x;
+}
+
+/**
+ * @brief Converts to Q31 with rounding, saturating.
+ *
+ * @param x Value
+ * @param scale Full scale of the signal, x / scale is converted
+ * @return q31_t Q31 value
+ */
+static inline q31_t q31_from_double(double x, double scale)
+{
+    double q = x / scale * Q31_ONE;
+    if (!(q < 2147483647.)) // NaN saturates high, the flight ADC rails
+    {
+        fxp_saturations++;
+        return INT32_MAX;
+    }
+    if (q < -Q31_ONE)
+    {
+        fxp_saturations++;
+        return INT32_MIN;
+    }
+    return (q31_t)(q < 0 ? q - 0.5 : q + 0.5);
+}
+
+/**
+ * @brief Converts from Q31.
+ *
+ * @param x Q31 value
+ * @param scale Full scale of the signal
+ * @return double Value
+ */
+static inline double q31_to_double(q31_t x, double scale)
+{
+    return x / Q31_ONE * scale;
+}
+
+/**
+ * @brief Converts to Q15 with rounding, saturating.
+ *
+ * @param x Value in [-1, 1)
+ * @return q15_t Q15 value
+ */
+static inline q15_t q15_from_double(double x)
+{
+    double q = x * Q15_ONE;
+    if (!(q < 32767.))
+    {
+        fxp_saturations++;
+        return INT16_MAX;
+    }
+    if (q < -Q15_ONE)
+    {
+        fxp_saturations++;
+        return INT16_MIN;
+    }
+    return (q15_t)(q < 0 ? q - 0.5 : q + 0.5);
+}
+
+/**
+ * @brief Saturating Q31 addition (QADD).
+ *
+ */
+static inline q31_t q31_add(q31_t a, q31_t b)
+{
+    return q31_sat((int64_t)a + b);
+}
+
+/**
+ * @brief Saturating Q31 subtraction (QSUB).
+ *
+ */
+static inline q31_t q31_sub(q31_t a, q31_t b)
+{
+    return q31_sat((int64_t)a - b);
+}
+
+/**
+ * @brief Q31 multiplication with rounding, saturating (-1 * -1).
+ *
+ */
+static inline q31_t q31_mul(q31_t a, q31_t b)
+{
+    return q31_sat(((int64_t)a * b + (1LL << 30)) >> 31);
+}
+
+/**
+ * @brief Multiplies a Q31 value by a Q15 value with rounding.
+ *
+ */
+static inline q31_t q31_mul_q15(q31_t a, q15_t b)
+{
+    return (q31_t)(((int64_t)a * b + (1 << 14)) >> 15);
+}
+
+/**
+ * @brief Multiplies a Q31 value by a gain in Q15.16 (e.g. a sampling frequency or a ratio of full scales),
+ * with rounding, saturating.
+ *
+ * @param a Q31 value
+ * @param k Gain, k / 65536
+ * @return q31_t Q31 value
+ */
+static inline q31_t q31_gain(q31_t a, int32_t k)
+{
+    return q31_sat(((int64_t)a * k + (1 << 15)) >> 16);
+}
+
+/**
+ * @brief Gain in Q15.16 for q31_gain().
+ *
+ */
+static inline int32_t q16_gain(double k)
+{
+    double q = k * 65536.;
+    return q >= INT32_MAX ? INT32_MAX : q <= INT32_MIN ? INT32_MIN : (int32_t)(q < 0 ? q - 0.5 : q + 0.5);
+}
+
+/**
+ * @brief Quotient of two 64-bit values of the same Q format (e.g. a cross product and a squared norm) in Q31,
+ * saturating. The operands are shifted down together until the divisor fits in 32 bits, so the division is
+ * 64 by 32 bits.
+ *
+ * @param num Dividend
+ * @param den Divisor
+ * @return q31_t num / den in Q31, 0 if den is 0
+ */
+static inline q31_t q31_div64(int64_t num, int64_t den)
+{
+    if (den == 0)
+        return 0;
+    if (den < 0)
+    {
+        num = -num;
+        den = -den;
+    }
+    int s = den >> 31 ? 33 - __builtin_clzll(den) : 0; // den >> s < 2^31
+    num >>= s;
+    den >>= s;
+    if (num >= (1LL << 32) || num < -(1LL << 32))
+        return q31_sat(num > 0 ? INT64_MAX : INT64_MIN);
+    return q31_sat((num * (1LL << 31)) / den);
+}
+
+/**
+ * @brief Saturating element-by-element addition or subtraction of Q31 vectors declared using DECLARE_VECTOR()
+ * (or elements of buffers), as VECTOR_OP(). The destination can be the same as any of the sources.
+ *
+ * @param dest Destination vector
+ * @param s1 First vector
+ * @param s2 Second vector
+ * @param op q31_add or q31_sub
+ */
+#define QVECTOR_OP(dest, s1, s2, op)    \
+    x_##dest = op(x_##s1, x_##s2);      \
+    y_##dest = op(y_##s1, y_##s2);      \
+    z_##dest = op(z_##s1, z_##s2)
+
+/**
+ * @brief Multiplies a Q31 vector by a gain in Q15.16, saturating, as VECTOR_MIXED() with *.
+ *
+ * @param dest Destination vector
+ * @param s1 Input vector
+ * @param k Gain from q16_gain()
+ */
+#define QVECTOR_GAIN(dest, s1, k)       \
+    x_##dest = q31_gain(x_##s1, k);     \
+    y_##dest = q31_gain(y_##s1, k);     \
+    z_##dest = q31_gain(z_##s1, k)
+
+/**
+ * @brief Cross product of two Q31 vectors in Q62, into int64_t vector dest, as CROSS_PRODUCT(). Exact: each
+ * product is below 2^62, so their difference fits.
+ *
+ * @param dest Destination vector of int64_t, different from the inputs
+ * @param s1 First vector
+ * @param s2 Second vector
+ */
+#define QCROSS_PRODUCT(dest, s1, s2)                                          \
+    x_##dest = (int64_t)y_##s1 * z_##s2 - (int64_t)z_##s1 * y_##s2;           \
+    y_##dest = (int64_t)z_##s1 * x_##s2 - (int64_t)x_##s1 * z_##s2;           \
+    z_##dest = (int64_t)x_##s1 * y_##s2 - (int64_t)y_##s1 * x_##s2
+
+/**
+ * @brief Dot product of two Q31 vectors in Q61 (the sum of three Q62 products, halved so it cannot overflow),
+ * as DOT_PRODUCT().
+ *
+ * @param s1 First vector
+ * @param s2 Second vector
+ */
+#define QDOT_PRODUCT(s1, s2) \
+    (((int64_t)x_##s1 * x_##s2 >> 1) + ((int64_t)y_##s1 * y_##s2 >> 1) + ((int64_t)z_##s1 * z_##s2 >> 1))
+
+/**
+ * @brief Squared norm of a Q31 vector in Q61, as NORM2().
+ *
+ * @param s Vector
+ */
+#define QNORM2(s) QDOT_PRODUCT(s, s)
+
+/**
+ * @brief Row of a Q31 matrix times a Q31 vector, rounded and saturated, from the sum of the Q62 products halved
+ * to Q61 so that it cannot overflow.
+ *
+ */
+#define QMATVECMUL_ROW(M, i, s) \
+    q31_sat((((int64_t)M[i][0] * x_##s >> 1) + ((int64_t)M[i][1] * y_##s >> 1) + ((int64_t)M[i][2] * z_##s >> 1) + (1LL << 29)) >> 30)
+
+/**
+ * @brief Multiplies a Q31 vector by a Q31 matrix, saturating, as MATVECMUL().
+ *
+ * @param dest Output vector, different from the input
+ * @param M 3 x 3 matrix of q31_t
+ * @param s Input vector
+ */
+#define QMATVECMUL(dest, M, s)             \
+    x_##dest = QMATVECMUL_ROW(M, 0, s);    \
+    y_##dest = QMATVECMUL_ROW(M, 1, s);    \
+    z_##dest = QMATVECMUL_ROW(M, 2, s)
+
+/**
+ * @brief Error statistics of a fixed-point signal against its floating point counterpart.
+ *
+ */
+typedef struct
+{
+    uint64_t n;           // vectors compared
+    double err2;          // sum of the squared error norms
+    double ref2;          // sum of the squared reference norms
+    double max_err;       // largest error norm
+    uint64_t saturations; // saturated results in the stage computing the signal
+} fxp_stats_t;
+
+/**
+ * @brief Adds a vector to the error statistics. Non-finite references are skipped.
+ *
+ * @param st Statistics
+ * @param q Fixed-point vector, converted to double
+ * @param ref Floating point vector
+ */
+void fxp_stats_add(fxp_stats_t *st, const double q[3], const double ref[3]);
+
+/**
+ * @brief Prints the error statistics on one line: RMS and largest error, signal to error ratio, saturations.
+ *
+ * @param fp Output
+ * @param name Name of the signal
+ * @param unit Unit of the signal
+ * @param st Statistics
+ */
+void fxp_stats_print(FILE *fp, const char *name, const char *unit, const fxp_stats_t *st);
+
+#endif // __FIXEDPT_H
@@ -0,0 +1,97 @@
+/**
+ * @file loopmon.c
+ * @brief Loop period, jitter and overrun monitor for the ACS loop.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <loopmon.h>
+#include <string.h>
+#include <math.h>
+
+void loopmon_init(loopmon_t *mon, uint32_t period)
+{
+    memset(mon, 0, sizeof(loopmon_t));
+    mon->period = period;
+    mon->index = -1;
+}
+
+void loopmon_start(loopmon_t *mon, uint64_t tnow)
+{
+    if (mon->t_start == 0) // first period, start the schedule now
+    {
+        mon->deadline = tnow;
+        mon->t_start = tnow;
+        return;
+    }
+    if (mon->index == LOOPMON_WINDOW - 1) // hit max, buffer full
+        mon->full = 1;
+    mon->index = (mon->index + 1) % LOOPMON_WINDOW;
+    mon->hist[mon->index] = tnow - mon->t_start; // start-to-start period
+    if (mon->period > 0)                         // lateness or earliness against the schedule
+        mon->jitter[mon->index] = tnow > mon->deadline ? tnow - mon->deadline : mon->deadline - tnow;
+    else
+        mon->jitter[mon->index] = 0;
+    mon->t_start = tnow;
+}
+
+uint32_t loopmon_end(loopmon_t *mon, uint64_t tnow)
+{
+    mon->exec = tnow - mon->t_start;
+    if (mon->period == 0) // free running, there is no deadline to miss
+        return 0;
+    mon->deadline += mon->period; // start of the next period
+    if (tnow >= mon->deadline)    // work did not finish in time
+    {
+        mon->overruns++;
+        mon->deadline = tnow; // re-sync, do not burst to catch up
+        return 0;
+    }
+    return mon->deadline - tnow;
+}
+
+/**
+ * @brief Insertion sort of the copy of the window, in arrival order. Quadratic, but the window is small and the
+ * statistics are computed once per period.
+ *
+ * @param arr Array to sort in place
+ * @param size Length of the array
+ */
+static inline void sort_u32(uint32_t arr[], int size)
+{
+    for (int i = 1; i < size; i++)
+    {
+        uint32_t val = arr[i];
+        int j = i - 1;
+        for (; j >= 0 && arr[j] > val; j--)
+            arr[j + 1] = arr[j];
+        arr[j + 1] = val;
+    }
+}
+
+void loopmon_stats(const loopmon_t *mon, loopmon_stats_t *stats)
+{
+    memset(stats, 0, sizeof(loopmon_stats_t));
+    int count = mon->full ? LOOPMON_WINDOW : mon->index + 1;
+    if (count <= 0)
+        return;
+    uint32_t sorted[LOOPMON_WINDOW];
+    memcpy(sorted, mon->hist, count * sizeof(uint32_t));
+    sort_u32(sorted, count);
+    uint64_t sum = 0;
+    for (int i = 0; i < count; i++)
+        sum += sorted[i];
+    stats->min = sorted[0];
+    stats->max = sorted[count - 1];
+    stats->mean = sum / count;
+    stats->p99 = sorted[(99 * count + 99) / 100 - 1]; // ceil(0.99 * count) - 1
+    double sum2 = 0;
+    for (int i = 0; i < count; i++)
+    {
+        sum2 += (double)mon->jitter[i] * mon->jitter[i];
+        stats->jitter_max = mon->jitter[i] > stats->jitter_max ? mon->jitter[i] : stats->jitter_max;
+    }
+    stats->jitter_rms = sqrt(sum2 / count);
+}
@@ -0,0 +1,129 @@
+/**
+ * @file loopmon.h
+ * @brief Loop period, jitter and overrun monitor for the ACS loop.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __LOOPMON_H
+#define __LOOPMON_H
+
+#include <stdint.h>
+
+#ifndef LOOPMON_WINDOW
+/**
+ * @brief Number of loop periods kept for the rolling statistics.
+ *
+ */
+#define LOOPMON_WINDOW 128
+#endif
+
+/**
+ * @brief State of the loop monitor. Keeps the measured start-to-start
+ * period and the start jitter of the last LOOPMON_WINDOW iterations in circular buffers.
+ *
+ */
+typedef struct
+{
+    /**
+     * @brief Nominal loop period (usec)
+     *
+     */
+    uint32_t period;
+    /**
+     * @brief Absolute time at which the current period is scheduled to start (usec)
+     *
+     */
+    uint64_t deadline;
+    /**
+     * @brief Actual start time of the current period (usec)
+     *
+     */
+    uint64_t t_start;
+    /**
+     * @brief Measured start-to-start periods (usec)
+     *
+     */
+    uint32_t hist[LOOPMON_WINDOW];
+    /**
+     * @brief Distance |start - deadline| of the actual start of the same periods from their scheduled start (usec),
+     * 0 for a free running monitor
+     *
+     */
+    uint32_t jitter[LOOPMON_WINDOW];
+    /**
+     * @brief Current index of the period circular buffer, -1 indicates uninitiated buffer
+     *
+     */
+    int index;
+    /**
+     * @brief Indicates if the period circular buffer is full
+     *
+     */
+    int full;
+    /**
+     * @brief Execution time of the last completed period (usec)
+     *
+     */
+    uint32_t exec;
+    /**
+     * @brief Number of periods whose execution ran past the next deadline
+     *
+     */
+    uint32_t overruns;
+} loopmon_t;
+
+/**
+ * @brief Rolling statistics of the loop period and start jitter, in usec.
+ *
+ */
+typedef struct
+{
+    uint32_t min;
+    uint32_t mean;
+    uint32_t p99;
+    uint32_t max;
+    uint32_t jitter_rms; // RMS of |start - deadline|
+    uint32_t jitter_max; // max of |start - deadline|
+} loopmon_stats_t;
+
+/**
+ * @brief Initializes the loop monitor.
+ *
+ * @param mon Loop monitor
+ * @param period Nominal loop period (usec)
+ */
+void loopmon_init(loopmon_t *mon, uint32_t period);
+
+/**
+ * @brief Records the actual start time of a loop period. Must be called first thing in every iteration.
+ *
+ * @param mon Loop monitor
+ * @param tnow Current time (usec)
+ */
+void loopmon_start(loopmon_t *mon, uint64_t tnow);
+
+/**
+ * @brief Records the end of the work in a loop period, and returns the time to sleep until the next period.
+ * If the work ran past the next deadline, an overrun is counted and the schedule is re-synchronized
+ * to the current time instead of trying to catch up on missed periods. A monitor with a nominal period
+ * of 0 is free running, and never sleeps or counts overruns.
+ *
+ * @param mon Loop monitor
+ * @param tnow Current time (usec)
+ * @return uint32_t Time to sleep (usec) until the start of the next period
+ */
+uint32_t loopmon_end(loopmon_t *mon, uint64_t tnow);
+
+/**
+ * @brief Calculates min, mean, 99th percentile and max of the loop period, and RMS and max of the start jitter,
+ * over the monitor window.
+ *
+ * @param mon Loop monitor
+ * @param stats Output statistics, all zero if no period has been completed yet
+ */
+void loopmon_stats(const loopmon_t *mon, loopmon_stats_t *stats);
+
+#endif // __LOOPMON_H
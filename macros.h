@@ -12,7 +12,9 @@
 #define __SH_MACROS_H
 
 #include <stdio.h>
+#include <math.h>
 #include <stdint.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -30,12 +32,13 @@
  * 
  */
 #ifndef MATH_SQRT
-inline float q2isqrt(float x)
+static inline float q2isqrt(float x)
 {
-    float xhalf = x * 0.5f;               // calculate 1/2 x before bit-level changes
-    int i = *(int *)&x;                   // convert float to int for bit level operation
-    i = 0x5f375a86 - ((*(int *)&x) >> 1); // bit level manipulation to get initial guess (ref: http://www.lomont.org/papers/2003/InvSqrt.pdf)
-    x = *(float *)&i;                     // convert back to float
+    float xhalf = x * 0.5f;   // calculate 1/2 x before bit-level changes
+    int32_t i;
+    memcpy(&i, &x, sizeof(i)); // convert float to int for bit level operation (memcpy, as pointer casts break strict aliasing)
+    i = 0x5f375a86 - (i >> 1); // bit level manipulation to get initial guess (ref: http://www.lomont.org/papers/2003/InvSqrt.pdf)
+    memcpy(&x, &i, sizeof(x)); // convert back to float
     x = x * (1.5f - xhalf * x * x);       // 1 round of Newton approximation
     x = x * (1.5f - xhalf * x * x);       // 2 round of Newton approximation
     x = x * (1.5f - xhalf * x * x);       // 3 round of Newton approximation
@@ -43,7 +46,7 @@ inline float q2isqrt(float x)
 }
 #else // MATH_SQRT
 #include <math.h>
-inline float q2isqrt(float x)
+static inline float q2isqrt(float x)
 {
     return 1.0 / sqrt(x);
 };
@@ -55,54 +58,204 @@ inline float q2isqrt(float x)
  * 
  * @return uint64_t Number of microseconds elapsed from epoch.
  */
-inline uint64_t get_usec(void)
+static inline uint64_t get_usec(void)
 {
     struct timespec ts;
     timespec_get(&ts, TIME_UTC);
     return (uint64_t)ts.tv_sec * 1000000L + ((uint64_t)ts.tv_nsec) / 1000;
 }
 
+#ifndef SH_SUM_BLOCK
+/**
+ * @brief Length up to which fsum() and dsum() add directly, with 8 interleaved accumulators; longer arrays are
+ * split in halves. Must be a multiple of 8.
+ *
+ */
+#define SH_SUM_BLOCK 128
+#endif
+
+/**
+ * @brief Pairwise sum of a float array. The leaves are summed by 8 independent accumulators, which the
+ * compiler keeps in one vector register, and the halves are summed recursively, so the rounding error grows as
+ * log(size) instead of size.
+ *
+ * @param arr Pointer to array whose sum is calculated
+ * @param size Length of the input array
+ * @return float Sum of the input array
+ */
+static inline float fsum(const float arr[], int size)
+{
+    if (size > SH_SUM_BLOCK)
+    {
+        int half = (size / 2 + 7) & ~7; // keeps the leaves aligned like arr
+        return fsum(arr, half) + fsum(arr + half, size - half);
+    }
+    float acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    int i = 0;
+    for (; i + 8 <= size; i += 8)
+        for (int j = 0; j < 8; j++)
+            acc[j] += arr[i + j];
+    float tail = 0;
+    for (; i < size; i++)
+        tail += arr[i];
+    return ((acc[0] + acc[4]) + (acc[2] + acc[6])) + ((acc[1] + acc[5]) + (acc[3] + acc[7])) + tail;
+}
+
 /**
- * @brief Calculates floating point average of a float array.
+ * @brief Pairwise sum of a double precision array, see fsum().
+ *
+ * @param arr Pointer to array whose sum is calculated
+ * @param size Length of the input array
+ * @return double Sum of the input array
+ */
+static inline double dsum(const double arr[], int size)
+{
+    if (size > SH_SUM_BLOCK)
+    {
+        int half = (size / 2 + 7) & ~7;
+        return dsum(arr, half) + dsum(arr + half, size - half);
+    }
+    double acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    int i = 0;
+    for (; i + 8 <= size; i += 8)
+        for (int j = 0; j < 8; j++)
+            acc[j] += arr[i + j];
+    double tail = 0;
+    for (; i < size; i++)
+        tail += arr[i];
+    return ((acc[0] + acc[4]) + (acc[2] + acc[6])) + ((acc[1] + acc[5]) + (acc[3] + acc[7])) + tail;
+}
+
+/**
+ * @brief Calculates floating point average of a float array, by pairwise summation (see fsum()).
  * 
  * @param arr Pointer to array whose average is calculated
  * @param size Length of the input array
  * @return float Average of the input array
  */
-inline float faverage(float arr[], int size)
+static inline float faverage(const float arr[], int size)
 {
-    float result = 0;
-    int count = size;
-    while (count--)
-        result += arr[count];
-    return result / size;
+    return fsum(arr, size) / size;
 }
 /**
- * @brief Calculates double precision point average of a float array.
+ * @brief Calculates double precision point average of a double precision array, by pairwise summation (see dsum()).
  * 
  * @param arr Pointer to array whose average is calculated
  * @param size Length of the input array
  * @return double Average of the input array
  */
-inline double daverage(double arr[], int size)
+static inline double daverage(const double arr[], int size)
 {
-    double result = 0;
-    int count = size;
-    while (count--)
-        result += arr[count];
-    return result / size;
+    return dsum(arr, size) / size;
 }
 
-// DECLARE_BUFFER(name, type): Declares a buffer with name and type. Prepends x_, y_, z_ to the names (vector buffer!)
 /**
- * @brief Declares a buffer with name and type. Prepends x_, y_, z_ to the names (vector buffer!)
- * This macro allocates three arrays x_name, y_name and z_name of type and size SH_BUFFER_SIZE.
- * 
- * @param name Name of the buffer (prepends x_, y_, z_ for vector)
- * @param type Data type of the buffer
+ * @brief Running average of a window of samples, updated in O(1) per sample as the window slides over a
+ * circular buffer. The sum is compensated (Neumaier), so it does not drift however long the window slides;
+ * the samples themselves stay in the caller's buffer.
+ *
+ */
+typedef struct
+{
+    double sum;  // sum of the window
+    double comp; // rounding error of sum, added back by ravg_mean()
+    int count;   // samples in the window
+} running_avg_t;
+
+/**
+ * @brief Empties a running average.
+ *
+ * @param r Running average
+ */
+static inline void ravg_reset(running_avg_t *r)
+{
+    r->sum = 0;
+    r->comp = 0;
+    r->count = 0;
+}
+
+/**
+ * @brief Compensated addition of x to the sum of a running average.
+ *
+ */
+static inline void ravg_accumulate(running_avg_t *r, double x)
+{
+    double t = r->sum + x;
+    if (fabs(r->sum) >= fabs(x))
+        r->comp += (r->sum - t) + x;
+    else
+        r->comp += (x - t) + r->sum;
+    r->sum = t;
+}
+
+/**
+ * @brief Adds a sample to the window of a running average, the window grows by one.
+ *
+ * @param r Running average
+ * @param in New sample
+ */
+static inline void ravg_push(running_avg_t *r, double in)
+{
+    ravg_accumulate(r, in);
+    r->count++;
+}
+
+/**
+ * @brief Slides the window of a running average by one sample: in enters and out, the oldest sample, leaves.
+ *
+ * @param r Running average
+ * @param out Sample leaving the window, read from the buffer before in overwrites it
+ * @param in New sample
+ */
+static inline void ravg_replace(running_avg_t *r, double out, double in)
+{
+    ravg_accumulate(r, in);
+    ravg_accumulate(r, -out);
+}
+
+/**
+ * @brief Average of the window of a running average.
+ *
+ * @param r Running average
+ * @return double Average, 0 if the window is empty
  */
-#define DECLARE_BUFFER(name, type) \
-    type x_##name[SH_BUFFER_SIZE], y_##name[SH_BUFFER_SIZE], z_##name[SH_BUFFER_SIZE]
+static inline double ravg_mean(const running_avg_t *r)
+{
+    return r->count > 0 ? (r->sum + r->comp) / r->count : 0;
+}
+
+/**
+ * @brief Inverts a 3x3 matrix by its adjugate, in double precision.
+ *
+ * @param dest Inverse of the input matrix
+ * @param src  3 x 3 input matrix
+ * @return int 1 on success, 0 if the matrix is singular (dest is untouched)
+ */
+static inline int matinv3(float dest[3][3], float src[3][3])
+{
+    double a[3][3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            a[i][j] = src[i][j];
+    double c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+    double c01 = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+    double c02 = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+    double det = a[0][0] * c00 + a[0][1] * c01 + a[0][2] * c02;
+    double scale = fabs(a[0][0]) + fabs(a[1][1]) + fabs(a[2][2]);
+    if (det == 0 || fabs(det) < 1e-12 * scale * scale * scale)
+        return 0;
+    double idet = 1.0 / det;
+    dest[0][0] = c00 * idet;
+    dest[1][0] = c01 * idet;
+    dest[2][0] = c02 * idet;
+    dest[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * idet;
+    dest[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * idet;
+    dest[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * idet;
+    dest[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * idet;
+    dest[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * idet;
+    dest[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * idet;
+    return 1;
+}
 
 /**
  * @brief Clears a vector.
@@ -137,37 +290,6 @@ inline double daverage(double arr[], int size)
 #define DECLARE_VECTOR2(name, type) \
     type x_##name, y_##name, z_##name
 
-/**
- * @brief Flushes a buffer declared using DECLARE_BUFFER().
- * Does not reset index counters or buffer full indicators,
- * which needs to be done by hand on a case by case basis.
- * 
- */
-#define FLUSH_BUFFER(name)                                       \
-    for (uint8_t sh__counter = SH_BUFFER_SIZE; sh__counter > 0;) \
-    {                                                            \
-        sh__counter--;                                           \
-        x_##name[sh__counter] = 0;                               \
-        y_##name[sh__counter] = 0;                               \
-        z_##name[sh__counter] = 0;                               \
-    }
-
-/**
- * @brief Resets all buffers and resets indices, while not clearing buffer full indicators.
- * 
- */
-#define FLUSH_BUFFER_ALL \
-    FLUSH_BUFFER(g_B);   \
-    FLUSH_BUFFER(g_Bt);  \
-    FLUSH_BUFFER(g_W);   \
-    FLUSH_BUFFER(g_S);   \
-    mag_index = -1;      \
-    sol_index = -1;      \
-    bdot_index = -1;     \
-    omega_index = -1;    \
-    g_nightmode = 0;     \
-    omega_ready = -1;
-
 /**
  * @brief Calculates cross product of two vectors created using DECLARE_VECTOR().
  * The destination vector must be a different vector from any of the inputs.
@@ -290,11 +412,11 @@ inline double daverage(double arr[], int size)
     z_##dest = s1[2][0] * x_##s2 + s1[2][1] * y_##s2 + s1[2][2] * z_##s2
 
 /**
- * @brief Calculates 32-bit float average of an input buffer.
+ * @brief Calculates 32-bit float average of an input buffer, by pairwise summation.
  * 
  * @param dest Output vector, declared using DECLARE_VECTOR()
- * @param src  Input buffer, declared using DECLARE_BUFFER()
- * @param size Size of the input buffer (equals to SH_BUFFER_SIZE for a buffer declared using DECLARE_BUFFER())
+ * @param src  Input buffer, declared using DECLARE_RING()
+ * @param size Number of elements to average, from the start of the storage, at most RING_CAPACITY(src)
  * 
  */
 #define FAVERAGE_BUFFER(dest, src, size) \
@@ -303,11 +425,11 @@ inline double daverage(double arr[], int size)
     z_##dest = faverage(z_##src, size)
 
 /**
- * @brief Calculates double precision average of an input buffer.
+ * @brief Calculates double precision average of an input buffer, by pairwise summation.
  * 
  * @param dest Output vector, declared using DECLARE_VECTOR()
- * @param src  Input buffer, declared using DECLARE_BUFFER()
- * @param size Size of the input buffer (equals to SH_BUFFER_SIZE for a buffer declared using DECLARE_BUFFER())
+ * @param src  Input buffer, declared using DECLARE_RING()
+ * @param size Number of elements to average, from the start of the storage, at most RING_CAPACITY(src)
  * 
  */
 #define DAVERAGE_BUFFER(dest, src, size) \
@@ -322,6 +444,15 @@ inline double daverage(double arr[], int size)
         prefix##z_##dest = z_##src;      \
     }
 
+#ifdef ACS_PRINT
+/**
+ * @brief Terminal color codes used by the ACS_PRINT messages.
+ */
+#define RED "\x1b[31m"
+#define YLW "\x1b[33m"
+#define RST "\x1b[0m"
+#endif // ACS_PRINT
+
 #ifdef _DOXYGEN_
 /**
  * @brief Passing this option in CFLAGS enables data logging feature of ACS into a file.
@@ -0,0 +1,302 @@
+/**
+ * @file magfield.c
+ * @brief Geomagnetic field model: spherical harmonic expansion up to FIELD_MAX_DEGREE
+ * (tilted dipole at degree 1), with an optional precomputed lookup grid.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <magfield.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/**
+ * @brief Converts the Schmidt semi-normalized coefficients stored in the model to Gauss normalization,
+ * and fills in the Legendre recursion constants, so the evaluation needs no square roots.
+ *
+ * @param m Field model
+ */
+static void field_prepare(field_model_t *m)
+{
+    double S[FIELD_MAX_DEGREE + 1][FIELD_MAX_DEGREE + 1];
+    memset(S, 0, sizeof(S));
+    memset(m->k, 0, sizeof(m->k));
+    S[0][0] = 1;
+    for (int n = 1; n <= m->nmax; n++)
+    {
+        S[n][0] = S[n - 1][0] * (2 * n - 1) / n;
+        for (int j = 1; j <= n; j++)
+            S[n][j] = S[n][j - 1] * sqrt((n - j + 1) * (j == 1 ? 2.0 : 1.0) / (n + j));
+        for (int j = 0; j <= n; j++)
+        {
+            m->g[n][j] *= S[n][j];
+            m->h[n][j] *= S[n][j];
+            if (n > 1)
+                m->k[n][j] = ((n - 1) * (n - 1) - j * j) / (double)((2 * n - 1) * (2 * n - 3));
+        }
+    }
+}
+
+void field_dipole(field_model_t *m)
+{
+    memset(m, 0, sizeof(field_model_t));
+    m->nmax = 1;
+    m->g[1][0] = -29404.8; // IGRF-13, 2020.0
+    m->g[1][1] = -1450.9;
+    m->h[1][1] = 4652.5;
+    field_prepare(m);
+}
+
+int field_load(field_model_t *m, const char *path, int nmax)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return -1;
+    field_grid_t *grid = m->grid;
+    memset(m, 0, sizeof(field_model_t));
+    m->grid = grid;
+    nmax = nmax > FIELD_MAX_DEGREE ? FIELD_MAX_DEGREE : nmax;
+    char line[256];
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        int n, j;
+        double g, h;
+        if (line[0] == '#' || sscanf(line, "%d %d %lf %lf", &n, &j, &g, &h) != 4)
+            continue;
+        if (n < 1 || n > nmax || j < 0 || j > n)
+            continue;
+        m->g[n][j] = g;
+        m->h[n][j] = h;
+        m->nmax = n > m->nmax ? n : m->nmax;
+    }
+    fclose(fp);
+    if (m->nmax == 0)
+        return -1;
+    field_prepare(m);
+    return m->nmax;
+}
+
+/**
+ * @brief Row n of the Gauss-normalized associated Legendre functions and their colatitude derivatives from rows
+ * n - 1 and n - 2. The orders below n are independent lanes of one loop: k[n - 1] is 0, so order n - 1 takes the
+ * same recursion as the others and reads the zero past the diagonal of row n - 2.
+ *
+ * @param p0 Row n, n + 2 elements written, the last one 0
+ * @param d0 Derivatives of row n
+ * @param p1 Row n - 1
+ * @param d1 Derivatives of row n - 1
+ * @param p2 Row n - 2, zero past its diagonal
+ * @param d2 Derivatives of row n - 2, zero past its diagonal
+ * @param k Recursion constants of degree n
+ * @param ct Cosine of the colatitude
+ * @param st Sine of the colatitude
+ * @param n Degree
+ */
+static inline void field_legendre_row(double *restrict p0, double *restrict d0, const double *restrict p1, const double *restrict d1,
+                                      const double *restrict p2, const double *restrict d2, const double *restrict k, double ct, double st, int n)
+{
+    for (int j = 0; j < n; j++)
+    {
+        p0[j] = ct * p1[j] - k[j] * p2[j];
+        d0[j] = ct * d1[j] - st * p1[j] - k[j] * d2[j];
+    }
+    p0[n] = st * p1[n - 1];
+    d0[n] = st * d1[n - 1] + ct * p1[n - 1];
+    p0[n + 1] = d0[n + 1] = 0;
+}
+
+/**
+ * @brief Adds the terms of degree n of the series to the per order sums, the orders being independent lanes.
+ *
+ * @param Sr Radial sums
+ * @param St Colatitude sums
+ * @param Sp Longitude sums
+ * @param p Legendre functions of degree n
+ * @param dp Their colatitude derivatives
+ * @param g Gauss coefficients of degree n
+ * @param h Gauss coefficients of degree n
+ * @param cm cos(m phi)
+ * @param sm sin(m phi)
+ * @param jcm m cos(m phi)
+ * @param jsm m sin(m phi)
+ * @param arn (a/r)^(n+2)
+ * @param n Degree
+ */
+static inline void field_series_row(double *restrict Sr, double *restrict St, double *restrict Sp, const double *restrict p,
+                                    const double *restrict dp, const double *restrict g, const double *restrict h,
+                                    const double *restrict cm, const double *restrict sm, const double *restrict jcm,
+                                    const double *restrict jsm, double arn, int n)
+{
+    double fr = arn * (n + 1);
+    for (int j = 0; j <= n; j++)
+    {
+        double gc = g[j] * cm[j] + h[j] * sm[j];
+        Sr[j] += fr * gc * p[j];
+        St[j] += arn * gc * dp[j];
+        Sp[j] += arn * (h[j] * jcm[j] - g[j] * jsm[j]) * p[j];
+    }
+}
+
+void field_eval_ecef(const field_model_t *m, const double r[3], double B[3])
+{
+    // rows n - 2, n - 1 and n of the Gauss-normalized associated Legendre functions and their colatitude
+    // derivatives, each with a zero past the diagonal so that every order of a row takes the same recursion
+    double P[3][FIELD_MAX_DEGREE + 2], dP[3][FIELD_MAX_DEGREE + 2];
+    double cm[FIELD_MAX_DEGREE + 1], sm[FIELD_MAX_DEGREE + 1];   // cos(m phi), sin(m phi)
+    double jcm[FIELD_MAX_DEGREE + 1], jsm[FIELD_MAX_DEGREE + 1]; // m cos(m phi), m sin(m phi)
+    double Sr[FIELD_MAX_DEGREE + 1], St[FIELD_MAX_DEGREE + 1], Sp[FIELD_MAX_DEGREE + 1]; // series, summed per order
+    int N = m->nmax;
+
+    double rho2 = r[0] * r[0] + r[1] * r[1];
+    double rn = sqrt(rho2 + r[2] * r[2]);
+    double rho = sqrt(rho2);
+    double ct = r[2] / rn, st = rho / rn; // colatitude
+    double cp = rho > 0 ? r[0] / rho : 1, sp = rho > 0 ? r[1] / rho : 0; // longitude
+    st = st > 1e-10 ? st : 1e-10; // keeps B_phi finite at the poles, where P[n][m > 0] vanish like sin^m
+
+    // cos(m phi), sin(m phi) by recurrence
+    cm[0] = 1;
+    sm[0] = 0;
+    for (int j = 1; j <= N; j++)
+    {
+        cm[j] = cm[j - 1] * cp - sm[j - 1] * sp;
+        sm[j] = sm[j - 1] * cp + cm[j - 1] * sp;
+    }
+    for (int j = 0; j <= N; j++)
+    {
+        jcm[j] = j * cm[j];
+        jsm[j] = j * sm[j];
+        Sr[j] = St[j] = Sp[j] = 0;
+    }
+    double *p2 = P[0], *p1 = P[1], *p0 = P[2];
+    double *d2 = dP[0], *d1 = dP[1], *d0 = dP[2];
+    p2[0] = p2[1] = d2[0] = d2[1] = 0; // n = -1
+    p1[0] = 1;                         // n = 0
+    p1[1] = d1[0] = d1[1] = 0;
+    double ar = FIELD_REF_RADIUS / rn;
+    double arn = ar * ar; // (a/r)^(n+2), starting at n = 0
+    for (int n = 1; n <= N; n++)
+    {
+        field_legendre_row(p0, d0, p1, d1, p2, d2, m->k[n], ct, st, n);
+        arn *= ar;
+        field_series_row(Sr, St, Sp, p0, d0, m->g[n], m->h[n], cm, sm, jcm, jsm, arn, n);
+        double *t = p2;
+        p2 = p1;
+        p1 = p0;
+        p0 = t;
+        t = d2;
+        d2 = d1;
+        d1 = d0;
+        d0 = t;
+    }
+    double Br = 0, Bt = 0, Bp = 0;
+    for (int j = 0; j <= N; j++)
+    {
+        Br += Sr[j];
+        Bt -= St[j];
+        Bp -= Sp[j];
+    }
+    Bp /= st;
+    // spherical to ECEF
+    double Bh = Br * st + Bt * ct; // component in the equatorial plane, along the meridian
+    B[0] = Bh * cp - Bp * sp;
+    B[1] = Bh * sp + Bp * cp;
+    B[2] = Br * ct - Bt * st;
+}
+
+double field_era(double jd)
+{
+    double era = 2 * M_PI * fmod(0.7790572732640 + 1.00273781191135448 * (jd - 2451545.0), 1.0);
+    return era < 0 ? era + 2 * M_PI : era;
+}
+
+void field_eval_eci(const field_model_t *m, const double r[3], double era, double B[3])
+{
+    double ce = cos(era), se = sin(era);
+    double re[3] = {ce * r[0] + se * r[1], -se * r[0] + ce * r[1], r[2]};
+    double Be[3];
+    if (m->grid == NULL || !field_grid_eval(m->grid, re, Be))
+        field_eval_ecef(m, re, Be);
+    B[0] = ce * Be[0] - se * Be[1];
+    B[1] = se * Be[0] + ce * Be[1];
+    B[2] = Be[2];
+}
+
+int field_grid_build(field_model_t *m, double r_min, double r_max, int nr, double step)
+{
+    field_grid_free(m);
+    field_grid_t *grid = (field_grid_t *)malloc(sizeof(field_grid_t));
+    if (grid == NULL)
+        return -1;
+    grid->nr = nr < 2 ? 2 : nr;
+    grid->nt = (int)ceil(M_PI / step) + 1;
+    grid->np = (int)ceil(2 * M_PI / step) + 1; // includes 2 pi, so the last cell needs no wrap
+    grid->r0 = r_min;
+    grid->dr = (r_max - r_min) / (grid->nr - 1);
+    grid->dt = M_PI / (grid->nt - 1);
+    grid->dp = 2 * M_PI / (grid->np - 1);
+    grid->B = (float *)malloc((size_t)grid->nr * grid->nt * grid->np * 3 * sizeof(float));
+    if (grid->B == NULL)
+    {
+        perror("[FIELD] Grid alloc failed");
+        free(grid);
+        return -1;
+    }
+    float *b = grid->B;
+    for (int i = 0; i < grid->nr; i++)
+        for (int j = 0; j < grid->nt; j++)
+            for (int k = 0; k < grid->np; k++, b += 3)
+            {
+                double rr = grid->r0 + i * grid->dr, th = j * grid->dt, ph = k * grid->dp;
+                double pos[3] = {rr * sin(th) * cos(ph), rr * sin(th) * sin(ph), rr * cos(th)};
+                double Bv[3];
+                field_eval_ecef(m, pos, Bv);
+                b[0] = Bv[0];
+                b[1] = Bv[1];
+                b[2] = Bv[2];
+            }
+    m->grid = grid;
+    return 1;
+}
+
+int field_grid_eval(const field_grid_t *grid, const double r[3], double B[3])
+{
+    double rn = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+    double fr = (rn - grid->r0) / grid->dr;
+    if (fr < 0 || fr > grid->nr - 1)
+        return 0;
+    double ft = acos(r[2] / rn) / grid->dt;
+    double ph = atan2(r[1], r[0]);
+    double fp = (ph < 0 ? ph + 2 * M_PI : ph) / grid->dp;
+    int i = (int)fr, j = (int)ft, k = (int)fp;
+    i = i > grid->nr - 2 ? grid->nr - 2 : i;
+    j = j > grid->nt - 2 ? grid->nt - 2 : j;
+    k = k > grid->np - 2 ? grid->np - 2 : k;
+    double ur = fr - i, ut = ft - j, up = fp - k;
+    int sj = grid->np * 3, si = grid->nt * sj; // strides
+    const float *c = grid->B + i * si + j * sj + k * 3;
+    for (int a = 0; a < 3; a++)
+    {
+        double c00 = c[a] * (1 - up) + c[a + 3] * up;
+        double c01 = c[a + sj] * (1 - up) + c[a + sj + 3] * up;
+        double c10 = c[a + si] * (1 - up) + c[a + si + 3] * up;
+        double c11 = c[a + si + sj] * (1 - up) + c[a + si + sj + 3] * up;
+        double c0 = c00 * (1 - ut) + c01 * ut;
+        double c1 = c10 * (1 - ut) + c11 * ut;
+        B[a] = c0 * (1 - ur) + c1 * ur;
+    }
+    return 1;
+}
+
+void field_grid_free(field_model_t *m)
+{
+    if (m->grid == NULL)
+        return;
+    free(m->grid->B);
+    free(m->grid);
+    m->grid = NULL;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file magfield.h
+ * @brief Geomagnetic field model: spherical harmonic expansion up to FIELD_MAX_DEGREE
+ * (tilted dipole at degree 1), with an optional precomputed lookup grid.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __MAGFIELD_H
+#define __MAGFIELD_H
+
+#ifndef FIELD_MAX_DEGREE
+/**
+ * @brief Highest degree supported by the field model, sizes the coefficient and recursion tables.
+ *
+ */
+#define FIELD_MAX_DEGREE 13
+#endif
+
+/**
+ * @brief Reference radius of the geomagnetic field expansion (km).
+ *
+ */
+#define FIELD_REF_RADIUS 6371.2
+/**
+ * @brief Rotation rate of the Earth (rad s^-1).
+ *
+ */
+#define EARTH_ROTATION_RATE 7.2921150e-5
+
+#ifndef FIELD_COEF_FILE
+/**
+ * @brief Default coefficient file loaded by the simulator.
+ *
+ */
+#define FIELD_COEF_FILE "igrf13.coef"
+#endif
+
+/**
+ * @brief Lookup grid of the field in a spherical shell, in ECEF components, interpolated trilinearly.
+ *
+ */
+typedef struct
+{
+    int nr, nt, np;             // number of nodes in radius, colatitude and longitude
+    double r0, dr;              // first radius and radius spacing (km)
+    double dt, dp;              // colatitude and longitude spacing (rad)
+    float *B;                   // nr * nt * np * 3 field values (nT)
+} field_grid_t;
+
+/**
+ * @brief Field model. All tables are sized at compile time, so evaluation never allocates.
+ *
+ */
+typedef struct
+{
+    /**
+     * @brief Degree of the expansion in use
+     *
+     */
+    int nmax;
+    /**
+     * @brief Gauss coefficients converted to Gauss normalization, [n][m] (nT)
+     *
+     */
+    double g[FIELD_MAX_DEGREE + 1][FIELD_MAX_DEGREE + 1];
+    double h[FIELD_MAX_DEGREE + 1][FIELD_MAX_DEGREE + 1];
+    /**
+     * @brief Recursion constants of the associated Legendre functions, [n][m]
+     *
+     */
+    double k[FIELD_MAX_DEGREE + 1][FIELD_MAX_DEGREE + 1];
+    /**
+     * @brief Optional lookup grid, NULL to evaluate the expansion directly
+     *
+     */
+    field_grid_t *grid;
+} field_model_t;
+
+/**
+ * @brief Initializes the model as the IGRF-13 (2020.0) tilted dipole, used when no coefficient file is available.
+ *
+ * @param m Field model
+ */
+void field_dipole(field_model_t *m);
+
+/**
+ * @brief Loads Schmidt semi-normalized Gauss coefficients from a file with one "n m g h" entry per line.
+ * Lines starting with '#' are ignored, as are entries above the requested degree.
+ *
+ * @param m Field model
+ * @param path Coefficient file
+ * @param nmax Highest degree to use, at most FIELD_MAX_DEGREE
+ * @return int Degree loaded on success, -1 if the file could not be read
+ */
+int field_load(field_model_t *m, const char *path, int nmax);
+
+/**
+ * @brief Evaluates the spherical harmonic expansion.
+ *
+ * @param m Field model
+ * @param r Position in the Earth-centered Earth-fixed frame (km)
+ * @param B Field in the Earth-centered Earth-fixed frame (nT)
+ */
+void field_eval_ecef(const field_model_t *m, const double r[3], double B[3]);
+
+/**
+ * @brief Evaluates the field in the inertial frame, using the lookup grid if one is built and
+ * the position lies inside it.
+ *
+ * @param m Field model
+ * @param r Position in the Earth-centered inertial frame (km)
+ * @param era Earth rotation angle (rad), see field_era()
+ * @param B Field in the Earth-centered inertial frame (nT)
+ */
+void field_eval_eci(const field_model_t *m, const double r[3], double era, double B[3]);
+
+/**
+ * @brief Calculates the Earth rotation angle, the angle between the inertial and Earth-fixed frames.
+ *
+ * @param jd Julian date (UT1)
+ * @return double Earth rotation angle (rad)
+ */
+double field_era(double jd);
+
+/**
+ * @brief Precomputes the field on a grid in the shell r_min...r_max for trilinear interpolation,
+ * and attaches it to the model.
+ *
+ * @param m Field model
+ * @param r_min Inner radius of the shell (km)
+ * @param r_max Outer radius of the shell (km)
+ * @param nr Number of radial nodes, at least 2
+ * @param step Angular spacing in colatitude and longitude (rad)
+ * @return int 1 on success, -1 if the grid could not be allocated
+ */
+int field_grid_build(field_model_t *m, double r_min, double r_max, int nr, double step);
+
+/**
+ * @brief Interpolates the lookup grid.
+ *
+ * @param grid Lookup grid
+ * @param r Position in the Earth-centered Earth-fixed frame (km)
+ * @param B Field in the Earth-centered Earth-fixed frame (nT)
+ * @return int 1 if the position lies in the grid, 0 otherwise (B is untouched)
+ */
+int field_grid_eval(const field_grid_t *grid, const double r[3], double B[3]);
+
+/**
+ * @brief Frees the lookup grid attached to the model.
+ *
+ * @param m Field model
+ */
+void field_grid_free(field_model_t *m);
+
+#endif // __MAGFIELD_H
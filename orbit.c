@@ -0,0 +1,163 @@
+/**
+ * @file orbit.c
+ * @brief Two-body + J2 orbit propagator, with a cached ephemeris mode that tabulates the
+ * orbit once and interpolates it with cubic Hermite polynomials.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <orbit.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+double orbit_period(const orbit_elements_t *el)
+{
+    return 2 * M_PI * sqrt(el->a * el->a * el->a / EARTH_MU);
+}
+
+void orbit_from_elements(orbit_state_t *s, const orbit_elements_t *el)
+{
+    // solve Kepler's equation M = E - e sin E
+    double E = el->e < 0.8 ? el->M : M_PI;
+    for (int i = 0; i < 20; i++)
+    {
+        double dE = (E - el->e * sin(E) - el->M) / (1 - el->e * cos(E));
+        E -= dE;
+        if (fabs(dE) < 1e-14)
+            break;
+    }
+    double b = el->a * sqrt(1 - el->e * el->e);
+    double rn = el->a * (1 - el->e * cos(E));
+    // perifocal frame
+    double xp = el->a * (cos(E) - el->e), yp = b * sin(E);
+    double vs = sqrt(EARTH_MU * el->a) / rn;
+    double vxp = -vs * sin(E), vyp = vs * sqrt(1 - el->e * el->e) * cos(E);
+    // rotate by argument of perigee, inclination and RAAN
+    double cO = cos(el->raan), sO = sin(el->raan);
+    double ci = cos(el->i), si = sin(el->i);
+    double cw = cos(el->argp), sw = sin(el->argp);
+    double P[3] = {cO * cw - sO * sw * ci, sO * cw + cO * sw * ci, sw * si};
+    double Q[3] = {-cO * sw - sO * cw * ci, -sO * sw + cO * cw * ci, cw * si};
+    for (int i = 0; i < 3; i++)
+    {
+        s->r[i] = xp * P[i] + yp * Q[i];
+        s->v[i] = vxp * P[i] + vyp * Q[i];
+    }
+}
+
+void orbit_accel(const double r[3], double a[3])
+{
+    double r2 = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+    double rn = sqrt(r2);
+    double mu_r3 = EARTH_MU / (r2 * rn);
+    double j2 = 1.5 * EARTH_J2 * EARTH_RADIUS * EARTH_RADIUS / r2;
+    double z2 = 5 * r[2] * r[2] / r2;
+    a[0] = -mu_r3 * r[0] * (1 + j2 * (1 - z2));
+    a[1] = -mu_r3 * r[1] * (1 + j2 * (1 - z2));
+    a[2] = -mu_r3 * r[2] * (1 + j2 * (3 - z2));
+}
+
+/**
+ * @brief Advances the state by one 4th order Runge-Kutta step.
+ *
+ * @param s State, updated in place
+ * @param h Step size (s)
+ */
+static void orbit_rk4(orbit_state_t *s, double h)
+{
+    double r[3], v[3], k1r[3], k1v[3], k2r[3], k2v[3], k3r[3], k3v[3], k4r[3], k4v[3];
+    for (int i = 0; i < 3; i++)
+        k1r[i] = s->v[i];
+    orbit_accel(s->r, k1v);
+    for (int i = 0; i < 3; i++)
+    {
+        r[i] = s->r[i] + 0.5 * h * k1r[i];
+        v[i] = s->v[i] + 0.5 * h * k1v[i];
+        k2r[i] = v[i];
+    }
+    orbit_accel(r, k2v);
+    for (int i = 0; i < 3; i++)
+    {
+        r[i] = s->r[i] + 0.5 * h * k2r[i];
+        v[i] = s->v[i] + 0.5 * h * k2v[i];
+        k3r[i] = v[i];
+    }
+    orbit_accel(r, k3v);
+    for (int i = 0; i < 3; i++)
+    {
+        r[i] = s->r[i] + h * k3r[i];
+        v[i] = s->v[i] + h * k3v[i];
+        k4r[i] = v[i];
+    }
+    orbit_accel(r, k4v);
+    for (int i = 0; i < 3; i++)
+    {
+        s->r[i] += h / 6.0 * (k1r[i] + 2 * k2r[i] + 2 * k3r[i] + k4r[i]);
+        s->v[i] += h / 6.0 * (k1v[i] + 2 * k2v[i] + 2 * k3v[i] + k4v[i]);
+    }
+}
+
+void orbit_propagate(orbit_state_t *s, double dt)
+{
+    int n = (int)ceil(dt / ORBIT_STEP);
+    n = n < 1 ? 1 : n;
+    double h = dt / n;
+    for (int i = 0; i < n; i++)
+        orbit_rk4(s, h);
+}
+
+int orbit_ephem_build(orbit_ephem_t *eph, const orbit_state_t *init, double span, double dt)
+{
+    eph->dt = dt > 0 ? dt : ORBIT_EPHEM_STEP;
+    eph->span = span;
+    eph->n = (int)ceil(span / eph->dt) + 2; // one node past the end so the last interval is covered
+    eph->node = (double *)malloc(eph->n * 9 * sizeof(double));
+    if (eph->node == NULL)
+    {
+        perror("[ORBIT] Ephemeris alloc failed");
+        eph->n = 0;
+        return -1;
+    }
+    orbit_state_t s = *init;
+    for (int k = 0; k < eph->n; k++)
+    {
+        double *nd = eph->node + 9 * k;
+        for (int i = 0; i < 3; i++)
+        {
+            nd[i] = s.r[i];
+            nd[3 + i] = s.v[i];
+        }
+        orbit_accel(s.r, nd + 6);
+        orbit_propagate(&s, eph->dt);
+    }
+    return 1;
+}
+
+void orbit_ephem_eval(const orbit_ephem_t *eph, double t, orbit_state_t *s)
+{
+    t = fmod(t, eph->span);
+    t = t < 0 ? t + eph->span : t;
+    int k = (int)(t / eph->dt);
+    k = k > eph->n - 2 ? eph->n - 2 : k;
+    double u = t / eph->dt - k; // normalized time in the interval, 0...1
+    const double *n0 = eph->node + 9 * k, *n1 = n0 + 9;
+    // cubic Hermite basis
+    double u2 = u * u, u3 = u2 * u;
+    double h00 = 2 * u3 - 3 * u2 + 1, h10 = u3 - 2 * u2 + u;
+    double h01 = -2 * u3 + 3 * u2, h11 = u3 - u2;
+    double h = eph->dt;
+    for (int i = 0; i < 3; i++)
+    {
+        s->r[i] = h00 * n0[i] + h10 * h * n0[3 + i] + h01 * n1[i] + h11 * h * n1[3 + i];
+        s->v[i] = h00 * n0[3 + i] + h10 * h * n0[6 + i] + h01 * n1[3 + i] + h11 * h * n1[6 + i];
+    }
+}
+
+void orbit_ephem_free(orbit_ephem_t *eph)
+{
+    free(eph->node);
+    eph->node = NULL;
+    eph->n = 0;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file orbit.h
+ * @brief Two-body + J2 orbit propagator, with a cached ephemeris mode that tabulates the
+ * orbit once and interpolates it with cubic Hermite polynomials.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __ORBIT_H
+#define __ORBIT_H
+
+#include <math.h>
+
+/**
+ * @brief Gravitational parameter of the Earth (km^3 s^-2).
+ *
+ */
+#define EARTH_MU 398600.4418
+/**
+ * @brief Equatorial radius of the Earth (km).
+ *
+ */
+#define EARTH_RADIUS 6378.137
+/**
+ * @brief Second zonal harmonic of the Earth's gravity field.
+ *
+ */
+#define EARTH_J2 1.08262668e-3
+
+#ifndef ORBIT_STEP
+/**
+ * @brief Maximum integrator step of the orbit propagator (s).
+ *
+ */
+#define ORBIT_STEP 10.0
+#endif
+
+#ifndef ORBIT_EPHEM_STEP
+/**
+ * @brief Default node spacing of the cached ephemeris (s). Interpolation error is on the order of centimeters in LEO.
+ *
+ */
+#define ORBIT_EPHEM_STEP 30.0
+#endif
+
+/**
+ * @brief Position and velocity in the Earth-centered inertial frame.
+ *
+ */
+typedef struct
+{
+    double r[3]; // position (km)
+    double v[3]; // velocity (km s^-1)
+} orbit_state_t;
+
+/**
+ * @brief Classical orbital elements, angles in radians.
+ *
+ */
+typedef struct
+{
+    double a;    // semi-major axis (km)
+    double e;    // eccentricity
+    double i;    // inclination
+    double raan; // right ascension of the ascending node
+    double argp; // argument of perigee
+    double M;    // mean anomaly at epoch
+} orbit_elements_t;
+
+/**
+ * @brief Default orbit: 500 km, near circular, 51.6 degree inclination.
+ *
+ */
+#define ORBIT_DEFAULT_ELEMENTS                                          \
+    {                                                                   \
+        .a = EARTH_RADIUS + 500, .e = 0.001, .i = 51.6 * M_PI / 180.0, \
+        .raan = 0, .argp = 0, .M = 0                                    \
+    }
+
+/**
+ * @brief Orbit tabulated at equally spaced nodes. The table is read-only once built,
+ * so a single table can be shared by any number of simulations (threads, or processes after fork()).
+ *
+ */
+typedef struct
+{
+    double dt;   // node spacing (s)
+    double span; // time covered by the table (s), evaluation wraps around after this
+    int n;       // number of nodes, n * dt > span
+    /**
+     * @brief Position, velocity and acceleration at each node, 9 doubles per node.
+     *
+     */
+    double *node;
+} orbit_ephem_t;
+
+/**
+ * @brief Calculates the orbital period of the osculating two-body orbit.
+ *
+ * @param el Orbital elements
+ * @return double Period (s)
+ */
+double orbit_period(const orbit_elements_t *el);
+
+/**
+ * @brief Converts orbital elements to an inertial position and velocity.
+ *
+ * @param s Output state
+ * @param el Orbital elements
+ */
+void orbit_from_elements(orbit_state_t *s, const orbit_elements_t *el);
+
+/**
+ * @brief Calculates the two-body + J2 gravitational acceleration.
+ *
+ * @param r Position (km)
+ * @param a Acceleration (km s^-2)
+ */
+void orbit_accel(const double r[3], double a[3]);
+
+/**
+ * @brief Advances the state by dt with 4th order Runge-Kutta steps no longer than ORBIT_STEP.
+ *
+ * @param s State, updated in place
+ * @param dt Time to advance (s)
+ */
+void orbit_propagate(orbit_state_t *s, double dt);
+
+/**
+ * @brief Tabulates the orbit starting from the initial state. This is the only call that allocates.
+ *
+ * @param eph Ephemeris to build
+ * @param init State at t = 0
+ * @param span Time to cover (s), usually one orbital period
+ * @param dt Node spacing (s), ORBIT_EPHEM_STEP if <= 0
+ * @return int 1 on success, -1 if the table could not be allocated
+ */
+int orbit_ephem_build(orbit_ephem_t *eph, const orbit_state_t *init, double span, double dt);
+
+/**
+ * @brief Interpolates the tabulated orbit. Position uses the node velocities and velocity uses the node
+ * accelerations as Hermite tangents. Times beyond the span wrap around, which ignores the secular
+ * J2 drift between revolutions.
+ *
+ * @param eph Ephemeris
+ * @param t Time since the start of the table (s)
+ * @param s Output state
+ */
+void orbit_ephem_eval(const orbit_ephem_t *eph, double t, orbit_state_t *s);
+
+/**
+ * @brief Frees the memory held by an ephemeris.
+ *
+ * @param eph Ephemeris
+ */
+void orbit_ephem_free(orbit_ephem_t *eph);
+
+#endif // __ORBIT_H
@@ -0,0 +1,29 @@
+/**
+ * @file ring.c
+ * @brief Span consumers of the circular buffers. Out of line, so that the pairwise sums are compiled against
+ * the spans rather than against the declared size of each buffer.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <ring.h>
+
+double ring_daverage(const ring_t *r, const double arr[], uint32_t n)
+{
+    uint32_t start, len = ring_span(r, n, &start);
+    double sum = dsum(arr + start, len);
+    if (len < n) // wrapped around the end of the storage
+        sum += dsum(arr, n - len);
+    return sum / n;
+}
+
+float ring_faverage(const ring_t *r, const float arr[], uint32_t n)
+{
+    uint32_t start, len = ring_span(r, n, &start);
+    float sum = fsum(arr + start, len);
+    if (len < n)
+        sum += fsum(arr, n - len);
+    return sum / n;
+}
@@ -0,0 +1,238 @@
+/**
+ * @file ring.h
+ * @brief Position of a circular buffer of power-of-two capacity, kept apart from the typed storage: the index
+ * of the newest sample wraps by masking, samples k back are one subtraction and a mask away, and the newest
+ * samples can be viewed as at most two contiguous spans for the array kernels. The capacity is chosen at
+ * runtime and the storage carved out of the arena of the simulation (arena.h).
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __RING_H
+#define __RING_H
+
+#include <stdint.h>
+#include <string.h>
+#include "macros.h"
+#include "arena.h"
+
+/**
+ * @brief Position of a circular buffer.
+ *
+ */
+typedef struct
+{
+    uint32_t head;  // index of the newest sample
+    uint32_t mask;  // capacity - 1, the capacity is a power of 2
+    uint64_t count; // samples pushed since the last reset
+} ring_t;
+
+/**
+ * @brief Initializer of an empty ring of a power-of-two capacity.
+ *
+ */
+#define RING_INITIALIZER(capacity) {(capacity) - 1, (capacity) - 1, 0}
+
+/**
+ * @brief Smallest power of two not less than n, the capacity of a ring that holds n samples.
+ *
+ * @param n Number of samples, at least 1
+ * @return uint32_t Capacity
+ */
+static inline uint32_t ring_capacity(uint32_t n)
+{
+    return n <= 1 ? 1 : 1U << (32 - __builtin_clz(n - 1));
+}
+
+/**
+ * @brief Empties a ring; the next push writes index 0.
+ *
+ * @param r Ring
+ * @param capacity Capacity, a power of 2
+ */
+static inline void ring_reset(ring_t *r, uint32_t capacity)
+{
+    r->mask = capacity - 1;
+    r->head = r->mask;
+    r->count = 0;
+}
+
+/**
+ * @brief Advances a ring to the slot of a new sample.
+ *
+ * @param r Ring
+ * @return uint32_t Index of the new sample
+ */
+static inline uint32_t ring_push(ring_t *r)
+{
+    r->head = (r->head + 1) & r->mask;
+    r->count++;
+    return r->head;
+}
+
+/**
+ * @brief Index of the sample k samples before the newest, k = 0 for the newest. Valid for k below the capacity;
+ * the slots of samples not yet pushed hold whatever the buffer was flushed with.
+ *
+ * @param r Ring
+ * @param k Samples back
+ * @return uint32_t Index
+ */
+static inline uint32_t ring_back(const ring_t *r, uint32_t k)
+{
+    return (r->head - k) & r->mask;
+}
+
+/**
+ * @brief Views the n newest samples, oldest first, as the contiguous spans [start, start + len) and [0, n - len).
+ * The second span is empty unless the samples wrap around the end of the storage.
+ *
+ * @param r Ring
+ * @param n Number of samples, at most the capacity
+ * @param start Index of the oldest sample
+ * @return uint32_t Length len of the first span
+ */
+static inline uint32_t ring_span(const ring_t *r, uint32_t n, uint32_t *start)
+{
+    *start = (r->head + 1 - n) & r->mask;
+    uint32_t room = r->mask + 1 - *start; // samples from start to the end of the storage
+    return n < room ? n : room;
+}
+
+/**
+ * @brief Declares a vector buffer of a capacity chosen at runtime, and its position name_ring: the pointers
+ * x_name, y_name and z_name, indexed as arrays once RING_ALLOC() has carved them out of an arena.
+ *
+ * @param name Name of the buffer
+ * @param type Data type of the buffer
+ */
+#define DECLARE_RING(name, type)              \
+    type *x_##name, *y_##name, *z_##name;     \
+    ring_t name##_ring = RING_INITIALIZER(1)
+
+/**
+ * @brief Carves the three axes of a vector buffer of pointers (see DECLARE_RING()) out of an arena, zeroed and
+ * cache-aligned.
+ *
+ * @param arena Arena
+ * @param name Name of the buffer
+ * @param capacity Elements per axis
+ * @return Nonzero on success
+ */
+#define ARENA_BUFFER(arena, name, capacity)                                                   \
+    ((x_##name = arena_alloc(arena, (size_t)(capacity) * sizeof(*x_##name))) != NULL &&      \
+     (y_##name = arena_alloc(arena, (size_t)(capacity) * sizeof(*y_##name))) != NULL &&      \
+     (z_##name = arena_alloc(arena, (size_t)(capacity) * sizeof(*z_##name))) != NULL)
+
+/**
+ * @brief Carves a buffer declared using DECLARE_RING() out of an arena and empties it.
+ *
+ * @param arena Arena
+ * @param name Name of the buffer
+ * @param capacity Capacity, a power of 2
+ * @return Nonzero on success
+ */
+#define RING_ALLOC(arena, name, capacity) (ring_reset(&name##_ring, capacity), ARENA_BUFFER(arena, name, capacity))
+
+/**
+ * @brief Bytes a buffer of the given type and capacity takes in an arena, to size the arena.
+ *
+ */
+#define RING_ARENA_SIZE(type, capacity) (3 * arena_round((size_t)(capacity) * sizeof(type)))
+
+/**
+ * @brief Zeroes the first size elements of the axes of a vector buffer of pointers.
+ *
+ */
+#define FLUSH_BUFFER_SIZE(name, size)                         \
+    do                                                        \
+    {                                                         \
+        memset(x_##name, 0, (size_t)(size) * sizeof(*x_##name)); \
+        memset(y_##name, 0, (size_t)(size) * sizeof(*y_##name)); \
+        memset(z_##name, 0, (size_t)(size) * sizeof(*z_##name)); \
+    } while (0)
+
+/**
+ * @brief Capacity of a buffer declared using DECLARE_RING().
+ *
+ */
+#define RING_CAPACITY(name) (name##_ring.mask + 1)
+
+/**
+ * @brief Index of the newest sample of a buffer declared using DECLARE_RING().
+ *
+ */
+#define RING_HEAD(name) ((int)name##_ring.head)
+
+/**
+ * @brief Index of the sample k samples before the newest of a buffer declared using DECLARE_RING().
+ *
+ */
+#define RING_BACK(name, k) ((int)ring_back(&name##_ring, k))
+
+/**
+ * @brief Advances a buffer declared using DECLARE_RING() to the slot of a new sample, and returns its index.
+ *
+ */
+#define RING_PUSH(name) ((int)ring_push(&name##_ring))
+
+/**
+ * @brief Samples pushed into a buffer declared using DECLARE_RING() since the last reset.
+ *
+ */
+#define RING_COUNT(name) (name##_ring.count)
+
+/**
+ * @brief Flushes a buffer declared using DECLARE_RING() and empties it, keeping its capacity.
+ *
+ */
+#define RING_RESET(name)                                      \
+    do                                                        \
+    {                                                         \
+        FLUSH_BUFFER_SIZE(name, RING_CAPACITY(name));         \
+        ring_reset(&name##_ring, RING_CAPACITY(name));        \
+    } while (0)
+
+/**
+ * @brief Average of the n newest samples of one axis of a ring, summed pairwise (see dsum()) over its contiguous
+ * spans.
+ *
+ * @param r Ring
+ * @param arr Axis of the buffer
+ * @param n Number of samples, 1 to the capacity
+ * @return double Average
+ */
+double ring_daverage(const ring_t *r, const double arr[], uint32_t n);
+
+/**
+ * @brief Average of the n newest samples of one axis of a ring, see ring_daverage().
+ *
+ */
+float ring_faverage(const ring_t *r, const float arr[], uint32_t n);
+
+/**
+ * @brief Calculates the double precision average of the n newest samples of a buffer declared using
+ * DECLARE_RING(), the ring counterpart of DAVERAGE_BUFFER().
+ *
+ * @param dest Output vector, declared using DECLARE_VECTOR()
+ * @param name Buffer
+ * @param n Number of samples, at most the capacity
+ */
+#define RING_DAVERAGE(dest, name, n)                            \
+    x_##dest = ring_daverage(&name##_ring, x_##name, n);        \
+    y_##dest = ring_daverage(&name##_ring, y_##name, n);        \
+    z_##dest = ring_daverage(&name##_ring, z_##name, n)
+
+/**
+ * @brief Calculates the 32-bit float average of the n newest samples of a buffer declared using DECLARE_RING(),
+ * the ring counterpart of FAVERAGE_BUFFER().
+ *
+ */
+#define RING_FAVERAGE(dest, name, n)                            \
+    x_##dest = ring_faverage(&name##_ring, x_##name, n);        \
+    y_##dest = ring_faverage(&name##_ring, y_##name, n);        \
+    z_##dest = ring_faverage(&name##_ring, z_##name, n)
+
+#endif // __RING_H
@@ -0,0 +1,53 @@
+/**
+ * @file sensorsched.c
+ * @brief Multi-rate sensor scheduler. Decides on which ACS ticks a sensor samples, and when
+ * the sample becomes available to the control loop after the sensor latency.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <sensorsched.h>
+#include <stdio.h>
+
+void sensorsched_init(sensorsched_t *s, uint32_t period, uint32_t latency, uint64_t t0)
+{
+    s->period = period > 0 ? period : 1;
+    if (latency > s->period) // one sample in flight at a time, a longer latency would skip samples
+    {
+        fprintf(stderr, "[SENSOR] Latency %u usec capped at the period, %u usec\n", latency, s->period);
+        latency = s->period;
+    }
+    s->latency = latency;
+    s->next = t0;
+    s->taken = 0;
+    s->stamp = 0;
+    s->stamp_prev = 0;
+    s->pending = 0;
+    s->count = 0;
+}
+
+int sensorsched_sample(sensorsched_t *s, uint64_t tnow)
+{
+    if (tnow < s->next)
+        return 0;
+    // schedule the next sample on the sensor's own grid, dropping any missed in between
+    s->next += ((tnow - s->next) / s->period + 1) * s->period;
+    if (s->pending) // previous sample still in flight
+        return 0;
+    s->taken = tnow;
+    s->pending = 1;
+    return 1;
+}
+
+int sensorsched_deliver(sensorsched_t *s, uint64_t tnow)
+{
+    if (!s->pending || tnow < s->taken + s->latency)
+        return 0;
+    s->pending = 0;
+    s->stamp_prev = s->stamp;
+    s->stamp = s->taken;
+    s->count++;
+    return 1;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file sensorsched.h
+ * @brief Multi-rate sensor scheduler. Decides on which ACS ticks a sensor samples, and when
+ * the sample becomes available to the control loop after the sensor latency.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __SENSORSCHED_H
+#define __SENSORSCHED_H
+
+#include <stdint.h>
+
+/**
+ * @brief Schedule of one sensor. Each sensor has a single sample in flight: a sample is taken
+ * when the sensor is due and its pipeline is free, and delivered latency usec later.
+ *
+ */
+typedef struct
+{
+    /**
+     * @brief Sampling period (usec)
+     *
+     */
+    uint32_t period;
+    /**
+     * @brief Delay between taking a sample and the sample being available (usec)
+     *
+     */
+    uint32_t latency;
+    /**
+     * @brief Time at which the next sample is due (usec)
+     *
+     */
+    uint64_t next;
+    /**
+     * @brief Time at which the sample in flight was taken (usec)
+     *
+     */
+    uint64_t taken;
+    /**
+     * @brief Time at which the latest delivered sample was taken (usec)
+     *
+     */
+    uint64_t stamp;
+    /**
+     * @brief Time at which the previous delivered sample was taken (usec)
+     *
+     */
+    uint64_t stamp_prev;
+    /**
+     * @brief Indicates a sample in flight
+     *
+     */
+    int pending;
+    /**
+     * @brief Number of samples delivered
+     *
+     */
+    uint64_t count;
+} sensorsched_t;
+
+/**
+ * @brief Initializes the schedule of a sensor.
+ *
+ * @param s Sensor schedule
+ * @param period Sampling period (usec)
+ * @param latency Delay from sampling to availability (usec), capped at one period with a warning. One sample is in
+ * flight at a time and a tick samples before it delivers, so a latency that reaches the next sampling tick skips
+ * that sample.
+ * @param t0 Time of the first sample (usec)
+ */
+void sensorsched_init(sensorsched_t *s, uint32_t period, uint32_t latency, uint64_t t0);
+
+/**
+ * @brief Checks if the sensor takes a sample at this tick. If it does, the sensor model must be
+ * evaluated and its output held until sensorsched_deliver() returns 1. Due samples that would
+ * find the pipeline busy are skipped.
+ *
+ * @param s Sensor schedule
+ * @param tnow Time of this tick (usec)
+ * @return int 1 if the sensor samples now, 0 if the sensor model can be skipped
+ */
+int sensorsched_sample(sensorsched_t *s, uint64_t tnow);
+
+/**
+ * @brief Checks if the sample in flight becomes available at this tick.
+ *
+ * @param s Sensor schedule
+ * @param tnow Time of this tick (usec)
+ * @return int 1 if the held sample is delivered now, 0 otherwise
+ */
+int sensorsched_deliver(sensorsched_t *s, uint64_t tnow);
+
+/**
+ * @brief Age of the latest delivered sample.
+ *
+ * @param s Sensor schedule
+ * @param tnow Current time (usec)
+ * @return uint64_t Time since the latest delivered sample was taken (usec), UINT64_MAX if none was delivered
+ */
+static inline uint64_t sensorsched_age(const sensorsched_t *s, uint64_t tnow)
+{
+    return s->count > 0 ? tnow - s->stamp : UINT64_MAX;
+}
+
+#endif // __SENSORSCHED_H
@@ -0,0 +1,174 @@
+/**
+ * @file sun.c
+ * @brief Low-precision sun ephemeris and Earth shadow model, with eclipse entry and exit
+ * times cached one orbit at a time.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <sun.h>
+#include <stdlib.h>
+
+void sun_position(double jd, double r[3])
+{
+    double n = jd - 2451545.0;
+    double L = (280.460 + 0.9856474 * n) * M_PI / 180; // mean longitude
+    double g = (357.528 + 0.9856003 * n) * M_PI / 180; // mean anomaly
+    double lambda = L + (1.915 * sin(g) + 0.020 * sin(2 * g)) * M_PI / 180; // ecliptic longitude
+    double eps = (23.439 - 4.0e-7 * n) * M_PI / 180;                         // obliquity of the ecliptic
+    double R = (1.00014 - 0.01671 * cos(g) - 0.00014 * cos(2 * g)) * SUN_AU;
+    r[0] = R * cos(lambda);
+    r[1] = R * cos(eps) * sin(lambda);
+    r[2] = R * sin(eps) * sin(lambda);
+}
+
+/**
+ * @brief Apparent radii of the sun and the Earth, and their separation, seen from a position.
+ *
+ * @param r Position in the inertial frame (km)
+ * @param r_sun Position of the sun in the inertial frame (km)
+ * @param a Apparent radius of the sun (rad)
+ * @param b Apparent radius of the Earth (rad)
+ * @param c Angle between the centers of the sun and the Earth (rad)
+ */
+static void sun_disks(const double r[3], const double r_sun[3], double *a, double *b, double *c)
+{
+    double d[3] = {r_sun[0] - r[0], r_sun[1] - r[1], r_sun[2] - r[2]};
+    double rn = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+    double dn = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    double cc = -(r[0] * d[0] + r[1] * d[1] + r[2] * d[2]) / (rn * dn);
+    *a = asin(SUN_RADIUS / dn);
+    *b = asin(EARTH_RADIUS / rn);
+    *c = acos(cc > 1 ? 1 : (cc < -1 ? -1 : cc));
+}
+
+/**
+ * @brief Shadow function: positive in full sun, negative in (partial) shadow, and continuous across
+ * the shadow boundary so its roots can be bracketed.
+ *
+ * @param r Position in the inertial frame (km)
+ * @param r_sun Position of the sun in the inertial frame (km)
+ * @param s Sun direction in the inertial frame (unit vector)
+ * @param model Shadow model
+ * @return double Distance (km, cylindrical) or angle (rad, conical) from the shadow boundary
+ */
+static double sun_margin(const double r[3], const double r_sun[3], const double s[3], sun_shadow_model model)
+{
+    if (model == SUN_SHADOW_CONICAL)
+    {
+        double a, b, c;
+        sun_disks(r, r_sun, &a, &b, &c);
+        return c - (a + b);
+    }
+    double d = r[0] * s[0] + r[1] * s[1] + r[2] * s[2];
+    double r2 = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+    if (d >= 0) // sun side
+        return sqrt(r2);
+    return sqrt(r2 - d * d) - EARTH_RADIUS; // distance from the shadow cylinder
+}
+
+double sun_shadow(const double r[3], const double r_sun[3], sun_shadow_model model)
+{
+    if (model == SUN_SHADOW_CYLINDRICAL)
+    {
+        double sn = sqrt(r_sun[0] * r_sun[0] + r_sun[1] * r_sun[1] + r_sun[2] * r_sun[2]);
+        double s[3] = {r_sun[0] / sn, r_sun[1] / sn, r_sun[2] / sn};
+        return sun_margin(r, r_sun, s, model) < 0 ? 0 : 1;
+    }
+    double a, b, c;
+    sun_disks(r, r_sun, &a, &b, &c);
+    if (c >= a + b) // no overlap
+        return 1;
+    if (c < b - a) // umbra
+        return 0;
+    if (c < a - b) // annular, the Earth inside the solar disk
+        return 1 - b * b / (a * a);
+    // partial overlap of the two disks
+    double x = (c * c + a * a - b * b) / (2 * c);
+    double y = sqrt(a * a - x * x);
+    double A = a * a * acos(x / a) + b * b * acos((c - x) / b) - c * y;
+    return 1 - A / (M_PI * a * a);
+}
+
+/**
+ * @brief Advances an orbit state by h, from the ephemeris if there is one.
+ *
+ * @param st State at time t, updated in place
+ * @param eph Cached ephemeris, or NULL
+ * @param t Time of the state (s)
+ * @param h Step (s)
+ */
+static inline void sun_orbit_step(orbit_state_t *st, const orbit_ephem_t *eph, double t, double h)
+{
+    if (eph != NULL)
+        orbit_ephem_eval(eph, t + h, st);
+    else
+        orbit_propagate(st, h);
+}
+
+void sun_eclipse_predict(sun_eclipse_t *ec, const orbit_state_t *s, const orbit_ephem_t *eph, double t, double span, double jd, sun_shadow_model model)
+{
+    sun_position(jd, ec->r_sun);
+    double sn = sqrt(ec->r_sun[0] * ec->r_sun[0] + ec->r_sun[1] * ec->r_sun[1] + ec->r_sun[2] * ec->r_sun[2]);
+    for (int i = 0; i < 3; i++)
+        ec->s[i] = ec->r_sun[i] / sn;
+    ec->model = model;
+
+    orbit_state_t cur = *s;
+    double tc = t, t_lim = t + span;
+    double fc = sun_margin(cur.r, ec->r_sun, ec->s, model);
+    int entered = fc < 0, exited = 0;
+    ec->entry = t;
+    while (tc < t_lim)
+    {
+        double h = t_lim - tc < SUN_SCAN_STEP ? t_lim - tc : SUN_SCAN_STEP;
+        orbit_state_t next = cur;
+        sun_orbit_step(&next, eph, tc, h);
+        double fn = sun_margin(next.r, ec->r_sun, ec->s, model);
+        if ((fn < 0) != (fc < 0)) // boundary crossed in this step, bisect
+        {
+            double lo = 0, hi = h;
+            while (hi - lo > SUN_EVENT_TOL)
+            {
+                double mid = 0.5 * (lo + hi);
+                orbit_state_t tmp = cur;
+                sun_orbit_step(&tmp, eph, tc, mid);
+                if ((sun_margin(tmp.r, ec->r_sun, ec->s, model) < 0) == (fc < 0))
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            if (fc >= 0) // entry, follow the eclipse until it ends
+            {
+                entered = 1;
+                ec->entry = tc + hi;
+                t_lim = ec->entry + span;
+            }
+            else // exit, the prediction ends here
+            {
+                ec->exit = tc + hi;
+                exited = 1;
+                break;
+            }
+        }
+        cur = next;
+        tc += h;
+        fc = fn;
+    }
+    if (!entered) // no eclipse in this span
+        ec->entry = ec->exit = t_lim;
+    else if (!exited)
+        ec->exit = t_lim;
+    ec->t_end = ec->exit;
+}
+
+double sun_illumination(const sun_eclipse_t *ec, const double r[3], double t)
+{
+    if (t < ec->entry || t >= ec->exit)
+        return 1;
+    if (ec->model == SUN_SHADOW_CYLINDRICAL)
+        return 0;
+    return sun_shadow(r, ec->r_sun, ec->model);
+}
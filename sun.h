@@ -0,0 +1,112 @@
+/**
+ * @file sun.h
+ * @brief Low-precision sun ephemeris and Earth shadow model, with eclipse entry and exit
+ * times cached one orbit at a time.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __SUN_H
+#define __SUN_H
+
+#include <orbit.h>
+
+/**
+ * @brief Astronomical unit (km).
+ *
+ */
+#define SUN_AU 149597870.7
+/**
+ * @brief Radius of the sun (km).
+ *
+ */
+#define SUN_RADIUS 696000.0
+
+#ifndef SUN_SCAN_STEP
+/**
+ * @brief Step of the shadow function scan used to bracket eclipse entry and exit (s).
+ * Eclipses shorter than this may be missed.
+ *
+ */
+#define SUN_SCAN_STEP 30.0
+#endif
+
+#ifndef SUN_EVENT_TOL
+/**
+ * @brief Tolerance of the eclipse entry and exit times (s).
+ *
+ */
+#define SUN_EVENT_TOL 0.01
+#endif
+
+/**
+ * @brief Earth shadow models.
+ *
+ */
+typedef enum
+{
+    SUN_SHADOW_CYLINDRICAL = 0, // sharp shadow cylinder of Earth radius, no penumbra
+    SUN_SHADOW_CONICAL,         // umbra and penumbra cones, with partial illumination in the penumbra
+} sun_shadow_model;
+
+/**
+ * @brief Cached eclipse prediction. Covers the simulation times up to t_end, with at most one
+ * eclipse [entry, exit) in that interval; the sun is held fixed over the interval.
+ *
+ */
+typedef struct
+{
+    double t_end;           // end of the interval covered by this prediction (s)
+    double entry, exit;     // eclipse entry and exit times (s), both t_end if there is no eclipse
+    double r_sun[3];        // position of the sun in the inertial frame (km)
+    double s[3];            // sun direction in the inertial frame (unit vector)
+    sun_shadow_model model; // shadow model used in the prediction
+} sun_eclipse_t;
+
+/**
+ * @brief Calculates the position of the sun, to about 0.01 degrees over 1950-2050 (Astronomical Almanac low precision formulae).
+ *
+ * @param jd Julian date
+ * @param r Position of the sun in the Earth-centered inertial frame (km)
+ */
+void sun_position(double jd, double r[3]);
+
+/**
+ * @brief Calculates the fraction of the solar disk visible from a position.
+ *
+ * @param r Position in the inertial frame (km)
+ * @param r_sun Position of the sun in the inertial frame (km)
+ * @param model Shadow model
+ * @return double Illumination, 0 (umbra) ... 1 (full sun)
+ */
+double sun_shadow(const double r[3], const double r_sun[3], sun_shadow_model model);
+
+/**
+ * @brief Predicts the next eclipse, scanning the orbit forward from time t for up to one span, and
+ * locating entry and exit by bisection. The prediction ends at the eclipse exit, or after one span
+ * if there is no eclipse, and is redone when the simulation passes t_end.
+ *
+ * @param ec Eclipse prediction
+ * @param s Orbit state at time t
+ * @param eph Cached ephemeris to look the orbit up in, NULL to propagate a copy of s instead
+ * @param t Simulation time (s)
+ * @param span Length of the scan, usually the orbit period (s)
+ * @param jd Julian date at time t
+ * @param model Shadow model
+ */
+void sun_eclipse_predict(sun_eclipse_t *ec, const orbit_state_t *s, const orbit_ephem_t *eph, double t, double span, double jd, sun_shadow_model model);
+
+/**
+ * @brief Looks up the illumination in a cached prediction. Only evaluates the shadow model inside
+ * the eclipse window, and only for the conical model.
+ *
+ * @param ec Eclipse prediction covering t
+ * @param r Position in the inertial frame at time t (km)
+ * @param t Simulation time (s)
+ * @return double Illumination, 0 (umbra) ... 1 (full sun)
+ */
+double sun_illumination(const sun_eclipse_t *ec, const double r[3], double t);
+
+#endif // __SUN_H
@@ -0,0 +1,215 @@
+/**
+ * @file vec3.h
+ * @brief Type-generic 3-vector and quaternion kernels, with explicit single and double precision versions
+ * selected by _Generic. Unlike the macros of macros.h, the precision of every operation is the precision
+ * of its operands: mixing float and double operands does not compile, conversions are explicit.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __VEC3_H
+#define __VEC3_H
+
+#include <math.h>
+
+/**
+ * @brief Single precision 3-vector.
+ *
+ */
+typedef struct
+{
+    float x, y, z;
+} vec3f_t;
+
+/**
+ * @brief Double precision 3-vector.
+ *
+ */
+typedef struct
+{
+    double x, y, z;
+} vec3d_t;
+
+/**
+ * @brief Single precision quaternion (w, x, y, z), in the convention of dyn_state_t.
+ *
+ */
+typedef struct
+{
+    float w, x, y, z;
+} quatf_t;
+
+/**
+ * @brief Double precision quaternion (w, x, y, z), in the convention of dyn_state_t.
+ *
+ */
+typedef struct
+{
+    double w, x, y, z;
+} quatd_t;
+
+/**
+ * @brief Defines the kernels of one precision: vec3<sfx>_add() etc. on vec3<sfx>_t and quat<sfx>_mul() etc. on quat<sfx>_t.
+ *
+ * @param sfx f or d
+ * @param T float or double
+ * @param SQRT Square root of that precision
+ */
+#define VEC3_DEFINE_KERNELS(sfx, T, SQRT)                                                                 \
+    static inline vec3##sfx##_t vec3##sfx##_add(vec3##sfx##_t a, vec3##sfx##_t b)                         \
+    {                                                                                                     \
+        return (vec3##sfx##_t){a.x + b.x, a.y + b.y, a.z + b.z};                                          \
+    }                                                                                                     \
+    static inline vec3##sfx##_t vec3##sfx##_sub(vec3##sfx##_t a, vec3##sfx##_t b)                         \
+    {                                                                                                     \
+        return (vec3##sfx##_t){a.x - b.x, a.y - b.y, a.z - b.z};                                          \
+    }                                                                                                     \
+    static inline vec3##sfx##_t vec3##sfx##_scale(vec3##sfx##_t a, T k)                                   \
+    {                                                                                                     \
+        return (vec3##sfx##_t){a.x * k, a.y * k, a.z * k};                                                \
+    }                                                                                                     \
+    static inline T vec3##sfx##_dot(vec3##sfx##_t a, vec3##sfx##_t b)                                     \
+    {                                                                                                     \
+        return a.x * b.x + a.y * b.y + a.z * b.z;                                                         \
+    }                                                                                                     \
+    static inline vec3##sfx##_t vec3##sfx##_cross(vec3##sfx##_t a, vec3##sfx##_t b)                       \
+    {                                                                                                     \
+        return (vec3##sfx##_t){a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};      \
+    }                                                                                                     \
+    static inline T vec3##sfx##_norm2(vec3##sfx##_t a)                                                    \
+    {                                                                                                     \
+        return a.x * a.x + a.y * a.y + a.z * a.z;                                                         \
+    }                                                                                                     \
+    static inline T vec3##sfx##_norm(vec3##sfx##_t a)                                                     \
+    {                                                                                                     \
+        return SQRT(vec3##sfx##_norm2(a));                                                                \
+    }                                                                                                     \
+    /* the null vector is returned as it is */                                                            \
+    static inline vec3##sfx##_t vec3##sfx##_normalize(vec3##sfx##_t a)                                    \
+    {                                                                                                     \
+        T n2 = vec3##sfx##_norm2(a);                                                                      \
+        return n2 > 0 ? vec3##sfx##_scale(a, 1 / SQRT(n2)) : a;                                           \
+    }                                                                                                     \
+    static inline vec3##sfx##_t vec3##sfx##_matvec(const T M[3][3], vec3##sfx##_t a)                      \
+    {                                                                                                     \
+        return (vec3##sfx##_t){M[0][0] * a.x + M[0][1] * a.y + M[0][2] * a.z,                             \
+                               M[1][0] * a.x + M[1][1] * a.y + M[1][2] * a.z,                             \
+                               M[2][0] * a.x + M[2][1] * a.y + M[2][2] * a.z};                            \
+    }                                                                                                     \
+    static inline quat##sfx##_t quat##sfx##_mul(quat##sfx##_t a, quat##sfx##_t b)                         \
+    {                                                                                                     \
+        return (quat##sfx##_t){a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,                             \
+                               a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,                             \
+                               a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,                             \
+                               a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w};                            \
+    }                                                                                                     \
+    static inline quat##sfx##_t quat##sfx##_conj(quat##sfx##_t q)                                         \
+    {                                                                                                     \
+        return (quat##sfx##_t){q.w, -q.x, -q.y, -q.z};                                                    \
+    }                                                                                                     \
+    static inline quat##sfx##_t quat##sfx##_normalize(quat##sfx##_t q)                                    \
+    {                                                                                                     \
+        T k = 1 / SQRT(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);                                    \
+        return (quat##sfx##_t){q.w * k, q.x * k, q.y * k, q.z * k};                                       \
+    }                                                                                                     \
+    /* q v q*, from the body to the inertial frame for the attitude quaternion; v + 2 w (u x v) + 2 u x (u x v) */ \
+    static inline vec3##sfx##_t quat##sfx##_rotate(quat##sfx##_t q, vec3##sfx##_t v)                      \
+    {                                                                                                     \
+        vec3##sfx##_t u = {q.x, q.y, q.z};                                                                \
+        vec3##sfx##_t t = vec3##sfx##_scale(vec3##sfx##_cross(u, v), 2);                                  \
+        return vec3##sfx##_add(vec3##sfx##_add(v, vec3##sfx##_scale(t, q.w)), vec3##sfx##_cross(u, t));   \
+    }                                                                                                     \
+    /* q* v q, from the inertial to the body frame, as dynamics_to_body() */                              \
+    static inline vec3##sfx##_t quat##sfx##_to_body(quat##sfx##_t q, vec3##sfx##_t v)                     \
+    {                                                                                                     \
+        return quat##sfx##_rotate(quat##sfx##_conj(q), v);                                                \
+    }
+
+VEC3_DEFINE_KERNELS(f, float, sqrtf)
+VEC3_DEFINE_KERNELS(d, double, sqrt)
+
+/**
+ * @brief Explicit conversions between the precisions, and to the same precision (identities, for code written
+ * for either precision).
+ *
+ */
+static inline vec3f_t vec3f_to_f(vec3f_t a)
+{
+    return a;
+}
+static inline vec3d_t vec3d_to_d(vec3d_t a)
+{
+    return a;
+}
+static inline quatf_t quatf_to_f(quatf_t q)
+{
+    return q;
+}
+static inline quatd_t quatd_to_d(quatd_t q)
+{
+    return q;
+}
+static inline vec3f_t vec3d_to_f(vec3d_t a)
+{
+    return (vec3f_t){(float)a.x, (float)a.y, (float)a.z};
+}
+static inline vec3d_t vec3f_to_d(vec3f_t a)
+{
+    return (vec3d_t){a.x, a.y, a.z};
+}
+static inline quatf_t quatd_to_f(quatd_t q)
+{
+    return (quatf_t){(float)q.w, (float)q.x, (float)q.y, (float)q.z};
+}
+static inline quatd_t quatf_to_d(quatf_t q)
+{
+    return (quatd_t){q.w, q.x, q.y, q.z};
+}
+
+/*
+ * Type-generic kernels, dispatched on the type of the first vector or quaternion operand.
+ */
+#define VEC3_ADD(a, b) _Generic((a), vec3f_t: vec3f_add, vec3d_t: vec3d_add)(a, b)
+#define VEC3_SUB(a, b) _Generic((a), vec3f_t: vec3f_sub, vec3d_t: vec3d_sub)(a, b)
+#define VEC3_SCALE(a, k) _Generic((a), vec3f_t: vec3f_scale, vec3d_t: vec3d_scale)(a, k)
+#define VEC3_DOT(a, b) _Generic((a), vec3f_t: vec3f_dot, vec3d_t: vec3d_dot)(a, b)
+#define VEC3_CROSS(a, b) _Generic((a), vec3f_t: vec3f_cross, vec3d_t: vec3d_cross)(a, b)
+#define VEC3_NORM2(a) _Generic((a), vec3f_t: vec3f_norm2, vec3d_t: vec3d_norm2)(a)
+#define VEC3_NORM(a) _Generic((a), vec3f_t: vec3f_norm, vec3d_t: vec3d_norm)(a)
+#define VEC3_NORMALIZE(a) _Generic((a), vec3f_t: vec3f_normalize, vec3d_t: vec3d_normalize)(a)
+#define VEC3_MATVEC(M, a) _Generic((a), vec3f_t: vec3f_matvec, vec3d_t: vec3d_matvec)(M, a)
+#define QUAT_MUL(a, b) _Generic((a), quatf_t: quatf_mul, quatd_t: quatd_mul)(a, b)
+#define QUAT_CONJ(q) _Generic((q), quatf_t: quatf_conj, quatd_t: quatd_conj)(q)
+#define QUAT_NORMALIZE(q) _Generic((q), quatf_t: quatf_normalize, quatd_t: quatd_normalize)(q)
+#define QUAT_ROTATE(q, v) _Generic((q), quatf_t: quatf_rotate, quatd_t: quatd_rotate)(q, v)
+#define QUAT_TO_BODY(q, v) _Generic((q), quatf_t: quatf_to_body, quatd_t: quatd_to_body)(q, v)
+
+/**
+ * @brief Reads a vector declared using DECLARE_VECTOR() (or an element of a buffer) as a vec3f_t or vec3d_t,
+ * following the type of its components.
+ *
+ * @param name Name of the vector
+ */
+#define VEC3_LOAD(name) \
+    _Generic((x_##name), float: (vec3f_t){x_##name, y_##name, z_##name}, double: (vec3d_t){x_##name, y_##name, z_##name})
+
+/**
+ * @brief Stores a vec3f_t or vec3d_t into a vector declared using DECLARE_VECTOR() (or an element of a buffer)
+ * of the same precision.
+ *
+ * @param name Name of the vector
+ * @param v Vector
+ */
+#define VEC3_STORE(name, v)                                                          \
+    do                                                                               \
+    {                                                                                \
+        __typeof__(v) vec3__v = (v);                                                 \
+        _Static_assert(sizeof(vec3__v.x) == sizeof(x_##name), "precision mismatch"); \
+        x_##name = vec3__v.x;                                                        \
+        y_##name = vec3__v.y;                                                        \
+        z_##name = vec3__v.z;                                                        \
+    } while (0)
+
+#endif // __VEC3_H
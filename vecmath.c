@@ -0,0 +1,366 @@
+/**
+ * @file vecmath.c
+ * @brief Vector math over arrays of vectors stored as separate x, y, z arrays (structure of arrays), with
+ * SSE, AVX2 and AVX-512 kernels selected at run time and a scalar fallback.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <vecmath.h>
+#include <macros.h>
+#include <float.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+/**
+ * @brief Defined when the SIMD kernels are built, on x86 only.
+ *
+ */
+#define VEC_X86
+#endif
+
+typedef void (*vec_isqrt_fn)(float *dst, const float *src, int n);
+typedef void (*vec_normalize_fn)(float *dx, float *dy, float *dz, const float *x, const float *y, const float *z, int n);
+
+static void isqrt_scalar(float *dst, const float *src, int n)
+{
+    for (int i = 0; i < n; i++)
+        dst[i] = q2isqrt(src[i]);
+}
+
+static void normalize_scalar(float *dx, float *dy, float *dz, const float *x, const float *y, const float *z, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        float n2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+        float s = n2 < FLT_MIN ? 1 : q2isqrt(n2);
+        dx[i] = x[i] * s;
+        dy[i] = y[i] * s;
+        dz[i] = z[i] * s;
+    }
+}
+
+#ifdef VEC_X86
+/*
+ * The approximate reciprocal square root instructions are good to 12 (rsqrtps) or 14 (vrsqrt14ps) bits.
+ * One Newton step, y' = y + y (1/2 - x y^2 / 2), squares the relative error, which leaves the result
+ * within a few ulp of 1/sqrt(x). The arrays are processed a register at a time; the last partial
+ * register goes through a padded copy so that every element sees the same arithmetic.
+ */
+
+static inline __m128 rsqrt_sse(__m128 x)
+{
+    __m128 y = _mm_rsqrt_ps(x);
+    __m128 hxy = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x), y);
+    __m128 e = _mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(hxy, y));
+    return _mm_add_ps(y, _mm_mul_ps(y, e));
+}
+
+static void isqrt_sse(float *dst, const float *src, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(dst + i, rsqrt_sse(_mm_loadu_ps(src + i)));
+    if (i < n)
+    {
+        float t[4] = {1, 1, 1, 1};
+        memcpy(t, src + i, (n - i) * sizeof(float));
+        _mm_storeu_ps(t, rsqrt_sse(_mm_loadu_ps(t)));
+        memcpy(dst + i, t, (n - i) * sizeof(float));
+    }
+}
+
+static inline void normalize_sse4(float *dx, float *dy, float *dz, const float *x, const float *y, const float *z)
+{
+    __m128 vx = _mm_loadu_ps(x), vy = _mm_loadu_ps(y), vz = _mm_loadu_ps(z);
+    __m128 n2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+    __m128 ok = _mm_cmpge_ps(n2, _mm_set1_ps(FLT_MIN));
+    __m128 s = _mm_or_ps(_mm_and_ps(ok, rsqrt_sse(n2)), _mm_andnot_ps(ok, _mm_set1_ps(1.0f)));
+    _mm_storeu_ps(dx, _mm_mul_ps(vx, s));
+    _mm_storeu_ps(dy, _mm_mul_ps(vy, s));
+    _mm_storeu_ps(dz, _mm_mul_ps(vz, s));
+}
+
+static void normalize_sse(float *dx, float *dy, float *dz, const float *x, const float *y, const float *z, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        normalize_sse4(dx + i, dy + i, dz + i, x + i, y + i, z + i);
+    if (i < n)
+    {
+        float t[3][4] = {{0}};
+        size_t sz = (n - i) * sizeof(float);
+        memcpy(t[0], x + i, sz);
+        memcpy(t[1], y + i, sz);
+        memcpy(t[2], z + i, sz);
+        normalize_sse4(t[0], t[1], t[2], t[0], t[1], t[2]);
+        memcpy(dx + i, t[0], sz);
+        memcpy(dy + i, t[1], sz);
+        memcpy(dz + i, t[2], sz);
+    }
+}
+
+__attribute__((target("avx2,fma"))) static inline __m256 rsqrt_avx2(__m256 x)
+{
+    __m256 y = _mm256_rsqrt_ps(x);
+    __m256 hxy = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), x), y);
+    __m256 e = _mm256_fnmadd_ps(hxy, y, _mm256_set1_ps(0.5f));
+    return _mm256_fmadd_ps(y, e, y);
+}
+
+__attribute__((target("avx2,fma"))) static void isqrt_avx2(float *dst, const float *src, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(dst + i, rsqrt_avx2(_mm256_loadu_ps(src + i)));
+    if (i < n)
+    {
+        float t[8] = {1, 1, 1, 1, 1, 1, 1, 1};
+        memcpy(t, src + i, (n - i) * sizeof(float));
+        _mm256_storeu_ps(t, rsqrt_avx2(_mm256_loadu_ps(t)));
+        memcpy(dst + i, t, (n - i) * sizeof(float));
+    }
+}
+
+__attribute__((target("avx2,fma"))) static inline void normalize_avx2_8(float *dx, float *dy, float *dz, const float *x, const float *y, const float *z)
+{
+    __m256 vx = _mm256_loadu_ps(x), vy = _mm256_loadu_ps(y), vz = _mm256_loadu_ps(z);
+    __m256 n2 = _mm256_fmadd_ps(vz, vz, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(vx, vx)));
+    __m256 ok = _mm256_cmp_ps(n2, _mm256_set1_ps(FLT_MIN), _CMP_GE_OQ);
+    __m256 s = _mm256_blendv_ps(_mm256_set1_ps(1.0f), rsqrt_avx2(n2), ok);
+    _mm256_storeu_ps(dx, _mm256_mul_ps(vx, s));
+    _mm256_storeu_ps(dy, _mm256_mul_ps(vy, s));
+    _mm256_storeu_ps(dz, _mm256_mul_ps(vz, s));
+}
+
+__attribute__((target("avx2,fma"))) static void normalize_avx2(float *dx, float *dy, float *dz, const float *x, const float *y, const float *z, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        normalize_avx2_8(dx + i, dy + i, dz + i, x + i, y + i, z + i);
+    if (i < n)
+    {
+        float t[3][8] = {{0}};
+        size_t sz = (n - i) * sizeof(float);
+        memcpy(t[0], x + i, sz);
+        memcpy(t[1], y + i, sz);
+        memcpy(t[2], z + i, sz);
+        normalize_avx2_8(t[0], t[1], t[2], t[0], t[1], t[2]);
+        memcpy(dx + i, t[0], sz);
+        memcpy(dy + i, t[1], sz);
+        memcpy(dz + i, t[2], sz);
+    }
+}
+
+__attribute__((target("avx512f"))) static inline __m512 rsqrt_avx512(__m512 x)
+{
+    __m512 y = _mm512_rsqrt14_ps(x);
+    __m512 hxy = _mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(0.5f), x), y);
+    __m512 e = _mm512_fnmadd_ps(hxy, y, _mm512_set1_ps(0.5f));
+    return _mm512_fmadd_ps(y, e, y);
+}
+
+__attribute__((target("avx512f"))) static void isqrt_avx512(float *dst, const float *src, int n)
+{
+    for (int i = 0; i < n; i += 16)
+    {
+        __mmask16 k = n - i >= 16 ? 0xffff : (__mmask16)((1u << (n - i)) - 1); // the tail is masked
+        __m512 x = _mm512_mask_loadu_ps(_mm512_set1_ps(1.0f), k, src + i);
+        _mm512_mask_storeu_ps(dst + i, k, rsqrt_avx512(x));
+    }
+}
+
+__attribute__((target("avx512f"))) static void normalize_avx512(float *dx, float *dy, float *dz, const float *x, const float *y, const float *z, int n)
+{
+    for (int i = 0; i < n; i += 16)
+    {
+        __mmask16 k = n - i >= 16 ? 0xffff : (__mmask16)((1u << (n - i)) - 1);
+        __m512 vx = _mm512_maskz_loadu_ps(k, x + i), vy = _mm512_maskz_loadu_ps(k, y + i), vz = _mm512_maskz_loadu_ps(k, z + i);
+        __m512 n2 = _mm512_fmadd_ps(vz, vz, _mm512_fmadd_ps(vy, vy, _mm512_mul_ps(vx, vx)));
+        __mmask16 ok = _mm512_cmp_ps_mask(n2, _mm512_set1_ps(FLT_MIN), _CMP_GE_OQ);
+        __m512 s = _mm512_mask_blend_ps(ok, _mm512_set1_ps(1.0f), rsqrt_avx512(n2));
+        _mm512_mask_storeu_ps(dx + i, k, _mm512_mul_ps(vx, s));
+        _mm512_mask_storeu_ps(dy + i, k, _mm512_mul_ps(vy, s));
+        _mm512_mask_storeu_ps(dz + i, k, _mm512_mul_ps(vz, s));
+    }
+}
+#endif // VEC_X86
+
+/**
+ * @brief Kernels of each instruction set level, NULL where not built.
+ *
+ */
+static const struct
+{
+    const char *name;
+    vec_isqrt_fn isqrt;
+    vec_normalize_fn normalize;
+} vec_kernels[VEC_ISA_COUNT] = {
+    {"scalar", isqrt_scalar, normalize_scalar},
+#ifdef VEC_X86
+    {"sse", isqrt_sse, normalize_sse},
+    {"avx2", isqrt_avx2, normalize_avx2},
+    {"avx512", isqrt_avx512, normalize_avx512},
+#else
+    {"sse", NULL, NULL},
+    {"avx2", NULL, NULL},
+    {"avx512", NULL, NULL},
+#endif
+};
+
+static vec_isqrt_fn vec_isqrt_kernel = NULL;
+static vec_normalize_fn vec_normalize_kernel = NULL;
+
+/**
+ * @brief Returns the highest instruction set level supported by the CPU and the OS.
+ *
+ */
+static vec_isa vec_supported(void)
+{
+#ifdef VEC_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return VEC_ISA_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return VEC_ISA_AVX2;
+    if (__builtin_cpu_supports("sse"))
+        return VEC_ISA_SSE;
+#endif
+    return VEC_ISA_SCALAR;
+}
+
+vec_isa vec_select(vec_isa isa)
+{
+    vec_isa top = vec_supported();
+    if (isa < VEC_ISA_SCALAR || isa > top)
+        isa = top;
+    vec_isqrt_kernel = vec_kernels[isa].isqrt;
+    vec_normalize_kernel = vec_kernels[isa].normalize;
+    return isa;
+}
+
+const char *vec_isa_name(vec_isa isa)
+{
+    return isa >= VEC_ISA_SCALAR && isa < VEC_ISA_COUNT ? vec_kernels[isa].name : "unknown";
+}
+
+void vec_isqrtf(float *dst, const float *src, int n)
+{
+    if (vec_isqrt_kernel == NULL)
+        vec_select(VEC_ISA_COUNT);
+    vec_isqrt_kernel(dst, src, n);
+}
+
+void vec_normalize3f(float *dx, float *dy, float *dz, const float *x, const float *y, const float *z, int n)
+{
+    if (vec_normalize_kernel == NULL)
+        vec_select(VEC_ISA_COUNT);
+    vec_normalize_kernel(dx, dy, dz, x, y, z, n);
+}
+
+#ifdef VEC_X86
+/**
+ * @brief Builds AVX-512, AVX2 and baseline versions of a kernel, the loader picks one for the CPU.
+ *
+ */
+#define VEC_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define VEC_CLONES
+#endif
+
+/*
+ * The array kernels are plain loops over the component arrays, which GCC vectorizes at -O3 (VECCFLAGS in the
+ * Makefile). They are defined once for float and once for double by VEC_ARRAY_KERNELS().
+ */
+#define VEC_ARRAY_KERNELS(sfx, type)                                                                                                  \
+    VEC_CLONES void vec_cross3##sfx(type *restrict dx, type *restrict dy, type *restrict dz, const type *restrict ax,                 \
+                                    const type *restrict ay, const type *restrict az, const type *restrict bx,                        \
+                                    const type *restrict by, const type *restrict bz, int n)                                          \
+    {                                                                                                                                 \
+        for (int i = 0; i < n; i++)                                                                                                   \
+        {                                                                                                                             \
+            dx[i] = ay[i] * bz[i] - az[i] * by[i];                                                                                    \
+            dy[i] = az[i] * bx[i] - ax[i] * bz[i];                                                                                    \
+            dz[i] = ax[i] * by[i] - ay[i] * bx[i];                                                                                    \
+        }                                                                                                                             \
+    }                                                                                                                                 \
+    VEC_CLONES void vec_dot3##sfx(type *d, const type *ax, const type *ay, const type *az, const type *bx, const type *by,            \
+                                  const type *bz, int n)                                                                              \
+    {                                                                                                                                 \
+        for (int i = 0; i < n; i++)                                                                                                   \
+            d[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];                                                                     \
+    }                                                                                                                                 \
+    VEC_CLONES void vec_norm2_3##sfx(type *d, const type *x, const type *y, const type *z, int n)                                     \
+    {                                                                                                                                 \
+        for (int i = 0; i < n; i++)                                                                                                   \
+            d[i] = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];                                                                           \
+    }                                                                                                                                 \
+    VEC_ARRAY_ELEMENTWISE(add3##sfx, type, +)                                                                                         \
+    VEC_ARRAY_ELEMENTWISE(sub3##sfx, type, -)                                                                                         \
+    VEC_ARRAY_ELEMENTWISE(mul3##sfx, type, *)                                                                                         \
+    VEC_CLONES void vec_scale3##sfx(type *dx, type *dy, type *dz, const type *x, const type *y, const type *z, type k, int n)         \
+    {                                                                                                                                 \
+        for (int i = 0; i < n; i++)                                                                                                   \
+        {                                                                                                                             \
+            dx[i] = x[i] * k;                                                                                                         \
+            dy[i] = y[i] * k;                                                                                                         \
+            dz[i] = z[i] * k;                                                                                                         \
+        }                                                                                                                             \
+    }                                                                                                                                 \
+    VEC_CLONES void vec_scalev3##sfx(type *dx, type *dy, type *dz, const type *x, const type *y, const type *z, const type *k, int n) \
+    {                                                                                                                                 \
+        for (int i = 0; i < n; i++)                                                                                                   \
+        {                                                                                                                             \
+            dx[i] = x[i] * k[i];                                                                                                      \
+            dy[i] = y[i] * k[i];                                                                                                      \
+            dz[i] = z[i] * k[i];                                                                                                      \
+        }                                                                                                                             \
+    }                                                                                                                                 \
+    VEC_CLONES void vec_matvec3##sfx(type *restrict dx, type *restrict dy, type *restrict dz, const type M[3][3],                     \
+                                     const type *restrict x, const type *restrict y, const type *restrict z, int n)                   \
+    {                                                                                                                                 \
+        /* the matrix in registers, not reloaded for every vector */                                                                 \
+        const type m00 = M[0][0], m01 = M[0][1], m02 = M[0][2];                                                                       \
+        const type m10 = M[1][0], m11 = M[1][1], m12 = M[1][2];                                                                       \
+        const type m20 = M[2][0], m21 = M[2][1], m22 = M[2][2];                                                                       \
+        for (int i = 0; i < n; i++)                                                                                                   \
+        {                                                                                                                             \
+            dx[i] = m00 * x[i] + m01 * y[i] + m02 * z[i];                                                                             \
+            dy[i] = m10 * x[i] + m11 * y[i] + m12 * z[i];                                                                             \
+            dz[i] = m20 * x[i] + m21 * y[i] + m22 * z[i];                                                                             \
+        }                                                                                                                             \
+    }                                                                                                                                 \
+    VEC_CLONES void vec_omega3##sfx(type *restrict wx, type *restrict wy, type *restrict wz, const type *restrict x,                  \
+                                    const type *restrict y, const type *restrict z, const type *restrict px,                          \
+                                    const type *restrict py, const type *restrict pz, type freq, int n)                               \
+    {                                                                                                                                 \
+        for (int i = 0; i < n; i++)                                                                                                   \
+        {                                                                                                                             \
+            type s = freq / (px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i]);                                                          \
+            wx[i] = (y[i] * pz[i] - z[i] * py[i]) * s;                                                                                \
+            wy[i] = (z[i] * px[i] - x[i] * pz[i]) * s;                                                                                \
+            wz[i] = (x[i] * py[i] - y[i] * px[i]) * s;                                                                                \
+        }                                                                                                                             \
+    }
+
+/**
+ * @brief Element by element operation op on two arrays of vectors, the VECTOR_OP() of many vectors.
+ *
+ */
+#define VEC_ARRAY_ELEMENTWISE(name, type, op)                                                                              \
+    VEC_CLONES void vec_##name(type *dx, type *dy, type *dz, const type *ax, const type *ay, const type *az, const type *bx, \
+                               const type *by, const type *bz, int n)                                                      \
+    {                                                                                                                      \
+        for (int i = 0; i < n; i++)                                                                                        \
+        {                                                                                                                  \
+            dx[i] = ax[i] op bx[i];                                                                                        \
+            dy[i] = ay[i] op by[i];                                                                                        \
+            dz[i] = az[i] op bz[i];                                                                                        \
+        }                                                                                                                  \
+    }
+
+VEC_ARRAY_KERNELS(f, float)
+VEC_ARRAY_KERNELS(d, double)
@@ -0,0 +1,288 @@
+/**
+ * @file vecmath.h
+ * @brief Vector math over arrays of vectors stored as separate x, y, z arrays (structure of arrays), with
+ * SSE, AVX2 and AVX-512 kernels selected at run time and a scalar fallback.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __VECMATH_H
+#define __VECMATH_H
+
+/**
+ * @brief Instruction set levels of the kernels.
+ *
+ */
+typedef enum
+{
+    VEC_ISA_SCALAR = 0, // q2isqrt(), on any machine
+    VEC_ISA_SSE,        // rsqrtps and one Newton step, 4 lanes
+    VEC_ISA_AVX2,       // vrsqrtps and one Newton step with FMA, 8 lanes
+    VEC_ISA_AVX512,     // vrsqrt14ps and one Newton step, 16 lanes
+    VEC_ISA_COUNT
+} vec_isa;
+
+/**
+ * @brief Selects the kernels of the given instruction set level, or of the highest level below it
+ * supported by the CPU. The kernels of the highest supported level are selected on first use otherwise.
+ *
+ * @param isa Highest level to use, VEC_ISA_COUNT for the highest supported one
+ * @return vec_isa Level selected
+ */
+vec_isa vec_select(vec_isa isa);
+
+/**
+ * @brief Returns the name of an instruction set level.
+ *
+ * @param isa Level
+ * @return const char* Name, e.g. "avx2"
+ */
+const char *vec_isa_name(vec_isa isa);
+
+/**
+ * @brief Calculates the inverse square roots of an array of floats, within 3 ulp on every path.
+ * The inputs must be positive and normal, as for q2isqrt(). dst may be src.
+ *
+ * @param dst Inverse square roots
+ * @param src Inputs
+ * @param n Number of elements
+ */
+void vec_isqrtf(float *dst, const float *src, int n);
+
+/**
+ * @brief Normalizes an array of vectors, the NORMALIZE() of many vectors at once. Vectors whose squared norm is
+ * below FLT_MIN, including the null vector, are copied unchanged. The destination may be the source.
+ *
+ * @param dx Normalized x components
+ * @param dy Normalized y components
+ * @param dz Normalized z components
+ * @param x x components
+ * @param y y components
+ * @param z z components
+ * @param n Number of vectors
+ */
+void vec_normalize3f(float *dx, float *dy, float *dz, const float *x, const float *y, const float *z, int n);
+
+/**
+ * @brief Normalizes the first size vectors of a buffer declared using DECLARE_RING() in place.
+ *
+ * @param name Name of the buffer
+ * @param size Number of vectors
+ */
+#define NORMALIZE_BUFFER(name, size) \
+    vec_normalize3f(x_##name, y_##name, z_##name, x_##name, y_##name, z_##name, size)
+
+/*
+ * Array versions of the vector macros of macros.h, for whole buffers and batches. Each takes the components
+ * as separate arrays and processes n vectors; pointer offsets select a stretch of a buffer, e.g. the cross
+ * products of every element of a buffer with the element before it are
+ * vec_cross3d(x_W + 1, y_W + 1, z_W + 1, x_B + 1, y_B + 1, z_B + 1, x_B, y_B, z_B, n - 1).
+ * The f versions work on float arrays, the d versions on double arrays. Unless noted, the destination may be
+ * one of the sources (the same arrays, not overlapping at an offset).
+ */
+
+/**
+ * @brief Cross products, the CROSS_PRODUCT() of many vectors. The destination must not overlap the sources.
+ *
+ * @param dx x components of a x b
+ * @param dy y components of a x b
+ * @param dz z components of a x b
+ * @param ax x components of a
+ * @param ay y components of a
+ * @param az z components of a
+ * @param bx x components of b
+ * @param by y components of b
+ * @param bz z components of b
+ * @param n Number of vectors
+ */
+void vec_cross3f(float *dx, float *dy, float *dz, const float *ax, const float *ay, const float *az, const float *bx, const float *by, const float *bz, int n);
+void vec_cross3d(double *dx, double *dy, double *dz, const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, int n);
+
+/**
+ * @brief Dot products, the DOT_PRODUCT() of many vectors.
+ *
+ * @param d a . b
+ * @param ax x components of a
+ * @param ay y components of a
+ * @param az z components of a
+ * @param bx x components of b
+ * @param by y components of b
+ * @param bz z components of b
+ * @param n Number of vectors
+ */
+void vec_dot3f(float *d, const float *ax, const float *ay, const float *az, const float *bx, const float *by, const float *bz, int n);
+void vec_dot3d(double *d, const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, int n);
+
+/**
+ * @brief Squared norms, the NORM2() of many vectors.
+ *
+ * @param d |a|^2
+ * @param x x components of a
+ * @param y y components of a
+ * @param z z components of a
+ * @param n Number of vectors
+ */
+void vec_norm2_3f(float *d, const float *x, const float *y, const float *z, int n);
+void vec_norm2_3d(double *d, const double *x, const double *y, const double *z, int n);
+
+/**
+ * @brief Element by element sums, differences and products, the VECTOR_OP() of many vectors with +, - and *.
+ *
+ * @param dx x components of the result
+ * @param dy y components of the result
+ * @param dz z components of the result
+ * @param ax x components of a
+ * @param ay y components of a
+ * @param az z components of a
+ * @param bx x components of b
+ * @param by y components of b
+ * @param bz z components of b
+ * @param n Number of vectors
+ */
+void vec_add3f(float *dx, float *dy, float *dz, const float *ax, const float *ay, const float *az, const float *bx, const float *by, const float *bz, int n);
+void vec_add3d(double *dx, double *dy, double *dz, const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, int n);
+void vec_sub3f(float *dx, float *dy, float *dz, const float *ax, const float *ay, const float *az, const float *bx, const float *by, const float *bz, int n);
+void vec_sub3d(double *dx, double *dy, double *dz, const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, int n);
+void vec_mul3f(float *dx, float *dy, float *dz, const float *ax, const float *ay, const float *az, const float *bx, const float *by, const float *bz, int n);
+void vec_mul3d(double *dx, double *dy, double *dz, const double *ax, const double *ay, const double *az, const double *bx, const double *by, const double *bz, int n);
+
+/**
+ * @brief Scales vectors by a scalar, the VECTOR_MIXED() of many vectors with *.
+ *
+ * @param dx x components of k a
+ * @param dy y components of k a
+ * @param dz z components of k a
+ * @param x x components of a
+ * @param y y components of a
+ * @param z z components of a
+ * @param k Scale
+ * @param n Number of vectors
+ */
+void vec_scale3f(float *dx, float *dy, float *dz, const float *x, const float *y, const float *z, float k, int n);
+void vec_scale3d(double *dx, double *dy, double *dz, const double *x, const double *y, const double *z, double k, int n);
+
+/**
+ * @brief Scales each vector by its own scalar.
+ *
+ * @param dx x components of k a
+ * @param dy y components of k a
+ * @param dz z components of k a
+ * @param x x components of a
+ * @param y y components of a
+ * @param z z components of a
+ * @param k Scales, one per vector
+ * @param n Number of vectors
+ */
+void vec_scalev3f(float *dx, float *dy, float *dz, const float *x, const float *y, const float *z, const float *k, int n);
+void vec_scalev3d(double *dx, double *dy, double *dz, const double *x, const double *y, const double *z, const double *k, int n);
+
+/**
+ * @brief Multiplies many vectors by one 3x3 matrix, the MATVECMUL() of many vectors, e.g. MOI times every
+ * sample of g_W. The destination must not overlap the source.
+ *
+ * @param dx x components of M a
+ * @param dy y components of M a
+ * @param dz z components of M a
+ * @param M 3 x 3 matrix
+ * @param x x components of a
+ * @param y y components of a
+ * @param z z components of a
+ * @param n Number of vectors
+ */
+void vec_matvec3f(float *dx, float *dy, float *dz, const float M[3][3], const float *x, const float *y, const float *z, int n);
+void vec_matvec3d(double *dx, double *dy, double *dz, const double M[3][3], const double *x, const double *y, const double *z, int n);
+
+/**
+ * @brief Angular velocity estimates from consecutive B-dot samples, as getOmega() calculates them before
+ * filtering: w = (Bt x Bt_prev) freq / |Bt_prev|^2. Recomputes omega over a whole recorded log in one pass.
+ * The destination must not overlap the sources.
+ *
+ * @param wx x components of the estimates
+ * @param wy y components of the estimates
+ * @param wz z components of the estimates
+ * @param x x components of the B-dot samples
+ * @param y y components of the B-dot samples
+ * @param z z components of the B-dot samples
+ * @param px x components of the previous B-dot samples
+ * @param py y components of the previous B-dot samples
+ * @param pz z components of the previous B-dot samples
+ * @param freq Sampling frequency of the magnetometer (Hz)
+ * @param n Number of estimates
+ */
+void vec_omega3f(float *wx, float *wy, float *wz, const float *x, const float *y, const float *z, const float *px, const float *py, const float *pz, float freq, int n);
+void vec_omega3d(double *wx, double *wy, double *wz, const double *x, const double *y, const double *z, const double *px, const double *py, const double *pz, double freq, int n);
+
+/*
+ * Type-generic array kernels, dispatched on the type of the first destination array: float arrays use the f
+ * kernels, double arrays the d kernels. Sources of the other precision are flagged as incompatible pointer types.
+ */
+#define VEC_CROSS3(dx, ...) _Generic((dx), float *: vec_cross3f, double *: vec_cross3d)(dx, __VA_ARGS__)
+#define VEC_DOT3(d, ...) _Generic((d), float *: vec_dot3f, double *: vec_dot3d)(d, __VA_ARGS__)
+#define VEC_NORM2_3(d, ...) _Generic((d), float *: vec_norm2_3f, double *: vec_norm2_3d)(d, __VA_ARGS__)
+#define VEC_ADD3(dx, ...) _Generic((dx), float *: vec_add3f, double *: vec_add3d)(dx, __VA_ARGS__)
+#define VEC_SUB3(dx, ...) _Generic((dx), float *: vec_sub3f, double *: vec_sub3d)(dx, __VA_ARGS__)
+#define VEC_MUL3(dx, ...) _Generic((dx), float *: vec_mul3f, double *: vec_mul3d)(dx, __VA_ARGS__)
+#define VEC_SCALE3(dx, ...) _Generic((dx), float *: vec_scale3f, double *: vec_scale3d)(dx, __VA_ARGS__)
+#define VEC_SCALEV3(dx, ...) _Generic((dx), float *: vec_scalev3f, double *: vec_scalev3d)(dx, __VA_ARGS__)
+#define VEC_MATVEC3(dx, ...) _Generic((dx), float *: vec_matvec3f, double *: vec_matvec3d)(dx, __VA_ARGS__)
+#define VEC_OMEGA3(wx, ...) _Generic((wx), float *: vec_omega3f, double *: vec_omega3d)(wx, __VA_ARGS__)
+
+/**
+ * @brief Cross products of the first size vectors of two buffers declared using DECLARE_RING(), of either precision.
+ *
+ * @param dest Destination buffer, different from the sources
+ * @param s1 First source buffer
+ * @param s2 Second source buffer
+ * @param size Number of vectors
+ */
+#define CROSS_PRODUCT_BUFFER(dest, s1, s2, size) \
+    VEC_CROSS3(x_##dest, y_##dest, z_##dest, x_##s1, y_##s1, z_##s1, x_##s2, y_##s2, z_##s2, size)
+
+/**
+ * @brief Element by element sums of the first size vectors of two buffers declared using DECLARE_RING().
+ *
+ * @param dest Destination buffer, may be one of the sources
+ * @param s1 First source buffer
+ * @param s2 Second source buffer
+ * @param size Number of vectors
+ */
+#define VECTOR_ADD_BUFFER(dest, s1, s2, size) \
+    VEC_ADD3(x_##dest, y_##dest, z_##dest, x_##s1, y_##s1, z_##s1, x_##s2, y_##s2, z_##s2, size)
+
+/**
+ * @brief Element by element differences of the first size vectors of two buffers declared using DECLARE_RING().
+ *
+ * @param dest Destination buffer, may be one of the sources
+ * @param s1 First source buffer
+ * @param s2 Second source buffer
+ * @param size Number of vectors
+ */
+#define VECTOR_SUB_BUFFER(dest, s1, s2, size) \
+    VEC_SUB3(x_##dest, y_##dest, z_##dest, x_##s1, y_##s1, z_##s1, x_##s2, y_##s2, z_##s2, size)
+
+/**
+ * @brief Scales the first size vectors of a buffer declared using DECLARE_RING().
+ *
+ * @param dest Destination buffer, may be the source
+ * @param src Source buffer
+ * @param k Scale
+ * @param size Number of vectors
+ */
+#define VECTOR_SCALE_BUFFER(dest, src, k, size) \
+    VEC_SCALE3(x_##dest, y_##dest, z_##dest, x_##src, y_##src, z_##src, k, size)
+
+/**
+ * @brief Multiplies the first size vectors of a buffer declared using DECLARE_RING() by a 3x3 matrix of the
+ * same precision, e.g. MATVECMUL_BUFFER(L, MOI, g_W, SH_BUFFER_SIZE).
+ *
+ * @param dest Destination buffer, different from the source
+ * @param M 3 x 3 matrix
+ * @param src Source buffer
+ * @param size Number of vectors
+ */
+#define MATVECMUL_BUFFER(dest, M, src, size) \
+    VEC_MATVEC3(x_##dest, y_##dest, z_##dest, M, x_##src, y_##src, z_##src, size)
+
+#endif // __VECMATH_H
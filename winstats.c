@@ -0,0 +1,179 @@
+/**
+ * @file winstats.c
+ * @brief Sliding-window statistics of the vector signals of the ACS.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <winstats.h>
+#include <math.h>
+#include <string.h>
+
+int winstat_alloc(winstat_t *w, arena_t *a, uint32_t capacity)
+{
+    memset(w, 0, sizeof(winstat_t));
+    if ((w->v = arena_alloc(a, capacity * sizeof(double))) == NULL ||
+        (w->min_q = arena_alloc(a, capacity * sizeof(uint32_t))) == NULL ||
+        (w->max_q = arena_alloc(a, capacity * sizeof(uint32_t))) == NULL)
+        return -1;
+    w->mask = capacity - 1;
+    winstat_init(w, capacity);
+    return 1;
+}
+
+void winstat_init(winstat_t *w, int window)
+{
+    int capacity = w->mask + 1;
+    w->mean = 0;
+    w->m2 = 0;
+    w->min_head = w->min_len = 0;
+    w->max_head = w->max_len = 0;
+    w->seq = 0;
+    w->window = window < 1 ? 1 : window > capacity ? capacity : window;
+    return;
+}
+
+/**
+ * @brief Two-pass mean and squared deviations of the window, replacing the running ones.
+ *
+ */
+static void winstat_resync(winstat_t *w)
+{
+    int n = winstat_count(w);
+    double sum = 0, m2 = 0;
+    for (int i = 0; i < n; i++)
+        sum += w->v[(w->seq - 1 - i) & w->mask];
+    double mean = sum / n;
+    for (int i = 0; i < n; i++)
+    {
+        double d = w->v[(w->seq - 1 - i) & w->mask] - mean;
+        m2 += d * d;
+    }
+    w->mean = mean;
+    w->m2 = m2;
+}
+
+void winstat_push(winstat_t *w, double x)
+{
+    uint32_t s = w->seq;
+    int n = winstat_count(w);
+    // moments: add x, and remove the sample leaving the window in the same update
+    if (n < w->window)
+    {
+        double d = x - w->mean;
+        w->mean += d / (n + 1);
+        w->m2 += d * (x - w->mean);
+    }
+    else
+    {
+        double out = w->v[(s - w->window) & w->mask];
+        double mean = w->mean + (x - out) / n;
+        w->m2 += (x - out) * (x - mean + out - w->mean);
+        w->mean = mean;
+    }
+    w->v[s & w->mask] = x;
+    w->seq = s + 1;
+    // extrema: drop the samples that left the window from the front, and the samples x dominates from the back
+    if (w->min_len > 0 && w->min_q[w->min_head] + w->window <= s)
+    {
+        w->min_head = (w->min_head + 1) & w->mask;
+        w->min_len--;
+    }
+    while (w->min_len > 0 && w->v[w->min_q[(w->min_head + w->min_len - 1) & w->mask] & w->mask] >= x)
+        w->min_len--;
+    w->min_q[(w->min_head + w->min_len++) & w->mask] = s;
+    if (w->max_len > 0 && w->max_q[w->max_head] + w->window <= s)
+    {
+        w->max_head = (w->max_head + 1) & w->mask;
+        w->max_len--;
+    }
+    while (w->max_len > 0 && w->v[w->max_q[(w->max_head + w->max_len - 1) & w->mask] & w->mask] <= x)
+        w->max_len--;
+    w->max_q[(w->max_head + w->max_len++) & w->mask] = s;
+    if ((w->seq & w->mask) == 0)
+        winstat_resync(w);
+    return;
+}
+
+int winstat3_alloc(winstat3_t *w, arena_t *a, uint32_t capacity)
+{
+    for (int i = 0; i < 3; i++)
+        if (winstat_alloc(&w->axis[i], a, capacity) < 0)
+            return -1;
+    return winstat_alloc(&w->norm, a, capacity);
+}
+
+void winstat3_init(winstat3_t *w, int window)
+{
+    for (int i = 0; i < 3; i++)
+        winstat_init(&w->axis[i], window);
+    winstat_init(&w->norm, window);
+    return;
+}
+
+static void winstat_save(winstat_save_t *s, const winstat_t *w)
+{
+    size_t n = w->mask + 1;
+    s->w = *w;
+    s->w.v = NULL;
+    s->w.min_q = s->w.max_q = NULL;
+    memcpy(s->v, w->v, n * sizeof(double));
+    memcpy(s->min_q, w->min_q, n * sizeof(uint32_t));
+    memcpy(s->max_q, w->max_q, n * sizeof(uint32_t));
+    return;
+}
+
+static void winstat_restore(winstat_t *w, const winstat_save_t *s)
+{
+    winstat_t arrays = *w;
+    *w = s->w;
+    w->v = arrays.v;
+    w->min_q = arrays.min_q;
+    w->max_q = arrays.max_q;
+    w->mask = arrays.mask;
+    size_t n = w->mask + 1;
+    memcpy(w->v, s->v, n * sizeof(double));
+    memcpy(w->min_q, s->min_q, n * sizeof(uint32_t));
+    memcpy(w->max_q, s->max_q, n * sizeof(uint32_t));
+    return;
+}
+
+void winstat3_save(winstat3_save_t *s, const winstat3_t *w)
+{
+    for (int i = 0; i < 3; i++)
+        winstat_save(&s->axis[i], &w->axis[i]);
+    winstat_save(&s->norm, &w->norm);
+    return;
+}
+
+void winstat3_restore(winstat3_t *w, const winstat3_save_t *s)
+{
+    for (int i = 0; i < 3; i++)
+        winstat_restore(&w->axis[i], &s->axis[i]);
+    winstat_restore(&w->norm, &s->norm);
+    return;
+}
+
+void winstat3_push(winstat3_t *w, double x, double y, double z)
+{
+    winstat_push(&w->axis[0], x);
+    winstat_push(&w->axis[1], y);
+    winstat_push(&w->axis[2], z);
+    winstat_push(&w->norm, sqrt(x * x + y * y + z * z));
+    return;
+}
+
+void winstat3_print(FILE *fp, const char *name, const winstat3_t *w)
+{
+    const char *axes[4] = {"x", "y", "z", "|v|"};
+    fprintf(fp, "[STATS] %-6s %2d/%2d", name, winstat_count(&w->norm), w->norm.window);
+    for (int i = 0; i < 4; i++)
+    {
+        const winstat_t *a = i < 3 ? &w->axis[i] : &w->norm;
+        fprintf(fp, "  %s %.4g +/- %.3g [%.4g, %.4g]", axes[i], winstat_mean(a), sqrt(winstat_var(a)), winstat_min(a), winstat_max(a));
+    }
+    fprintf(fp, "\n");
+    return;
+}
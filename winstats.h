@@ -0,0 +1,236 @@
+/**
+ * @file winstats.h
+ * @brief Sliding-window statistics of the vector signals of the ACS (mean, variance, minimum and maximum over the
+ * last samples written into a circular buffer), updated in O(1) per sample: Welford updates with eviction for
+ * the moments, monotonic deques for the extrema.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef __WINSTATS_H
+#define __WINSTATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <bessel.h>
+#include <arena.h>
+
+/**
+ * @brief Statistics of a scalar over a window of at most the capacity given to winstat_alloc(). The window keeps
+ * its own copy of the samples, as the circular buffers are overwritten before the sample leaving the window can
+ * be read.
+ *
+ */
+typedef struct
+{
+    double *v;        // samples, sample i at i & mask, in an arena
+    uint32_t *min_q;  // deque of the samples that can still be the minimum, increasing values, in an arena
+    uint32_t *max_q;  // deque of the samples that can still be the maximum, decreasing values, in an arena
+    uint32_t mask;    // capacity of the arrays - 1
+    double mean;      // mean of the window
+    double m2;        // sum of the squared deviations from the mean
+    int min_head, min_len;
+    int max_head, max_len;
+    uint32_t seq;     // samples pushed
+    int window;       // length of the window
+} winstat_t;
+
+/**
+ * @brief Statistics of a vector signal: the three axes and the norm.
+ *
+ */
+typedef struct
+{
+    winstat_t axis[3];
+    winstat_t norm;
+} winstat3_t;
+
+/**
+ * @brief Copy of the statistics of a scalar, samples included, that does not point into an arena. Saved in the
+ * simulation checkpoints.
+ *
+ */
+typedef struct
+{
+    winstat_t w; // without the arrays
+    double v[SH_BUFFER_MAX];
+    uint32_t min_q[SH_BUFFER_MAX];
+    uint32_t max_q[SH_BUFFER_MAX];
+} winstat_save_t;
+
+/**
+ * @brief Copy of the statistics of a vector signal, see winstat_save_t.
+ *
+ */
+typedef struct
+{
+    winstat_save_t axis[3];
+    winstat_save_t norm;
+} winstat3_save_t;
+
+/**
+ * @brief Bytes the arrays of a window of the given capacity take in an arena, to size the arena.
+ *
+ */
+#define WINSTAT_ARENA_SIZE(capacity) \
+    (arena_round((size_t)(capacity) * sizeof(double)) + 2 * arena_round((size_t)(capacity) * sizeof(uint32_t)))
+
+/**
+ * @brief Bytes the arrays of the windows of a vector signal take in an arena, see WINSTAT_ARENA_SIZE().
+ *
+ */
+#define WINSTAT3_ARENA_SIZE(capacity) (4 * WINSTAT_ARENA_SIZE(capacity))
+
+/**
+ * @brief Carves the arrays of the statistics out of an arena and empties the window, at its full length.
+ *
+ * @param w Statistics
+ * @param a Arena
+ * @param capacity Longest window, a power of 2 up to SH_BUFFER_MAX
+ * @return int 1 on success, -1 if the arena is exhausted
+ */
+int winstat_alloc(winstat_t *w, arena_t *a, uint32_t capacity);
+
+/**
+ * @brief Empties the window and sets its length. Keeps the arrays.
+ *
+ * @param w Statistics
+ * @param window Length of the window, capped at the capacity given to winstat_alloc()
+ */
+void winstat_init(winstat_t *w, int window);
+
+/**
+ * @brief Adds a sample, the oldest leaves the window once the window is full. O(1), amortized: the moments are
+ * recomputed from the samples once every capacity samples, so that the rounding errors of the evictions do not
+ * accumulate. The statistics must have been given their arrays by winstat_alloc().
+ *
+ * @param w Statistics
+ * @param x Sample
+ */
+void winstat_push(winstat_t *w, double x);
+
+/**
+ * @brief Number of samples in the window.
+ *
+ */
+static inline int winstat_count(const winstat_t *w)
+{
+    return w->seq < (uint32_t)w->window ? (int)w->seq : w->window;
+}
+
+/**
+ * @brief Indicates that the window is full.
+ *
+ */
+static inline int winstat_full(const winstat_t *w)
+{
+    return w->seq >= (uint32_t)w->window;
+}
+
+/**
+ * @brief Mean of the window, 0 if empty.
+ *
+ */
+static inline double winstat_mean(const winstat_t *w)
+{
+    return w->mean;
+}
+
+/**
+ * @brief Variance of the window (population), 0 if empty.
+ *
+ */
+static inline double winstat_var(const winstat_t *w)
+{
+    int n = winstat_count(w);
+    return n > 0 && w->m2 > 0 ? w->m2 / n : 0;
+}
+
+/**
+ * @brief Minimum of the window, 0 if empty.
+ *
+ */
+static inline double winstat_min(const winstat_t *w)
+{
+    return w->min_len > 0 ? w->v[w->min_q[w->min_head] & w->mask] : 0;
+}
+
+/**
+ * @brief Maximum of the window, 0 if empty.
+ *
+ */
+static inline double winstat_max(const winstat_t *w)
+{
+    return w->max_len > 0 ? w->v[w->max_q[w->max_head] & w->mask] : 0;
+}
+
+/**
+ * @brief Carves the arrays of the windows of a vector signal out of an arena, see winstat_alloc().
+ *
+ */
+int winstat3_alloc(winstat3_t *w, arena_t *a, uint32_t capacity);
+
+/**
+ * @brief Empties the windows of a vector signal and sets their length.
+ *
+ */
+void winstat3_init(winstat3_t *w, int window);
+
+/**
+ * @brief Copies the statistics of a vector signal and the samples of their windows.
+ *
+ * @param s Copy
+ * @param w Statistics
+ */
+void winstat3_save(winstat3_save_t *s, const winstat3_t *w);
+
+/**
+ * @brief Restores the statistics of a vector signal from a copy saved at the same capacity, into the arrays
+ * they already have.
+ *
+ * @param w Statistics
+ * @param s Copy
+ */
+void winstat3_restore(winstat3_t *w, const winstat3_save_t *s);
+
+/**
+ * @brief Adds a vector sample to the statistics of the axes and of the norm.
+ *
+ * @param w Statistics
+ * @param x X component
+ * @param y Y component
+ * @param z Z component
+ */
+void winstat3_push(winstat3_t *w, double x, double y, double z);
+
+/**
+ * @brief Total variance of a vector signal, the trace of its covariance over the window.
+ *
+ */
+static inline double winstat3_var(const winstat3_t *w)
+{
+    return winstat_var(&w->axis[0]) + winstat_var(&w->axis[1]) + winstat_var(&w->axis[2]);
+}
+
+/**
+ * @brief Prints the statistics of a vector signal on one line: mean, standard deviation and range of each
+ * axis, and of the norm.
+ *
+ * @param fp Output
+ * @param name Name of the signal
+ * @param w Statistics
+ */
+void winstat3_print(FILE *fp, const char *name, const winstat3_t *w);
+
+/**
+ * @brief Adds the vector at the current index of a buffer declared using DECLARE_RING() to its statistics.
+ *
+ * @param w Statistics
+ * @param name Name of the buffer
+ * @param index Current index
+ */
+#define WINSTAT_BUFFER(w, name, index) winstat3_push(w, x_##name[index], y_##name[index], z_##name[index])
+
+#endif // __WINSTATS_H